@@ -79,6 +79,17 @@ public:
             return it->second;
     }
 
+    /**
+     * @brief Find type definition without throwing
+     * @param oid type OID
+     * @return pointer to definition, NULL if type is unknown
+     */
+    inline const TypeDefinition * find(int oid) const
+    {
+        const auto it = _data.find(oid);
+        return it != _data.end() ? &it->second : NULL;
+    }
+
     /**
      * @brief Get type definition for modification
      * @param oid type OID
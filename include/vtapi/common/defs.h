@@ -17,6 +17,10 @@
 namespace vtapi {
 
 extern const int def_select_limit;   // SELECT query limit
+extern const int def_select_stream_limit;   // rows fetched at once from streaming cursor
+extern const int def_insert_batch_limit;    // rows inserted by one multi-row INSERT
+extern const int def_output_async_pending;  // max. buffers pending in asynchronous interval output
+extern const int def_count_estimate_min;    // estimated counts are counted exactly up to this
 
 extern const std::string def_val_video;
 extern const std::string def_val_images;
@@ -29,6 +33,9 @@ extern const std::string def_fnc_mt_delete;
 extern const std::string def_fnc_task_create;
 extern const std::string def_fnc_task_delete;
 extern const std::string def_fnc_event_filter;
+extern const std::string def_fnc_event_stats;
+extern const std::string def_fnc_event_classes;
+extern const std::string def_fnc_event_versions;
 
 extern const std::string def_tab_datasets;
 extern const std::string def_tab_methods;
@@ -20,6 +20,26 @@
 
 namespace vtapi {
 
+/**
+ * @brief VTServer configuration (0 = use server default)
+ */
+class ServerConfig
+{
+public:
+    int             port;               /**< TCP port to listen on */
+    int             io_threads;         /**< ZeroMQ IO threads */
+    int             workers;            /**< Worker threads processing requests */
+    int             heavy_workers;      /**< Max. workers processing heavy requests at once */
+    int             connections;        /**< Pooled database connections */
+    int             queue_size;         /**< Max. requests waiting for worker */
+    int             cache_size;         /**< Response cache size in MB (negative = disabled) */
+    int             sequence_threads;   /**< Max. threads processing sequences of one request */
+    int             index_size;         /**< Spatial indexes memory in MB (negative = indexes are not kept) */
+    int             descindex_size;     /**< Descriptor indexes memory in MB (negative = indexes are not kept) */
+
+    ServerConfig() : port(0), io_threads(0), workers(0), heavy_workers(0), connections(0), queue_size(0), cache_size(0), sequence_threads(0), index_size(0), descindex_size(0) {}
+};
+
 /**
  * @brief Common base class to each %VTApi object
  *
@@ -71,6 +91,7 @@ protected:
         bool            log_messages;       /**< Enables logging info messages */
         bool            log_queries;        /**< Enables logging SQL queries */
         std::string     logfile;            /**< Path to log file (empty => stdout/stderr) */
+        ServerConfig    server;             /**< VTServer configuration */
 
         Config() : log_errors(false), log_warnings(false), log_messages(false), log_queries(false) {}
     };
@@ -146,6 +167,7 @@ private:
     Commons& operator=(const Commons&) = delete;
 
     friend class Query;
+    friend class QueryPipeline;
     friend class VTApi;
 };
 
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @brief   Declaration of EdfDescriptorIndex class
+ *
+ * @author   Vojtech Froml, xfroml00 (at) stud.fit.vutbr.cz
+ * @author   Tomas Volf, ivolf (at) fit.vutbr.cz
+ *
+ * @licence   @ref licence "BUT OPEN SOURCE LICENCE (Version 1)"
+ *
+ * @copyright   &copy; 2011 &ndash; 2018, Brno University of Technology
+ */
+
+#pragma once
+
+#include "eyedea_edfdescriptor.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace vtapi {
+
+
+/**
+ * @brief In-memory index of EDF descriptors for k nearest neighbours search
+ *
+ * Descriptors are byte vectors compared by squared euclidean distance.
+ * Only descriptors of the same version and size as the first added one
+ * are indexed. Descriptors are stored contiguously in inverted lists
+ * (IVF): until index is trained, there is one list searched by brute force;
+ * after training, descriptors are grouped to lists by nearest centroid
+ * (k-means) and search visits only lists nearest to query. Descriptors
+ * may be added to trained index, they are put to list of nearest centroid.
+ * Copies of index share lists, list is copied only when descriptor is
+ * added to it (copy-on-write), so updated copy may be made while index
+ * is searched.
+ *
+ * @author   Tomas Volf, ivolf (at) fit.vutbr.cz
+ *
+ * @licence   @ref licence "BUT OPEN SOURCE LICENCE (Version 1)"
+ *
+ * @copyright   &copy; 2011 &ndash; 2018, Brno University of Technology
+ */
+class EdfDescriptorIndex
+{
+public:
+    /**
+     * @brief Search result
+     */
+    class Neighbor
+    {
+    public:
+        int event_id;
+        unsigned int distance;      /**< squared euclidean distance */
+    };
+
+    EdfDescriptorIndex();
+
+    /**
+     * @brief Adds descriptor
+     * @param event_id event (interval) ID
+     * @param desc descriptor
+     * @return false if descriptor is empty or differs from indexed ones by version or size
+     */
+    bool add(int event_id, const EyedeaEdfDescriptor &desc);
+
+    /**
+     * @brief Adds descriptors of events added to other index after given one
+     * (other index is newer state of this one, this may be regrouped meanwhile)
+     * @param other other index
+     * @param event_id last event ID added to this index, events are added in order of IDs
+     */
+    void addFrom(const EdfDescriptorIndex &other, int event_id);
+
+    /**
+     * @brief Gets number of indexed descriptors
+     * @return descriptors count
+     */
+    size_t size() const
+    { return _size; }
+
+    /**
+     * @brief Gets version of indexed descriptors
+     * @return descriptor version
+     */
+    int version() const
+    { return _version; }
+
+    /**
+     * @brief Checks if descriptors are grouped to lists by training
+     * @return index is trained
+     */
+    bool trained() const
+    { return !_centroids.empty(); }
+
+    /**
+     * @brief Gets number of descriptors index was trained on
+     * @return descriptors count, 0 = not trained
+     */
+    size_t trainedSize() const
+    { return _trained_size; }
+
+    /**
+     * @brief Trains centroids of lists by k-means on sample of descriptors
+     * and regroups all descriptors to lists. Training is deterministic.
+     * @param lists number of lists (sqrt of size is good choice), less than 2 = untrained index
+     */
+    void train(size_t lists);
+
+    /**
+     * @brief Finds k descriptors nearest to given one
+     * @param desc query descriptor
+     * @param k number of neighbours
+     * @param probes lists searched by trained index, 0 = all (exact search)
+     * @return neighbours ordered by distance (and event ID),
+     * empty if query differs from indexed descriptors by version or size
+     */
+    std::vector<Neighbor> search(const EyedeaEdfDescriptor &desc, size_t k, size_t probes = 0) const;
+
+    /**
+     * @brief Gets approximate memory used by index
+     * @return bytes
+     */
+    size_t bytes() const;
+
+private:
+    class List
+    {
+    public:
+        std::vector<unsigned char> data;    // descriptors one after another
+        std::vector<int> event_ids;
+    };
+
+    int _version;
+    size_t _dim;                    // descriptor size, 0 = nothing added yet
+    size_t _size;
+    size_t _trained_size;
+    std::vector< std::shared_ptr<List> > _lists;    // one list until trained, shared by copies
+    std::vector<unsigned char> _centroids;  // lists x dim, rounded to bytes
+
+    size_t nearestList(const unsigned char *desc) const;
+    void addData(int event_id, const unsigned char *desc);
+};
+
+
+} // namespace vtapi
@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @brief   Declaration of EventBatch and EventBatchFilter classes
+ *
+ * @author   Vojtech Froml, xfroml00 (at) stud.fit.vutbr.cz
+ * @author   Tomas Volf, ivolf (at) fit.vutbr.cz
+ *
+ * @licence   @ref licence "BUT OPEN SOURCE LICENCE (Version 1)"
+ *
+ * @copyright   &copy; 2011 &ndash; 2015, Brno University of Technology
+ */
+
+#pragma once
+
+#include "intervalevent.h"
+#include "eventfilter.h"
+#include <vector>
+#include <chrono>
+#include <cstddef>
+
+namespace vtapi {
+
+
+/**
+ * @brief Batch of loaded events stored as struct of arrays
+ *
+ * Every event (row of task output) has the same index in all arrays.
+ * Event region is stored normalized (low <= high).
+ */
+class EventBatch
+{
+public:
+    std::vector<int> group_id;              /**< event group (trajectory) */
+    std::vector<unsigned char> is_root;     /**< 1 = meta-event (trajectory envelope) */
+    std::vector<unsigned int> t1;           /**< start frame */
+    std::vector<unsigned int> t2;           /**< end frame */
+    std::vector<double> sec_length;         /**< length in seconds */
+    std::vector<double> rt_start;           /**< real start time in seconds since epoch (UTC), NaN = unknown */
+    std::vector<double> x_low;              /**< region */
+    std::vector<double> y_low;
+    std::vector<double> x_high;
+    std::vector<double> y_high;
+
+    /**
+     * @brief Gets number of events
+     * @return events count
+     */
+    size_t size() const
+    { return group_id.size(); }
+
+    void reserve(size_t count);
+
+    void clear();
+
+    /**
+     * @brief Gets approximate memory used by batch
+     * @return bytes
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief Appends event
+     * @param t1 start frame
+     * @param t2 end frame
+     * @param sec_length length in seconds
+     * @param rt_start real start time (zero = unknown)
+     * @param event event
+     */
+    void add(unsigned int t1, unsigned int t2, double sec_length,
+             const std::chrono::system_clock::time_point &rt_start,
+             const IntervalEvent &event);
+};
+
+
+/**
+ * @brief EventFilter compiled for in-memory filtering of event batches
+ *
+ * Filter gives the same results as filtering in database (VT_filtered_events),
+ * so that already loaded events may be filtered again without database round trip.
+ * Only given conditions are evaluated, each of them by one branchless pass
+ * over batch arrays (vectorized by compiler).
+ */
+class EventBatchFilter
+{
+public:
+    /**
+     * @brief Compiles filter
+     * @param filter event filter
+     * @throws RuntimeException minimal duration or day time is greater than maximal
+     * (database refuses such filter too)
+     */
+    explicit EventBatchFilter(const EventFilter &filter);
+
+    /**
+     * @brief Checks if any condition is given
+     * @return true if filter accepts everything
+     */
+    bool empty() const
+    { return _conditions == 0; }
+
+    /**
+     * @brief Evaluates all conditions for every event
+     * @param batch events
+     * @param mask output mask, 1 = event satisfies conditions
+     */
+    void evaluate(const EventBatch &batch, std::vector<unsigned char> &mask) const;
+
+    /**
+     * @brief Gets groups (trajectories) satisfying filter: root event satisfies
+     * duration and time conditions and any event of group overlaps region
+     * @param batch events
+     * @return sorted group IDs
+     */
+    std::vector<int> matchingGroups(const EventBatch &batch) const;
+
+    /**
+     * @brief Selects events of groups satisfying filter (see matchingGroups),
+     * empty filter selects all events
+     * @param batch events
+     * @return indices of selected events in batch order
+     */
+    std::vector<size_t> select(const EventBatch &batch) const;
+
+private:
+    enum Condition
+    {
+        COND_DURATION = 0x1,
+        COND_TIMERANGE = 0x2,
+        COND_DAYTIME = 0x4,
+        COND_REGION = 0x8,
+        COND_TIME = COND_DURATION | COND_TIMERANGE | COND_DAYTIME
+    };
+
+    unsigned int _conditions;
+    double _duration_low, _duration_high;   // seconds
+    double _time_low, _time_high;           // seconds since epoch, [low, high)
+    double _daytime_low, _daytime_high;     // seconds since midnight, [low, high]
+    double _x_low, _y_low, _x_high, _y_high;
+
+    void evaluate(const EventBatch &batch, unsigned int conditions, std::vector<unsigned char> &mask) const;
+
+    EventBatchFilter() = delete;
+};
+
+
+} // namespace vtapi
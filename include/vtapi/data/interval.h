@@ -17,8 +17,10 @@
 #include "sequence.h"
 #include "task.h"
 #include "eventfilter.h"
+#include "eventbatch.h"
 #include "intervalevent.h"
 #include "eyedea_edfdescriptor.h"
+#include "edfdescriptorindex.h"
 
 namespace vtapi {
 
@@ -185,11 +187,37 @@ public:
 
     bool filterNotNullEdfDescriptor(const std::string &key);
 
+    /**
+     * Adds EDF descriptors of all intervals (satisfying filters) to index,
+     * intervals without descriptor are skipped. Call instead of next(),
+     * streaming mode is disabled afterwards.
+     * @param index descriptor index
+     * @return number of added descriptors
+     */
+    size_t loadEdfDescriptors(EdfDescriptorIndex &index);
+
+    /**
+     * Finds intervals (satisfying filters) with EDF descriptor most similar
+     * to given one by brute-force search, descriptors are read by pages and
+     * are not kept (for repeated searches load them to index).
+     * Call instead of next(), streaming mode is disabled afterwards.
+     * @param desc query descriptor
+     * @param k number of intervals
+     * @return interval IDs with distances, ordered by distance
+     */
+    std::vector<EdfDescriptorIndex::Neighbor> findSimilarEdfDescriptors(const EyedeaEdfDescriptor &desc, size_t k);
+
 protected:
     virtual bool preUpdate() override;
 
 private:
     std::shared_ptr<Video> _pparent_vid;
+    BoundKey _key_id;           /**< bound id column */
+    BoundKey _key_seqname;      /**< bound sequence name column */
+    BoundKey _key_t1;           /**< bound start time column */
+    BoundKey _key_t2;           /**< bound end time column */
+    BoundKey _key_seclength;    /**< bound length in seconds column */
+    bool _edfdesc_not_null;     /**< NOT NULL filter of EDF descriptor was added */
 
     Interval() = delete;
     Interval& operator=(const Interval&) = delete;
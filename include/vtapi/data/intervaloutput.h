@@ -3,8 +3,13 @@
 
 #include "../data/commons.h"
 #include "../queries/insert.h"
+#include <string>
+#include <vector>
 #include <list>
 #include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <opencv2/opencv.hpp>
 
 namespace vtapi {
@@ -19,11 +24,19 @@ public:
      * @param sequence for which sequence should intervals be created
      * @param output output table name
      * @param cache_limit maximum cached intervals before commit (0 = unlimited)
+     * @param async full cache is committed in background by writer thread
+     * with its own connection, errors are reported by next newInterval()/commit()
      */
     IntervalOutput(const Commons &commons,
                    const std::string &sequence,
                    const std::string &output,
-                   unsigned int cache_limit = 500);
+                   unsigned int cache_limit = 500,
+                   bool async = false);
+
+    /**
+     * @brief Destructor, waits for pending asynchronous commits
+     */
+    ~IntervalOutput();
 
     /**
      * @brief Creates new current interval into cache for later commit
@@ -35,6 +48,11 @@ public:
 
     /**
      * @brief Commits all cached intervals added with newInterval()
+     * @note Intervals are written by single bulk copy if backend supports it
+     * and values have the same types as columns, otherwise (or when copy fails)
+     * by multi-row INSERT queries for intervals with the same keys.
+     * All queries run in one transaction.
+     * In asynchronous mode waits until all pending intervals are written.
      * @return success
      */
     bool commit();
@@ -47,74 +65,122 @@ public:
      */
     bool discard(bool only_cached);
 
+    /**
+     * @brief Enables/disables bulk copy on commit (enabled by default)
+     * @note Use multi-row INSERTs instead if statement-level INSERT triggers must fire
+     * @param enable use bulk copy
+     */
+    void setCopy(bool enable);
+
     // value setters - call these after calling newInterval()
     // and before commit() to set interval parameters
 
     inline bool setBool(const std::string &key, bool value)
-    { last_insert().querybuilder().keyBool(key, value); }
+    { return last_insert().querybuilder().keyBool(key, value); }
 
     inline bool setChar(const std::string &key, char value)
-    { last_insert().querybuilder().keyChar(key,value); }
+    { return last_insert().querybuilder().keyChar(key,value); }
 
     inline bool setString(const std::string &key, const std::string &value)
-    { last_insert().querybuilder().keyString(key,value); }
+    { return last_insert().querybuilder().keyString(key,value); }
 
     inline bool setStringVector(const std::string &key, const std::vector<std::string> &values)
-    { last_insert().querybuilder().keyStringVector(key,values); }
+    { return last_insert().querybuilder().keyStringVector(key,values); }
 
     inline bool setInt(const std::string &key, int value)
-    { last_insert().querybuilder().keyInt(key,value); }
+    { return last_insert().querybuilder().keyInt(key,value); }
 
     inline bool setIntVector(const std::string &key, const std::vector<int> &values)
-    { last_insert().querybuilder().keyIntVector(key,values); }
+    { return last_insert().querybuilder().keyIntVector(key,values); }
 
     inline bool setInt8(const std::string &key, long long value)
-    { last_insert().querybuilder().keyInt8(key,value); }
+    { return last_insert().querybuilder().keyInt8(key,value); }
 
     inline bool setInt8Vector(const std::string &key, const std::vector<long long> &values)
-    { last_insert().querybuilder().keyInt8Vector(key,values); }
+    { return last_insert().querybuilder().keyInt8Vector(key,values); }
 
     inline bool setFloat(const std::string &key, float value)
-    { last_insert().querybuilder().keyFloat(key,value); }
+    { return last_insert().querybuilder().keyFloat(key,value); }
 
     inline bool setFloatVector(const std::string &key, const std::vector<float> &values)
-    { last_insert().querybuilder().keyFloatVector(key,values); }
+    { return last_insert().querybuilder().keyFloatVector(key,values); }
 
     inline bool setFloat8(const std::string &key, double value)
-    { last_insert().querybuilder().keyFloat8(key,value); }
+    { return last_insert().querybuilder().keyFloat8(key,value); }
 
     inline bool setFloat8Vector(const std::string &key, const std::vector<double> &values)
-    { last_insert().querybuilder().keyFloat8Vector(key,values); }
+    { return last_insert().querybuilder().keyFloat8Vector(key,values); }
 
     inline bool setTimestamp(const std::string &key, const std::chrono::system_clock::time_point &value)
-    { last_insert().querybuilder().keyTimestamp(key,value); }
+    { return last_insert().querybuilder().keyTimestamp(key,value); }
 
     inline bool setCvMat(const std::string &key, const cv::Mat &value)
-    { last_insert().querybuilder().keyCvMat(key,value); }
+    { return last_insert().querybuilder().keyCvMat(key,value); }
 
     inline bool setPoint(const std::string &key, Point value)
-    { last_insert().querybuilder().keyPoint(key,value); }
+    { return last_insert().querybuilder().keyPoint(key,value); }
 
     inline bool setPointVector(const std::string &key, const std::vector<Point> &values)
-    { last_insert().querybuilder().keyPointVector(key,values); }
+    { return last_insert().querybuilder().keyPointVector(key,values); }
 
     inline bool setIntervalEvent(const std::string &key, const IntervalEvent &value)
-    { last_insert().querybuilder().keyIntervalEvent(key,value); }
+    { return last_insert().querybuilder().keyIntervalEvent(key,value); }
 
     inline bool setEdfDescriptor(const std::string &key, const EyedeaEdfDescriptor &value)
-    { last_insert().querybuilder().keyEdfDescriptor(key, value); }
+    { return last_insert().querybuilder().keyEdfDescriptor(key, value); }
 
     inline bool setBlob(const std::string &key, const std::vector<char> &data)
-    { last_insert().querybuilder().keyBlob(key,data); }
+    { return last_insert().querybuilder().keyBlob(key,data); }
 
 private:
-    std::list< std::shared_ptr<Insert> > _inserts;
+    typedef std::list< std::shared_ptr<Insert> > InsertList;
+
+    // INSERT of consecutive intervals with the same keys
+    class InsertBatch
+    {
+    public:
+        std::string _query;     // query string
+        std::string _types;     // value types, empty = one interval with its own parameters
+        unsigned int _rows;     // number of intervals
+    };
+
+    // cached intervals with queries built by thread which created them (with
+    // its connection), writer thread only executes them with its own one
+    class IntervalWrite
+    {
+    public:
+        InsertList _inserts;
+        std::string _copy_query;            // bulk copy of all intervals, empty = not possible
+        std::vector<InsertBatch> _batches;  // INSERTs of all intervals in their order
+    };
+
+    InsertList _inserts;
     unsigned int _cache_limit;
+    bool _copy;
+
+    // asynchronous mode
+    std::unique_ptr<IntervalOutput> _writer;    /**< writer with own connection */
+    std::thread _writer_thread;
+    std::mutex _writer_mtx;
+    std::condition_variable _writer_cond;
+    std::list<IntervalWrite> _pending;          /**< buffers waiting for writer */
+    bool _writer_stop;
+    bool _writer_failed;
+
+    // creates writer for asynchronous mode (with its own connection)
+    IntervalOutput(const IntervalOutput &orig);
 
     Insert & last_insert();
+    IntervalWrite prepare(InsertList &inserts, bool copy);
+    bool flush(IntervalWrite &write);
+    bool flushCopy(IntervalWrite &write);
+    bool flushBatches(IntervalWrite &write);
+
+    bool enqueue();
+    bool waitWriter();
+    void writerLoop();
 
     IntervalOutput() = delete;
-    IntervalOutput(const IntervalOutput &) = delete;
     IntervalOutput & operator=(const IntervalOutput &) = delete;
 };
 
@@ -60,11 +60,38 @@ public:
      */
     virtual bool next();
 
+    /**
+     * Fetches next page of rows at once, for use with column getters
+     * (getIntColumn etc.) instead of per-row stepping via next()
+     * @return new non-empty page was fetched
+     */
+    bool nextPage();
+
+    /**
+     * @brief Counting modes
+     */
+    enum CountMode
+    {
+        COUNT_EXACT,        /**< exact count (scans all objects) */
+        COUNT_ESTIMATE      /**< planner estimate in constant time, small counts are exact */
+    };
+
     /**
      * Count total number of represented objects
+     * @param mode exact count or estimate
+     * @param estimated set to true if returned count is estimate
      * @return object count, -1 for error
      */
-    int count();
+    long long count(CountMode mode = COUNT_EXACT, bool *estimated = NULL);
+
+    /**
+     * Enables streaming of rows through server-side cursor
+     * Query is executed only once and rows are fetched in small chunks, so
+     * memory stays bounded even for huge result sets. Must be set before
+     * first call of next().
+     * @param enable enable/disable streaming
+     */
+    void setStreaming(bool enable);
 
     /**
      * Executes SQL UPDATE command
@@ -89,6 +116,15 @@ public:
     TKeys getKeys() const
     { return _select._presultset->getKeys(); }
 
+    /**
+     * Gets column index of bound key, key is resolved once per fetched result
+     * and the index can then be used with index getters on every row
+     * @param key   bound column key
+     * @return column index
+     */
+    int getKeyIndex(const BoundKey& key) const
+    { return _select._presultset->resolveKey(key); }
+
     /**
      * @brief Generic getter - fetches any value from resultset and returns it as string
      * @param key column key
@@ -443,6 +479,64 @@ public:
     inline std::vector<char> getBlob(int col) const
     { return _select._presultset->getBlob(col); }
 
+    // =============== COLUMN GETTERS (current page) ===============
+
+    /**
+     * Gets integer values of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<int> getIntColumn(const std::string& key) const
+    { return _select._presultset->getIntColumn(_select._presultset->getKeyIndex(key)); }
+
+    /**
+     * Gets long integer values of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<long long> getInt8Column(const std::string& key) const
+    { return _select._presultset->getInt8Column(_select._presultset->getKeyIndex(key)); }
+
+    /**
+     * Gets double values of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<double> getFloat8Column(const std::string& key) const
+    { return _select._presultset->getFloat8Column(_select._presultset->getKeyIndex(key)); }
+
+    /**
+     * Gets string values of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<std::string> getStringColumn(const std::string& key) const
+    { return _select._presultset->getStringColumn(_select._presultset->getKeyIndex(key)); }
+
+    /**
+     * Gets timestamps of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<std::chrono::system_clock::time_point> getTimestampColumn(const std::string& key) const
+    { return _select._presultset->getTimestampColumn(_select._presultset->getKeyIndex(key)); }
+
+    /**
+     * Gets interval events of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<IntervalEvent> getIntervalEventColumn(const std::string& key) const
+    { return _select._presultset->getIntervalEventColumn(_select._presultset->getKeyIndex(key)); }
+
+    /**
+     * Gets EDF descriptors of a column for all rows of the current page
+     * @param key   column key
+     * @return vector of values, one per row
+     */
+    inline std::vector<EyedeaEdfDescriptor> getEdfDescriptorColumn(const std::string& key) const
+    { return _select._presultset->getEdfDescriptorColumn(_select._presultset->getKeyIndex(key)); }
+
     // =============== SETTERS (Update) ===============
 
     /**
@@ -645,6 +739,8 @@ protected:
 private:
     std::shared_ptr<Update> _pupdate; /**< Update object to update new data */
 
+    long long countQuery(const std::string& query, bool estimate);
+
     KeyValues() = delete;
     KeyValues(const KeyValues& copy) = delete;
     KeyValues& operator=(const KeyValues&) = delete;
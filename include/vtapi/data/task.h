@@ -22,6 +22,7 @@
 #include "taskparams.h"
 #include "taskprogress.h"
 #include "intervaloutput.h"
+#include "../queries/predefined.h"
 
 namespace vtapi {
 
@@ -142,6 +143,39 @@ public:
      */
     Interval *loadOutputData(std::string outputDataTable) const;
 
+    /**
+     * Calculates statistics of output events per sequence in database
+     * (only aggregated values are transferred, not the events)
+     * @param key event key
+     * @param seqnames sequences to calculate statistics for (empty = all)
+     * @param filter event filter, NULL for no filter
+     * @param stats output statistics, one item per sequence
+     * @return success
+     */
+    bool getOutputStats(const std::string& key,
+                        const std::vector<std::string>& seqnames,
+                        const EventFilter *filter,
+                        std::vector<QueryEventsStats::Stats>& stats) const;
+
+    /**
+     * Sums occurrences of output classes in database
+     * @param seqnames sequences to sum occurrences over (empty = all)
+     * @param occurrences output class ID => summed occurrence
+     * @return success
+     */
+    bool getOutputClassOccurrences(const std::vector<std::string>& seqnames,
+                                   std::map<int,double>& occurrences) const;
+
+    /**
+     * Gets versions of output events per sequence (read from statistics
+     * maintained in database, so that kept events can be checked cheaply)
+     * @param seqnames sequences to get versions for (empty = all)
+     * @param versions output versions, one item per sequence
+     * @return success
+     */
+    bool getOutputVersions(const std::vector<std::string>& seqnames,
+                           std::vector<QueryEventsVersions::Version>& versions) const;
+
     /**
      * Loads method's processes for iteration
      * @param id   process ID (0 = all processes)
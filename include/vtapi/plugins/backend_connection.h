@@ -3,6 +3,8 @@
 #include "../common/dbtypes.h"
 #include "backend_resultset.h"
 #include <string>
+#include <vector>
+#include <utility>
 
 
 namespace vtapi {
@@ -35,6 +37,12 @@ public:
      */
     virtual bool isConnected() const = 0;
 
+    /**
+     * Checks if connection is inside explicit transaction block
+     * @return transaction is open (or failed and not ended yet)
+     */
+    virtual bool isInTransaction() const = 0;
+
     /**
      * Executes query without fetching any result set
      * @param query SQL query string
@@ -43,6 +51,16 @@ public:
      */
     virtual bool execute(const std::string& query, void *param) = 0;
 
+    /**
+     * Executes independent queries without waiting for each result (if
+     * supported by backend, sequentially otherwise), execution stops on error.
+     * Queries run in one transaction (current one, or one opened for them),
+     * so either all of them or none are committed.
+     * @param queries SQL query strings with query parameters
+     * @return success of all queries
+     */
+    virtual bool executePipeline(const std::vector< std::pair<std::string, void *> >& queries) = 0;
+
     /**
      * Executes query and fetc hes new result set
      * @param query SQl query string
@@ -52,6 +70,24 @@ public:
      */
     virtual int fetch(const std::string& query, void *param, ResultSet &resultSet) = 0;
 
+    /**
+     * Executes bulk copy of rows into table
+     * @param query copy query string (@see QueryBuilder::getCopyQuery)
+     * @param data rows data (@see QueryBuilder::appendCopyRow)
+     * @return success
+     */
+    virtual bool copyFrom(const std::string& query, const std::string& data) = 0;
+
+    /**
+     * Executes query with values given as bulk copy rows data
+     * @param query query string (@see QueryBuilder::getInsertBatchQuery)
+     * @param types types of values in one row (@see QueryBuilder::getCopyTypes)
+     * @param data rows data (@see QueryBuilder::appendCopyRow)
+     * @return success
+     */
+    virtual bool executeBatch(const std::string& query, const std::string& types,
+                              const std::string& data) = 0;
+
 
     // ////////////////////////////////////////////////////////////////////////
     // IMPLEMENTED METHODS
@@ -63,7 +99,8 @@ public:
      * @param connectionInfo initial connection string @see vtapi.conf
      */
     explicit Connection(const std::string& connection_info)
-        : _connection_info(connection_info), _conn(NULL) {}
+        : _connection_info(connection_info), _conn(NULL),
+          _stmt_cache_hits(0), _stmt_cache_misses(0), _transaction_serial(0) {}
 
     virtual ~Connection() {}
 
@@ -95,11 +132,43 @@ public:
     inline const std::string getErrorMessage() const
     { return this->_error_message; }
 
+    /**
+     * Gets number of queries executed as already prepared statements
+     * @return prepared statement cache hits
+     */
+    inline unsigned long long getStatementCacheHits() const
+    { return this->_stmt_cache_hits; }
+
+    /**
+     * Gets number of parametrized queries not found in prepared statement cache
+     * @return prepared statement cache misses
+     */
+    inline unsigned long long getStatementCacheMisses() const
+    { return this->_stmt_cache_misses; }
+
+    /**
+     * Gets serial number of transaction block, it changes whenever a query
+     * ends outside of transaction block (it stays the same only while one
+     * transaction block is open)
+     * @return transaction serial
+     */
+    inline unsigned long long getTransactionSerial() const
+    { return this->_transaction_serial; }
+
 protected:
     void *_conn;                    /**< connection object */
     std::string _connection_info;   /**< connection string to access the database */
     std::string _error_message;     /**< error message string */
     DatabaseTypes _dbtypes;         /**< map of database types definitions */
+    unsigned long long _stmt_cache_hits;    /**< prepared statement cache hits */
+    unsigned long long _stmt_cache_misses;  /**< prepared statement cache misses */
+    unsigned long long _transaction_serial; /**< queries ended outside of transaction block */
+
+    /**
+     * Updates transaction serial after query was executed
+     */
+    inline void updateTransactionSerial()
+    { if (!isInTransaction()) this->_transaction_serial++; }
 
 private:
     Connection() = delete;
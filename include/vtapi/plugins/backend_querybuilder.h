@@ -58,6 +58,15 @@ public:
      */
     virtual void *duplicateQueryParam(void *param) const = 0;
 
+    /**
+     * @brief Duplicates query param and appends key values of the last fetched
+     * row, for query built by getSelectSeekQuery with seek types
+     * @note should be destroyed with destroyQueryParam()
+     * @param seekvalues key values of the last fetched row
+     * @return new query param object
+     */
+    virtual void *createSeekQueryParam(const std::vector<std::string>& seekvalues) const = 0;
+
     // ////////////////////////////////////////////////////////////////////////
     // query builder methods
     // ////////////////////////////////////////////////////////////////////////
@@ -82,6 +91,26 @@ public:
         int limit,
         int offset) const = 0;
 
+    /**
+     * @brief Builds SELECT query string for keyset (seek) pagination
+     *
+     * Result is ordered by seek keys and only rows following the last seen
+     * key values are selected, so every page costs the same regardless of
+     * how deep the scan is (unlike OFFSET). Key values of the last seen row
+     * are query parameters (see createSeekQueryParam), so query string is
+     * the same for all pages but the first.
+     * @param groupby GROUP BY argument
+     * @param seekkeys ordering keys (must be unique together and selected)
+     * @param seektypes types of seek keys, empty = first page
+     * @param limit LIMIT argument, 0 = no limit
+     * @return query string, empty on error
+     */
+    virtual std::string getSelectSeekQuery(
+        const std::string& groupby,
+        const std::vector<std::string>& seekkeys,
+        const std::vector<std::string>& seektypes,
+        int limit) const = 0;
+
     /**
      * @brief Builds INSERT query string
      * @return query string, empty on error
@@ -106,6 +135,20 @@ public:
      */
     virtual std::string getCountQuery() const = 0;
 
+    /**
+     * Builds SELECT COUNT(*) query which stops counting at limit
+     * @param limit maximum count
+     * @return query string, empty on error
+     */
+    virtual std::string getCountLimitQuery(int limit) const = 0;
+
+    /**
+     * Builds query to get planner's estimate of row count (without executing
+     * SELECT), first row of result contains top plan node with "rows=N"
+     * @return query string, empty on error
+     */
+    virtual std::string getCountEstimateQuery() const = 0;
+
     /**
      * Builds BEGIN TRANSACTION query
      * @return query string, empty on error
@@ -124,6 +167,32 @@ public:
      */
     virtual std::string getRollbackQuery() const = 0;
 
+    /**
+     * Builds query declaring server-side cursor over given query,
+     * cursor must be declared inside transaction and lives until its end
+     * @param name cursor name
+     * @param query query to iterate over (its parameters are used with it)
+     * @return query string, empty on error
+     */
+    virtual std::string getDeclareCursorQuery(const std::string& name,
+                                              const std::string& query) const = 0;
+
+    /**
+     * Builds query fetching next rows from server-side cursor
+     * @param name cursor name
+     * @param count maximum number of rows to fetch
+     * @return query string, empty on error
+     */
+    virtual std::string getFetchCursorQuery(const std::string& name,
+                                            int count) const = 0;
+
+    /**
+     * Builds query closing server-side cursor
+     * @param name cursor name
+     * @return query string, empty on error
+     */
+    virtual std::string getCloseCursorQuery(const std::string& name) const = 0;
+
     /**
      * @brief Builds query to create new dataset
      * @param name dataset name
@@ -197,12 +266,92 @@ public:
     virtual std::string getTaskDeleteQuery(const std::string& dsname,
                                            const std::string& taskname) const = 0;
 
+    /**
+     * @brief Builds query to get events statistics of task output per sequence
+     * (sequence name, length, covered frames, root events count, all events count)
+     * @param table task output table
+     * @param key event key
+     * @param taskname task name
+     * @param seqnames sequences to get statistics for (empty = all)
+     * @param filter event filter, NULL for no filter
+     * @return query string, empty on error
+     */
+    virtual std::string getEventsStatsQuery(const std::string& table,
+                                           const std::string& key,
+                                           const std::string& taskname,
+                                           const std::vector<std::string>& seqnames,
+                                           const EventFilter *filter) const = 0;
+
+    /**
+     * @brief Builds query to get summed class occurrences of task output
+     * (class ID, occurrence)
+     * @param table task output table
+     * @param taskname task name
+     * @param seqnames sequences to sum occurrences over (empty = all)
+     * @return query string, empty on error
+     */
+    virtual std::string getClassOccurrencesQuery(const std::string& table,
+                                                const std::string& taskname,
+                                                const std::vector<std::string>& seqnames) const = 0;
+
+    /**
+     * @brief Builds query to get versions of task output per sequence
+     * (sequence name, last change, last update or delete, all events count)
+     * @param table task output table
+     * @param taskname task name
+     * @param seqnames sequences to get versions for (empty = all)
+     * @return query string, empty on error
+     */
+    virtual std::string getEventsVersionsQuery(const std::string& table,
+                                              const std::string& taskname,
+                                              const std::vector<std::string>& seqnames) const = 0;
+
     /**
      * @brief Builds query to get last inserted ID
      * @return query string, empty on error
      */
     virtual std::string getLastInsertedIdQuery() const = 0;
 
+    // ////////////////////////////////////////////////////////////////////////
+    // bulk copy (for INSERT)
+    // ////////////////////////////////////////////////////////////////////////
+
+    /**
+     * @brief Enables capturing of key values for bulk copy
+     * @note Must be enabled before keys are set.
+     * @param enable capture key values
+     */
+    virtual void setCopyCapture(bool enable) = 0;
+
+    /**
+     * @brief Builds bulk copy query for captured keys (alternative to INSERT)
+     * @note Values are copied in format of their types, so their types must
+     * match column types (cached per table by connection).
+     * @return query string, empty if keys cannot be copied
+     */
+    virtual std::string getCopyQuery() const = 0;
+
+    /**
+     * @brief Appends captured key values as one row of bulk copy data
+     * @param data copy data buffer
+     * @return success
+     */
+    virtual bool appendCopyRow(std::string& data) const = 0;
+
+    /**
+     * @brief Builds multi-row INSERT query for captured keys
+     * @note Values are passed as bulk copy rows data (@see appendCopyRow)
+     * @param rows number of inserted rows
+     * @return query string, empty if keys cannot be batched
+     */
+    virtual std::string getInsertBatchQuery(unsigned int rows) const = 0;
+
+    /**
+     * @brief Gets type specifiers of captured key values (of one row)
+     * @return type specifiers (space separated), empty if values aren't captured
+     */
+    virtual std::string getCopyTypes() const = 0;
+
 
     // ////////////////////////////////////////////////////////////////////////
     // setting query table (for SELECT or DELETE)
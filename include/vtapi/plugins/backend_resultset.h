@@ -7,12 +7,45 @@
 #include "../data/eyedea_edfdescriptor.h"
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <chrono>
 #include <opencv2/opencv.hpp>
 
 namespace vtapi {
 
 
+/**
+ * @brief Column key bound to its index within a result set
+ *
+ * Key is resolved only once per fetched result (see ResultSet::resolveKey),
+ * so per-row access does not search for the column again.
+ * @note One bound key should be used with one result set only.
+ */
+class BoundKey
+{
+public:
+    /**
+     * Constructor
+     * @param key column key to bind
+     */
+    explicit BoundKey(const std::string& key)
+        : _key(key), _col(-1), _generation(0) {}
+
+    /**
+     * @brief Bound key accessor
+     * @return column key
+     */
+    const std::string& key() const
+    { return _key; }
+
+private:
+    std::string _key;                   /**< column key */
+    mutable int _col;                   /**< resolved column index */
+    mutable unsigned int _generation;   /**< result generation of resolved index */
+
+    friend class ResultSet;
+};
+
 /**
  * @brief Class provides interface to the result set object
  *
@@ -239,7 +272,7 @@ public:
      * @param dbtypes preloaded map of database types
      */
     explicit ResultSet(const DatabaseTypes &dbtypes)
-        : _dbtypes(dbtypes), _pos(-1), _res(NULL) {}
+        : _dbtypes(dbtypes), _pos(-1), _res(NULL), _generation(0) {}
 
     virtual ~ResultSet() {}
 
@@ -263,6 +296,20 @@ public:
     inline void incPosition()
     { _pos++; }
 
+    /**
+     * Gets column index of bound key, key is resolved only once per result
+     * @param key bound column key
+     * @return column index
+     */
+    inline int resolveKey(const BoundKey& key) const
+    {
+        if (key._generation != _generation) {
+            key._col = this->getKeyIndex(key._key);
+            key._generation = _generation;
+        }
+        return key._col;
+    }
+
     // =============== GETTERS by key ===============
 
     /**
@@ -433,10 +480,96 @@ public:
     inline std::vector<char> getBlob(const std::string &key)
     { return this->getBlob(this->getKeyIndex(key)); }
 
+    // =============== COLUMN GETTERS (whole result set) ===============
+
+    /**
+     * Gets integer values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<int> getIntColumn(int col)
+    { return getColumn<int>([this, col]() { return this->getInt(col); }); }
+
+    /**
+     * Gets long integer values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<long long> getInt8Column(int col)
+    { return getColumn<long long>([this, col]() { return this->getInt8(col); }); }
+
+    /**
+     * Gets double values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<double> getFloat8Column(int col)
+    { return getColumn<double>([this, col]() { return this->getFloat8(col); }); }
+
+    /**
+     * Gets string values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<std::string> getStringColumn(int col)
+    { return getColumn<std::string>([this, col]() { return this->getString(col); }); }
+
+    /**
+     * Gets timestamps of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<std::chrono::system_clock::time_point> getTimestampColumn(int col)
+    { return getColumn<std::chrono::system_clock::time_point>([this, col]() { return this->getTimestamp(col); }); }
+
+    /**
+     * Gets interval events of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<IntervalEvent> getIntervalEventColumn(int col)
+    { return getColumn<IntervalEvent>([this, col]() { return this->getIntervalEvent(col); }); }
+
+    /**
+     * Gets EDF descriptors of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    virtual std::vector<EyedeaEdfDescriptor> getEdfDescriptorColumn(int col)
+    { return getColumn<EyedeaEdfDescriptor>([this, col]() { return this->getEdfDescriptor(col); }); }
+
 protected:
     const DatabaseTypes &_dbtypes;  /**< map of database types definitions */
     int _pos;                       /**< position within resultset */
     void *_res;                     /**< result object */
+    std::unordered_map<std::string,int> _keyindex;  /**< column key -> index map of current result */
+    unsigned int _generation;       /**< incremented with every new result */
+
+    /**
+     * Reads values of all rows by given getter, keeps row position
+     * @param getter functor reading value at current position
+     * @return vector of values, one per row
+     */
+    template<typename T, typename F>
+    std::vector<T> getColumn(F getter)
+    {
+        std::vector<T> values;
+        int rows = countRows();
+        int pos = _pos;
+
+        values.reserve(rows);
+        try {
+            for (_pos = 0; _pos < rows; _pos++)
+                values.push_back(getter());
+        }
+        catch (...) {
+            _pos = pos;
+            throw;
+        }
+        _pos = pos;
+
+        return values;
+    }
 
 private:
     ResultSet() = delete;
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief   Declaration of QueryPipeline class
+ *
+ * @licence   @ref licence "BUT OPEN SOURCE LICENCE (Version 1)"
+ *
+ * @copyright   &copy; 2011 &ndash; 2015, Brno University of Technology
+ */
+
+#pragma once
+
+#include "query.h"
+#include <vector>
+#include <utility>
+
+namespace vtapi {
+
+
+/**
+ * @brief Class for executing independent queries at once
+ *
+ * Queries are sent to database without waiting for result of each one,
+ * which hides round-trip latency (if supported by backend). Results of
+ * queries are not available, use it for INSERT/UPDATE/DELETE.
+ *
+ * @licence   @ref licence "BUT OPEN SOURCE LICENCE (Version 1)"
+ *
+ * @copyright   &copy; 2011 &ndash; 2015, Brno University of Technology
+ */
+class QueryPipeline
+{
+public:
+    /**
+     * Constructor of an empty pipeline
+     * @param commons configuration object of Commons class
+     */
+    explicit QueryPipeline(const Commons& commons)
+        : _connection(const_cast<Commons&>(commons).connection()) {}
+
+    /**
+     * @brief Adds query to pipeline
+     * @note query must exist until execute() is called
+     * @param query query to execute
+     */
+    void add(Query &query)
+    { _queries.push_back(&query); }
+
+    /**
+     * @brief Gets number of queries in pipeline
+     * @return number of queries
+     */
+    size_t size() const
+    { return _queries.size(); }
+
+    /**
+     * @brief Executes all queries in pipeline, stops on first error
+     * @return success of all queries
+     */
+    bool execute()
+    {
+        std::vector< std::pair<std::string, void *> > queries;
+        queries.reserve(_queries.size());
+        for (Query *query : _queries)
+            queries.push_back(std::make_pair(query->getQuery(), query->querybuilder().getQueryParam()));
+
+        return _connection.executePipeline(queries);
+    }
+
+    /**
+     * @brief Removes all queries from pipeline
+     */
+    void clear()
+    { _queries.clear(); }
+
+private:
+    Connection &_connection;        /**< shared connection to backend */
+    std::vector<Query *> _queries;  /**< queued queries */
+
+    QueryPipeline() = delete;
+    QueryPipeline(const QueryPipeline&) = delete;
+    QueryPipeline& operator=(const QueryPipeline&) = delete;
+};
+
+} // namespace vtapi
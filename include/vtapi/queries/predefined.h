@@ -15,6 +15,7 @@
 #include "query.h"
 #include "../data/taskkeys.h"
 #include "../data/taskparams.h"
+#include <map>
 
 namespace vtapi {
 
@@ -156,6 +157,159 @@ public:
     }
 };
 
+class QueryEventsStats : public QueryPredefined
+{
+public:
+    /**
+     * @brief Statistics of one sequence
+     */
+    class Stats
+    {
+    public:
+        std::string seqname;    /**< sequence name */
+        int length;             /**< sequence length (frames) */
+        long long covered;      /**< frames covered by events */
+        long long count_root;   /**< number of root events */
+        long long count_all;    /**< number of all events */
+    };
+
+    QueryEventsStats(const Commons& commons,
+                     const std::string& table,
+                     const std::string& key,
+                     const std::string& taskname,
+                     const std::vector<std::string>& seqnames,
+                     const EventFilter *filter)
+        : QueryPredefined(commons)
+    {
+        _pquerybuilder->useQueryString(_pquerybuilder->getEventsStatsQuery(table, key,
+                                                                           taskname, seqnames,
+                                                                           filter));
+    }
+
+    bool execute() override
+    {
+        _stats.clear();
+
+        int retval = _connection.fetch(_pquerybuilder->getGenericQuery(),
+                                       _pquerybuilder->getQueryParam(),
+                                       *_presultset);
+        if (retval < 0)
+            return false;
+
+        _stats.resize(retval);
+        for (int i = 0; i < retval; i++) {
+            resultset().setPosition(i);
+            _stats[i].seqname = resultset().getString(0);
+            _stats[i].length = resultset().getInt(1);
+            _stats[i].covered = resultset().getInt8(2);
+            _stats[i].count_root = resultset().getInt8(3);
+            _stats[i].count_all = resultset().getInt8(4);
+        }
+
+        return true;
+    }
+
+    const std::vector<Stats> & getStats() const
+    { return _stats; }
+
+private:
+    std::vector<Stats> _stats;
+};
+
+class QueryClassOccurrences : public QueryPredefined
+{
+public:
+    QueryClassOccurrences(const Commons& commons,
+                          const std::string& table,
+                          const std::string& taskname,
+                          const std::vector<std::string>& seqnames)
+        : QueryPredefined(commons)
+    {
+        _pquerybuilder->useQueryString(_pquerybuilder->getClassOccurrencesQuery(table,
+                                                                                taskname,
+                                                                                seqnames));
+    }
+
+    bool execute() override
+    {
+        _occurrences.clear();
+
+        int retval = _connection.fetch(_pquerybuilder->getGenericQuery(),
+                                       _pquerybuilder->getQueryParam(),
+                                       *_presultset);
+        if (retval < 0)
+            return false;
+
+        for (int i = 0; i < retval; i++) {
+            resultset().setPosition(i);
+            _occurrences[resultset().getInt(0)] = resultset().getFloat8(1);
+        }
+
+        return true;
+    }
+
+    const std::map<int,double> & getOccurrences() const
+    { return _occurrences; }
+
+private:
+    std::map<int,double> _occurrences;
+};
+
+class QueryEventsVersions : public QueryPredefined
+{
+public:
+    /**
+     * @brief Version of events of one sequence
+     */
+    class Version
+    {
+    public:
+        std::string seqname;    /**< sequence name */
+        long long modified;     /**< transaction of last change, 0 = none, -1 = unknown */
+        long long changed;      /**< transaction of last update or delete, 0 = none, -1 = unknown */
+        long long count_all;    /**< number of all events, -1 = unknown */
+    };
+
+    QueryEventsVersions(const Commons& commons,
+                        const std::string& table,
+                        const std::string& taskname,
+                        const std::vector<std::string>& seqnames)
+        : QueryPredefined(commons)
+    {
+        _pquerybuilder->useQueryString(_pquerybuilder->getEventsVersionsQuery(table,
+                                                                              taskname,
+                                                                              seqnames));
+    }
+
+    bool execute() override
+    {
+        _versions.clear();
+
+        int retval = _connection.fetch(_pquerybuilder->getGenericQuery(),
+                                       _pquerybuilder->getQueryParam(),
+                                       *_presultset);
+        if (retval < 0)
+            return false;
+
+        _versions.resize(retval);
+        for (int i = 0; i < retval; i++) {
+            resultset().setPosition(i);
+            _versions[i].seqname = resultset().getString(0);
+            _versions[i].modified = resultset().getInt8(1);
+            _versions[i].changed = resultset().getInt8(2);
+            _versions[i].count_all = resultset().getInt8(3);
+        }
+
+        return true;
+    }
+
+    const std::vector<Version> & getVersions() const
+    { return _versions; }
+
+private:
+    std::vector<Version> _versions;
+};
+
 class QueryLastInsertedId : public QueryPredefined
 {
 public:
@@ -13,6 +13,9 @@
 #pragma once
 
 #include "query.h"
+#include <algorithm>
+#include <vector>
+#include <cstdint>
 
 namespace vtapi {
 
@@ -38,29 +41,121 @@ public:
      * @param commons configuration object of Commons class
      */
     Select(const Commons& commons, const std::string &table)
-        : Query(commons, table, true), _limit(0), _offset(0) {}
+        : Query(commons, table, true), _limit(0), _offset(0), _streaming(false),
+        _cursor_serial(0), _cursor_done(false), _own_transaction(false) {}
+
+    Select(Select &&other)
+        : Query(std::move(other)), _limit(other._limit), _offset(other._offset),
+        _orderby(std::move(other._orderby)), _groupby(std::move(other._groupby)),
+        _seekkeys(std::move(other._seekkeys)), _seektypes(std::move(other._seektypes)),
+        _seekvalues(std::move(other._seekvalues)),
+        _streaming(other._streaming), _cursor(std::move(other._cursor)),
+        _cursor_serial(other._cursor_serial), _cursor_done(other._cursor_done),
+        _own_transaction(other._own_transaction)
+    { other._cursor.clear(); other._own_transaction = false; }
+
+    /**
+     * Closes server-side cursor, if there is any open (and commits
+     * transaction opened for it)
+     */
+    ~Select()
+    { closeCursor(); }
 
     /**
      * Gets SELECT query string
      * @return query string
      */
     std::string getQuery() const override
-    { return _pquerybuilder->getSelectQuery(_groupby, _orderby, _limit, _offset); }
+    {
+        // whole result set is streamed through cursor, no paging
+        if (_streaming) {
+            if (_seekkeys.empty())
+                return _pquerybuilder->getSelectQuery(_groupby, _orderby, 0, 0);
+            else
+                return _pquerybuilder->getSelectSeekQuery(_groupby, _seekkeys, std::vector<std::string>(), 0);
+        }
+        else if (_seekkeys.empty()) {
+            return _pquerybuilder->getSelectQuery(_groupby, _orderby, _limit, _offset);
+        }
+        else {
+            return _pquerybuilder->getSelectSeekQuery(_groupby, _seekkeys, _seektypes, _limit);
+        }
+    }
     
     /**
      * Executes SELECT query and fetches result
+     * In streaming mode, server-side cursor is (re)opened and first rows are fetched.
+     * Cursor is declared in current transaction, or in transaction opened for it
+     * and held until the cursor is closed (other queries on the same connection
+     * are executed in it meanwhile). Cursor is closed after its last rows
+     * are fetched.
      * @return success
      */
     bool execute() override
-    { return _connection.fetch(this->getQuery(), _pquerybuilder->getQueryParam(), resultset()) >= 0; }
+    {
+        if (_streaming) {
+            closeCursor();
+            _cursor_done = false;
+            if (!_connection.isInTransaction()) {
+                if (!_connection.execute(_pquerybuilder->getBeginQuery(), NULL))
+                    return false;
+                _own_transaction = true;
+            }
+            _cursor_serial = _connection.getTransactionSerial();
+            std::string cursor = "vtapi_cursor_" + toString(reinterpret_cast<std::uintptr_t>(this));
+            if (!_connection.execute(_pquerybuilder->getDeclareCursorQuery(cursor, this->getQuery()),
+                                     _pquerybuilder->getQueryParam())) {
+                endTransaction(false);
+                return false;
+            }
+            _cursor = cursor;
+            return fetchCursor();
+        }
+        else if (_seekvalues.empty()) {
+            return _connection.fetch(this->getQuery(), _pquerybuilder->getQueryParam(), resultset()) >= 0;
+        }
+        else {
+            // last key values are bound, query string is the same for next pages
+            void *param = _pquerybuilder->createSeekQueryParam(_seekvalues);
+            if (!param)
+                return false;
+            bool ret = _connection.fetch(this->getQuery(), param, resultset()) >= 0;
+            _pquerybuilder->destroyQueryParam(param);
+            return ret;
+        }
+    }
     
     /**
-     * Shifts offset, executes SELECT query and fetches result
-     * @return success
+     * Shifts offset (or seeks past the last fetched row in keyset mode),
+     * executes SELECT query and fetches result
+     * In streaming mode, next rows are fetched from open cursor.
+     * @return success, false after the last rows were fetched in streaming mode
      */
     bool executeNext()
     {
-        _offset += _limit;
+        if (_streaming) {
+            if (_cursor_done)
+                return false;
+            return _cursor.empty() ? this->execute() : fetchCursor();
+        }
+        else if (_seekkeys.empty()) {
+            _offset += _limit;
+        }
+        else {
+            int rows = resultset().countRows();
+            if (rows <= 0)
+                return false;
+
+            // remember ordering key of the last row of current page
+            resultset().setPosition(rows - 1);
+            _seektypes.clear();
+            _seekvalues.clear();
+            for (const auto & key : _seekkeys) {
+                _seektypes.push_back(resultset().getKeyType(resultset().getKeyIndex(key)));
+                _seekvalues.push_back(resultset().getValue(key));
+            }
+        }
+
         return this->execute();
     }
     
@@ -80,6 +175,13 @@ public:
      */
     void setLimit(int limit)
     { _limit = limit; }
+
+    /**
+     * Gets number of rows fetched at once (LIMIT or cursor FETCH count)
+     * @return number of rows, 0 = no limit
+     */
+    int getLimit() const
+    { return _limit; }
     
     /**
      * Order result set by key (possibly including ASC/DESC)
@@ -95,11 +197,101 @@ public:
     void setGroupBy(const std::string& key)
     { _groupby = key; }
 
+    /**
+     * Enables keyset (seek) pagination, result set is then ordered by these
+     * keys and next pages are selected by WHERE (keys) > (last values)
+     * instead of OFFSET. Keys must be unique together, NOT NULL and part of
+     * the selected columns (integer or string columns are recommended).
+     * @param keys ordering keys, empty vector disables keyset pagination
+     */
+    void setKeyset(const std::vector<std::string>& keys)
+    {
+        _seekkeys = keys;
+        _seektypes.clear();
+        _seekvalues.clear();
+    }
+
+    /**
+     * Enables streaming mode, the query is then executed only once through
+     * a server-side cursor and rows are fetched in chunks of LIMIT size.
+     * Client memory is bounded by the chunk size, not by the result set size.
+     * @param enable enable/disable streaming
+     */
+    void setStreaming(bool enable)
+    {
+        if (!enable) closeCursor();
+        _streaming = enable;
+    }
+
 private:
     int _limit;             /**< LIMIT value */
     int _offset;            /**< OFFSET value */
     std::string _orderby;   /**< ORDER BY value  */
     std::string _groupby;   /**< GROUP BY value */
+    std::vector<std::string> _seekkeys;     /**< keyset pagination keys */
+    std::vector<std::string> _seektypes;    /**< keyset key types */
+    std::vector<std::string> _seekvalues;   /**< keyset values of the last fetched row */
+    bool _streaming;        /**< rows are streamed through server-side cursor */
+    std::string _cursor;    /**< name of open server-side cursor */
+    unsigned long long _cursor_serial;  /**< transaction serial of cursor's transaction */
+    bool _cursor_done;      /**< last rows were fetched from cursor */
+    bool _own_transaction;  /**< transaction was opened for cursor */
+    
+    /**
+     * Fetches next chunk of rows from open cursor, cursor is closed when
+     * it returns less rows than requested (or fails)
+     * @return success
+     */
+    bool fetchCursor()
+    {
+        int rows = _connection.fetch(_pquerybuilder->getFetchCursorQuery(_cursor, _limit),
+                                     NULL, resultset());
+        if (rows < 0 || rows < std::max(_limit, 1)) {
+            _cursor_done = rows >= 0;
+            closeCursor();
+        }
+
+        return rows >= 0;
+    }
+
+    /**
+     * Checks if cursor's transaction is still open, it may have been ended
+     * by other query on the same connection (cursor is gone then)
+     * @return cursor's transaction is current one
+     */
+    bool isCursorTransaction() const
+    {
+        return _connection.isConnected() && _connection.isInTransaction() &&
+               _connection.getTransactionSerial() == _cursor_serial;
+    }
+
+    /**
+     * Closes open server-side cursor
+     */
+    void closeCursor()
+    {
+        if (!_cursor.empty()) {
+            bool closed = isCursorTransaction() &&
+                _connection.execute(_pquerybuilder->getCloseCursorQuery(_cursor), NULL);
+            _cursor.clear();
+            endTransaction(closed);
+        }
+    }
+
+    /**
+     * Ends transaction opened for cursor, if there is any and it wasn't
+     * ended already (transaction opened later by someone else is left alone)
+     * @param commit commit it, rollback otherwise
+     */
+    void endTransaction(bool commit)
+    {
+        if (_own_transaction) {
+            if (isCursorTransaction())
+                _connection.execute(commit ?
+                    _pquerybuilder->getCommitQuery() : _pquerybuilder->getRollbackQuery(), NULL);
+            _own_transaction = false;
+        }
+    }
     
     Select() = delete;
 };
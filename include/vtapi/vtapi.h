@@ -156,6 +156,19 @@ public:
      */
     Process *getRunnableProcess() const;
 
+    /**
+     * @brief Checks database connection, reconnects if it was lost
+     * @param reconnect try to reconnect when connection is lost
+     * @return true if connection is usable
+     */
+    bool checkConnection(bool reconnect = true) const;
+
+    /**
+     * @brief Gets VTServer configuration
+     * @return server options, unset values are 0
+     */
+    const ServerConfig& getServerConfig() const;
+
 private:
     std::shared_ptr<Commons> _pcommons; /**< Commons are common objects to all vtapi objects */
 
@@ -82,12 +82,18 @@ DROP FUNCTION IF EXISTS public.VT_method_delete(VARCHAR, BOOLEAN) CASCADE;
 DROP FUNCTION IF EXISTS public.VT_task_create(VARCHAR, VARCHAR, VARCHAR, VARCHAR, VARCHAR, VARCHAR) CASCADE;
 DROP FUNCTION IF EXISTS public.VT_task_delete(VARCHAR, BOOLEAN, VARCHAR) CASCADE;
 DROP FUNCTION IF EXISTS public.VT_task_output_idxquery(VARCHAR, NAME, REGTYPE, INT, VARCHAR) CASCADE;
---DROP FUNCTION IF EXISTS public.VT_filtered_events(VARCHAR, VARCHAR, VARCHAR, VARCHAR, public.vtevent_filter)
+DROP FUNCTION IF EXISTS public.VT_filtered_events(VARCHAR, VARCHAR, VARCHAR, VARCHAR[], public.vtevent_filter) CASCADE;
+DROP FUNCTION IF EXISTS public.VT_task_output_stats(VARCHAR, VARCHAR, VARCHAR, VARCHAR[], public.vtevent_filter) CASCADE;
+DROP FUNCTION IF EXISTS public.VT_task_output_classes(VARCHAR, VARCHAR, VARCHAR[]) CASCADE;
+DROP FUNCTION IF EXISTS public.VT_task_output_versions(VARCHAR, VARCHAR, VARCHAR[]) CASCADE;
+DROP FUNCTION IF EXISTS public.VT_task_stats_refresh(VARCHAR, VARCHAR, VARCHAR) CASCADE;
+DROP FUNCTION IF EXISTS public.VT_task_stats_maintained(VARCHAR) CASCADE;
 
 
 DROP FUNCTION IF EXISTS public.tsrange(TIMESTAMP WITHOUT TIME ZONE, DOUBLE PRECISION) CASCADE;
 DROP FUNCTION IF EXISTS public.daytimenumrange(TIMESTAMP WITHOUT TIME ZONE, DOUBLE PRECISION) CASCADE;
 DROP FUNCTION IF EXISTS public.trg_interval_provide_seclength_realtime() CASCADE;
+DROP FUNCTION IF EXISTS public.trg_interval_update_stats() CASCADE;
 
 
 -------------------------------------
@@ -603,6 +609,45 @@ CREATE OR REPLACE FUNCTION VT_dataset_support_create (_dsname VARCHAR)
     );
     CREATE INDEX rel_tasks_sequences_done_is_done_idx ON rel_tasks_sequences_done(is_done);
 
+    -- tables for statistics of task outputs (maintained by trg_interval_update_stats)
+    CREATE TABLE task_stats (
+      taskname     NAME      NOT NULL,
+      seqname      NAME      NOT NULL,
+      count_root   BIGINT    DEFAULT 0,
+      count_all    BIGINT    DEFAULT 0,
+      covered      BIGINT    DEFAULT 0,
+      valid        BOOLEAN   DEFAULT TRUE,
+      modified     BIGINT    DEFAULT txid_current(),  -- transaction of last change of outputs
+      changed      BIGINT    DEFAULT 0,               -- transaction of last UPDATE or DELETE of outputs
+      CONSTRAINT task_stats_pk PRIMARY KEY (taskname, seqname),
+      CONSTRAINT taskname_fk FOREIGN KEY (taskname)
+        REFERENCES tasks(taskname) ON UPDATE CASCADE ON DELETE CASCADE,
+      CONSTRAINT seqname_fk FOREIGN KEY (seqname)
+        REFERENCES sequences(seqname) ON UPDATE CASCADE ON DELETE CASCADE
+    );
+
+    -- disjoint covered frame ranges, new intervals are merged into them
+    CREATE TABLE task_stats_coverage (
+      taskname   NAME        NOT NULL,
+      seqname    NAME        NOT NULL,
+      frames     INT4RANGE   NOT NULL,
+      CONSTRAINT task_stats_fk FOREIGN KEY (taskname, seqname)
+        REFERENCES task_stats(taskname, seqname) ON UPDATE CASCADE ON DELETE CASCADE
+    );
+    CREATE INDEX task_stats_coverage_seq_idx ON task_stats_coverage(taskname, seqname);
+    CREATE INDEX task_stats_coverage_frames_idx ON task_stats_coverage USING GIST (frames);
+
+    -- sums of class occurrences (class -1 = keyframes count)
+    CREATE TABLE task_stats_classes (
+      taskname     NAME               NOT NULL,
+      seqname      NAME               NOT NULL,
+      class_id     INT                NOT NULL,
+      occurrence   DOUBLE PRECISION   DEFAULT 0,
+      CONSTRAINT task_stats_classes_pk PRIMARY KEY (taskname, seqname, class_id),
+      CONSTRAINT task_stats_fk FOREIGN KEY (taskname, seqname)
+        REFERENCES task_stats(taskname, seqname) ON UPDATE CASCADE ON DELETE CASCADE
+    );
+
   END;
   $VT_dataset_create_support$
   LANGUAGE plpgsql STRICT;
@@ -806,7 +851,6 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
     _keyio          VARCHAR;
     _namespaceoid   OID;
     _idxnames       VARCHAR[];
-    _idxprefix      VARCHAR   DEFAULT '';
 
     __outname       VARCHAR   DEFAULT '';
   BEGIN
@@ -825,8 +869,6 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
 
     IF _dsname IS NULL THEN
       _dsname := current_schema();
-    ELSE
-      _idxprefix := _dsname || '.';
     END IF;
 
     -- check if dataset (schema) exists
@@ -907,6 +949,14 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
           _idxstmt := _idxstmt || public.VT_task_output_idxquery(_reqoutname, _keyname, _typname, NULL, _dsname);
         END IF;
 
+        -- events are filtered by region overlap (VT_filtered_events), so region is always GiST indexed
+        IF _typname = 'public.vtevent'::regtype THEN
+          _i := attnum FROM pg_catalog.pg_attribute WHERE attrelid = 'public.vtevent'::regclass AND attname = 'region';
+          IF _indexedparts IS NULL OR NOT _i = ANY(_indexedparts) THEN
+            _indexedparts := array_append(_indexedparts, _i);
+          END IF;
+        END IF;
+
         IF _indexedparts IS NOT NULL THEN
           FOREACH _i IN ARRAY _indexedparts LOOP
             _idxstmt := _idxstmt || public.VT_task_output_idxquery(_reqoutname, _keyname, _typname, _i, _dsname);
@@ -941,6 +991,30 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
                          FOR EACH ROW
                          EXECUTE PROCEDURE public.trg_interval_provide_seclength_realtime(' || _usert || ');';
 
+      _stmt := _stmt || 'CREATE TRIGGER ' || quote_ident(_reqoutname || '_insert_stats') || '
+                         AFTER INSERT
+                         ON ' || __outname || '
+                         REFERENCING NEW TABLE AS new_rows
+                         FOR EACH STATEMENT
+                         EXECUTE PROCEDURE public.trg_interval_update_stats();
+                         CREATE TRIGGER ' || quote_ident(_reqoutname || '_update_stats') || '
+                         AFTER UPDATE
+                         ON ' || __outname || '
+                         REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows
+                         FOR EACH STATEMENT
+                         EXECUTE PROCEDURE public.trg_interval_update_stats();
+                         CREATE TRIGGER ' || quote_ident(_reqoutname || '_delete_stats') || '
+                         AFTER DELETE
+                         ON ' || __outname || '
+                         REFERENCING OLD TABLE AS old_rows
+                         FOR EACH STATEMENT
+                         EXECUTE PROCEDURE public.trg_interval_update_stats();
+                         CREATE TRIGGER ' || quote_ident(_reqoutname || '_truncate_stats') || '
+                         AFTER TRUNCATE
+                         ON ' || __outname || '
+                         FOR EACH STATEMENT
+                         EXECUTE PROCEDURE public.trg_interval_update_stats();';
+
 
     -- task' output table maybe exists - it is needed to check the presence of columns required by method
     ELSE
@@ -974,18 +1048,20 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
         RAISE EXCEPTION 'It seems, that "%" is not a task'' output table (column named "%" of "%" data type is missing).', _dsname || '.' || _reqoutname, _keyname, _typname;
       END IF;
 
-      EXECUTE 'SELECT array_agg(indexrelid::regclass::varchar)
-               FROM pg_catalog.pg_index
-               WHERE indrelid = ' || quote_literal(__outname) || '::regclass;'
+      -- existing indexes are not built again (plain names, regclass text depends on search_path)
+      EXECUTE 'SELECT array_agg(c.relname::varchar)
+               FROM pg_catalog.pg_index i
+               JOIN pg_catalog.pg_class c ON c.oid = i.indexrelid
+               WHERE i.indrelid = ' || quote_literal(__outname) || '::regclass;'
           INTO _idxnames;
 
       IF _usert = TRUE THEN
         _tmpstmt := 'SELECT ''rt_start'', ''TIMESTAMP WITHOUT TIME ZONE'', FALSE, FALSE, NULL  -- trigger supplied
                      UNION ';
 
-        EXECUTE 'SELECT 1 WHERE ' || quote_literal(_idxprefix || _reqoutname || '_tsrange_idx') || ' = ANY(' || quote_literal(_idxnames) || ');' INTO _controlcount;
-        IF _controlcount <> 1 THEN
-          _idxstmt := 'CREATE INDEX ' || quote_ident(_reqoutname || '_tsrange_idx') || ' ON ' || __outname || ' USING GIST ( public.tsrange(rt_start, sec_length) );';
+        EXECUTE 'SELECT COUNT(*) WHERE ' || quote_literal(_reqoutname || '_tsrange_idx') || ' = ANY(' || quote_literal(_idxnames) || ');' INTO _controlcount;
+        IF _controlcount = 0 THEN
+          _idxstmt := 'CREATE INDEX IF NOT EXISTS ' || quote_ident(_reqoutname || '_tsrange_idx') || ' ON ' || __outname || ' USING GIST ( public.tsrange(rt_start, sec_length) );';
         END IF;
       END IF;
 
@@ -1010,16 +1086,24 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
         END IF;
 
         IF _indexedkey = TRUE THEN
-          EXECUTE 'SELECT COUNT(*) WHERE ' || quote_literal(_idxprefix || _reqoutname || '_' || _keyname || '_idx') || ' = ANY(' || quote_literal(_idxnames) || ');' INTO _controlcount;
+          EXECUTE 'SELECT COUNT(*) WHERE ' || quote_literal(_reqoutname || '_' || _keyname || '_idx') || ' = ANY(' || quote_literal(_idxnames) || ');' INTO _controlcount;
           IF _controlcount = 0 THEN
             _idxstmt := _idxstmt || public.VT_task_output_idxquery(_reqoutname, _keyname, _typname, NULL, _dsname);
           END IF;
         END IF;
 
+        -- events are filtered by region overlap (VT_filtered_events), so region is always GiST indexed
+        IF _typname = 'public.vtevent'::regtype THEN
+          _i := attnum FROM pg_catalog.pg_attribute WHERE attrelid = 'public.vtevent'::regclass AND attname = 'region';
+          IF _indexedparts IS NULL OR NOT _i = ANY(_indexedparts) THEN
+            _indexedparts := array_append(_indexedparts, _i);
+          END IF;
+        END IF;
+
         IF _indexedparts IS NOT NULL THEN
           FOREACH _i IN ARRAY _indexedparts LOOP
             EXECUTE 'SELECT attname FROM pg_catalog.pg_attribute WHERE attrelid = (SELECT oid FROM pg_catalog.pg_class WHERE reltype = ' || quote_literal(_typname) || '::regtype AND relkind = ''c'') AND attnum = ' || _i INTO _tmpstmt;
-            EXECUTE 'SELECT COUNT(*) WHERE ' || quote_literal(_idxprefix || _reqoutname || '_' || _keyname || '_' || _tmpstmt || '_idx') || ' = ANY(' || quote_literal(_idxnames) || ');' INTO _controlcount;
+            EXECUTE 'SELECT COUNT(*) WHERE ' || quote_literal(_reqoutname || '_' || _keyname || '_' || _tmpstmt || '_idx') || ' = ANY(' || quote_literal(_idxnames) || ');' INTO _controlcount;
             IF _controlcount = 0 THEN
               _idxstmt := _idxstmt || public.VT_task_output_idxquery(_reqoutname, _keyname, _typname, _i, _dsname);
             END IF;
@@ -1035,6 +1119,10 @@ CREATE OR REPLACE FUNCTION public.VT_task_create (_taskname VARCHAR, _mtname VAR
 
     IF _stmt <> '' THEN
       EXECUTE _stmt;
+    END IF;
+
+    -- missing indexes are created also for existing output table with all columns
+    IF _idxstmt <> '' THEN
       EXECUTE _idxstmt;
     END IF;
 
@@ -1143,7 +1231,7 @@ CREATE OR REPLACE FUNCTION VT_task_output_idxquery(_tblname VARCHAR, _keyname NA
 
     -- TODO GIST index 4 3D geometry?
     -- TODO _idxtype & _idxops - is it needed & useful?
-    RETURN 'CREATE INDEX ' || quote_ident(_idxname) || ' ON ' || quote_ident(_tblname) || ' ' || _stmt || ' (' || __idxcol || ');';
+    RETURN 'CREATE INDEX IF NOT EXISTS ' || quote_ident(_idxname) || ' ON ' || quote_ident(_tblname) || ' ' || _stmt || ' (' || __idxcol || ');';
 
     EXCEPTION WHEN OTHERS THEN
       RAISE WARNING 'It seems, that indexing of "%" type (above key "%") is not supported by VTApi at this moment. If you would like to index this key, try to contact VTApi team. (Details: ERROR %: %)', _typname, _keyname, SQLSTATE, SQLERRM;
@@ -1157,28 +1245,30 @@ CREATE OR REPLACE FUNCTION VT_task_output_idxquery(_tblname VARCHAR, _keyname NA
 -------------------------------------
 -- Filters
 -------------------------------------
---   * i.e.: SELECT * FROM demo2_out WHERE id IN public.VT_filtered_events('demo.demo2_out', 'event', 'task_demo2_1', '["video1"]', '(0,5,,2015-04-01 04:06:00,,,"(0,0),(0.1,0.8)")');
+--   * i.e.: SELECT * FROM demo.demo2_out WHERE (event).group_id IN (SELECT public.VT_filtered_events('demo.demo2_out', 'event', 'task_demo2_1', '{video1}', '(0,5,,2015-04-01 04:06:00,,,"(0,0),(0.1,0.8)")'));
 -- Function behavior:
---   * returns set of IDs of filtered events
---   * first argument is tabletype (passed like NULL::<table name>
+--   * returns set of group IDs of filtered events (trajectories), possibly with duplicates,
+--     so that outer query semi-joins them (IN), planner then uses hash semi-join
+--     instead of comparing every row with whole array
+--   * realtime and daytime filters are written as the GiST indexed expressions
+--     (_tsrange_idx, _daytime_idx of output table), so that index scans are used
+--   * spatial filter compares the event column's region with plain box parameter,
+--     so that it matches the GiST expression index on ((event).region) created by VT_task_create
 --   * available filters:
 --       * duration filter: 1st and 2nd value as min and max
 --       * realtime filter: 3rd and 4th value as min and max
 --       * daytime filter:  5th and 6th value as min and max
 --       * spatial filter:  7th value as interested box
 --   * filters may be combined
---   * returns setof records of matching rows
 CREATE OR REPLACE FUNCTION VT_filtered_events(_table VARCHAR, _column VARCHAR, _taskname VARCHAR, _seqnames VARCHAR[], _filter public.vtevent_filter)
-  RETURNS INT[] AS
+  RETURNS SETOF INT AS
   $VT_filtered_events$
   DECLARE
     _cond            VARCHAR   DEFAULT '';
-    _seqlist         VARCHAR   DEFAULT '';
     _cond_duration   VARCHAR   DEFAULT '';
     _cond_realtime   VARCHAR   DEFAULT '';
     _cond_daytime    VARCHAR   DEFAULT '';
     _query           VARCHAR   DEFAULT '';
-    _gids            INT[];
 
   BEGIN
 
@@ -1192,32 +1282,26 @@ CREATE OR REPLACE FUNCTION VT_filtered_events(_table VARCHAR, _column VARCHAR, _
       RAISE EXCEPTION 'Task name canot be null.';
     END IF;
 
-    _cond := 'taskname = ' || quote_literal(_taskname);
+    -- values are passed as parameters ($1 task, $2 sequences, $3 filter, $4 region)
+    _cond := 'o.taskname = $1';
 
     IF array_length(_seqnames, 1) > 0 THEN
-      FOR _i IN 1 .. array_upper(_seqnames, 1) LOOP
-        IF _i > 1 THEN
-          _seqlist := _seqlist || ',';
-        END IF;
-        _seqlist := _seqlist || quote_literal(_seqnames[_i]);
-      END LOOP;
-
-      _cond := _cond || ' AND seqname IN (' || _seqlist || ')';
+      _cond := _cond || ' AND o.seqname = ANY ($2::NAME[])';
     END IF;
 
     IF (_filter).duration_max IS NULL OR (_filter).duration_max < 0
     THEN
       IF (_filter).duration_min > 0
       THEN
-        _cond_duration := ' sec_length >= ' || (_filter).duration_min;
+        _cond_duration := ' o.sec_length >= ($3).duration_min';
       END IF;
     ELSE
       IF (_filter).duration_min IS NULL OR (_filter).duration_min = (_filter).duration_max
       THEN
-        _cond_duration := ' sec_length = ' || (_filter).duration_max;
+        _cond_duration := ' o.sec_length = ($3).duration_max';
       ELSIF (_filter).duration_min < (_filter).duration_max
       THEN
-        _cond_duration := ' sec_length BETWEEN ' || (_filter).duration_min || ' AND ' || (_filter).duration_max;
+        _cond_duration := ' o.sec_length BETWEEN ($3).duration_min AND ($3).duration_max';
       ELSE
         RAISE EXCEPTION 'Minimal duration (%) can not be greater than maximal duration (%). ', (_filter).duration_min, (_filter).duration_max;
       END IF;
@@ -1227,23 +1311,22 @@ CREATE OR REPLACE FUNCTION VT_filtered_events(_table VARCHAR, _column VARCHAR, _
       _cond_duration := ' AND ' || _cond_duration || ' ';
     END IF;
 
-
     IF (_filter).realtime_min IS NOT NULL OR (_filter).realtime_max IS NOT NULL
     THEN
-      _cond_realtime := ' AND public.tsrange(' || _table || '.rt_start, ' || _table || '.sec_length) && tsrange(' || quote_nullable((_filter).realtime_min) || '::timestamp, ' || quote_nullable((_filter).realtime_max) || '::timestamp) ';
+      _cond_realtime := ' AND public.tsrange(o.rt_start, o.sec_length) && tsrange(($3).realtime_min, ($3).realtime_max) ';
     END IF;
 
     IF (_filter).daytime_min IS NOT NULL OR (_filter).daytime_max IS NOT NULL
     THEN
-      _cond_daytime := ' AND public.daytimenumrange(' || _table || '.rt_start, ' || _table || '.sec_length) && public.daytimenumrange(' || quote_nullable((_filter).daytime_min) || '::time, ' || quote_nullable((_filter).daytime_max) || '::time) ';
+      _cond_daytime := ' AND public.daytimenumrange(o.rt_start, o.sec_length) && public.daytimenumrange(($3).daytime_min, ($3).daytime_max) ';
     END IF;
 
     IF _cond_duration <> '' OR _cond_realtime <> '' OR _cond_daytime <> ''
     THEN
-      _query := ' SELECT DISTINCT (' || quote_ident(_column) || ').group_id AS gids
-                  FROM ' || _table ||
-                ' WHERE ' || _cond ||
-                '   AND (' || quote_ident(_column) || ').is_root = TRUE ' ||
+      _query := ' SELECT (o.' || quote_ident(_column) || ').group_id
+                  FROM ' || _table || ' o
+                  WHERE ' || _cond ||
+                '   AND (o.' || quote_ident(_column) || ').is_root = TRUE ' ||
                     _cond_duration ||
                     _cond_realtime ||
                     _cond_daytime;
@@ -1251,16 +1334,17 @@ CREATE OR REPLACE FUNCTION VT_filtered_events(_table VARCHAR, _column VARCHAR, _
 
     IF (_filter).region IS NOT NULL
     THEN
+      -- both filters: INTERSECT removes duplicates by hashing, no sorts are needed
       IF _query <> ''
       THEN
         _query := _query || ' INTERSECT ';
       END IF;
 
       _query :=   _query ||
-                ' SELECT DISTINCT (' || quote_ident(_column) || ').group_id AS gids
-                  FROM ' || _table ||
-                ' WHERE ' || _cond ||
-                '   AND (' || quote_ident(_column) || ').region && ' || quote_literal((_filter).region);
+                ' SELECT (o.' || quote_ident(_column) || ').group_id
+                  FROM ' || _table || ' o
+                  WHERE ' || _cond ||
+                '   AND (o.' || quote_ident(_column) || ').region && $4';
     END IF;
 
     IF _query = ''
@@ -1268,26 +1352,369 @@ CREATE OR REPLACE FUNCTION VT_filtered_events(_table VARCHAR, _column VARCHAR, _
       RAISE EXCEPTION 'No event filter was given.';
     END IF;
 
-    _query := 'SELECT array_agg(gids) FROM (' || _query || ') AS x;';
+    RETURN QUERY EXECUTE _query USING _taskname, _seqnames, _filter, (_filter).region;
+
+    EXCEPTION WHEN OTHERS THEN
+      RAISE EXCEPTION 'Some problem occured during filtering by event filters (%) of the task "%". (Details: ERROR %: %)', _filter, _taskname, SQLSTATE, SQLERRM;
+  END;
+  $VT_filtered_events$
+  LANGUAGE plpgsql STABLE CALLED ON NULL INPUT ROWS 10000;
+
+
+-- TASK OUTPUT: events statistics
+--   * i.e.: SELECT * FROM public.VT_task_output_stats('demo.demo2_out', 'event', 'task_demo2_1', '{video1}', NULL);
+-- Function behavior:
+--   * returns one row per sequence of dataset (or per given sequence):
+--     sequence length, number of frames covered by events, number of root events and of all events
+--   * event intervals (t1, t2) are clipped to sequence length and merged
+--     as int4ranges, so only aggregated rows leave the database
+--   * optional filter is applied same as by VT_filtered_events
+CREATE OR REPLACE FUNCTION VT_task_output_stats(_table VARCHAR, _column VARCHAR, _taskname VARCHAR, _seqnames VARCHAR[], _filter public.vtevent_filter)
+  RETURNS TABLE (seqname NAME, seqlength INT, covered BIGINT, count_root BIGINT, count_all BIGINT) AS
+  $VT_task_output_stats$
+  DECLARE
+    _dsname          NAME;
+    _cond            VARCHAR   DEFAULT '';
+    _cond_seqname    VARCHAR   DEFAULT '';
+
+  BEGIN
+
+    IF _column IS NULL
+    THEN
+       _column := 'event';
+    END IF;
+
+    IF _taskname IS NULL
+    THEN
+      RAISE EXCEPTION 'Task name canot be null.';
+    END IF;
 
-    EXECUTE _query INTO _gids;
+    -- dataset is the schema of output table
+    SELECT n.nspname INTO _dsname
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+      WHERE c.oid = _table::regclass;
 
-    RETURN _gids;
+    IF array_length(_seqnames, 1) > 0 THEN
+      _cond_seqname := ' AND s.seqname = ANY (' || quote_literal(_seqnames) || '::NAME[])';
+    END IF;
 
-    -- IF _gids IS NOT NULL
-    -- THEN
-    --   RETURN QUERY EXECUTE 'SELECT * FROM ' || _table || ' WHERE taskname = ' || quote_literal(_taskname) || _cond_seqname || ' AND (' || quote_ident(_column) || ').group_id IN (' || array_to_string(_gids, ',') || ');';
-    -- ELSE
-    --   RETURN QUERY EXECUTE 'SELECT * FROM ' || _table || ' WHERE 0 = 1;';
-    -- END IF;
+    -- statistics maintained by trigger are just read (if there is no filter)
+    IF _filter IS NULL AND public.VT_task_stats_maintained(_table) THEN
+      PERFORM public.VT_task_stats_refresh(_table, _column, _taskname);
+
+      RETURN QUERY EXECUTE
+        ' SELECT s.seqname, s.seqlength,
+                 COALESCE(t.covered, 0)::BIGINT, COALESCE(t.count_root, 0)::BIGINT, COALESCE(t.count_all, 0)::BIGINT
+          FROM ' || quote_ident(_dsname) || '.sequences s
+          LEFT JOIN ' || quote_ident(_dsname) || '.task_stats t
+            ON t.seqname = s.seqname AND t.taskname = ' || quote_literal(_taskname) || '
+          WHERE TRUE ' || _cond_seqname || '
+          ORDER BY s.seqname';
+      RETURN;
+    END IF;
+
+    _cond := 'o.taskname = ' || quote_literal(_taskname) || _cond_seqname;
+
+    IF NOT (_filter IS NULL) THEN
+      _cond := _cond || ' AND (o.' || quote_ident(_column) || ').group_id IN (SELECT public.VT_filtered_events(' ||
+               quote_literal(_table) || ', ' || quote_literal(_column) || ', ' || quote_literal(_taskname) || ', ' ||
+               quote_nullable(_seqnames) || '::VARCHAR[], ' || quote_literal(_filter) || '::public.vtevent_filter))';
+    END IF;
+
+    RETURN QUERY EXECUTE
+      ' WITH ev AS (
+          SELECT o.seqname, (o.' || quote_ident(_column) || ').is_root AS is_root,
+                 int4range(GREATEST(o.t1, 1), GREATEST(o.t2, o.t1, 1) + 1) *
+                 int4range(1, GREATEST(COALESCE(s.seqlength, 0), 0) + 1) AS r
+          FROM ' || _table || ' o
+          JOIN ' || quote_ident(_dsname) || '.sequences s ON s.seqname = o.seqname
+          WHERE ' || _cond || '
+        ), starts AS (
+          SELECT ev.seqname, ev.r,
+                 CASE WHEN lower(ev.r) <= max(upper(ev.r)) OVER w THEN 0 ELSE 1 END AS is_start
+          FROM ev
+          WHERE NOT isempty(ev.r)
+          WINDOW w AS (PARTITION BY ev.seqname ORDER BY lower(ev.r), upper(ev.r)
+                       ROWS BETWEEN UNBOUNDED PRECEDING AND 1 PRECEDING)
+        ), islands AS (
+          SELECT starts.seqname, starts.r,
+                 sum(starts.is_start) OVER (PARTITION BY starts.seqname ORDER BY lower(starts.r), upper(starts.r)) AS island
+          FROM starts
+        ), merged AS (
+          SELECT m.seqname, sum(m.hi - m.lo) AS covered
+          FROM (SELECT islands.seqname, min(lower(islands.r)) AS lo, max(upper(islands.r)) AS hi
+                FROM islands GROUP BY islands.seqname, islands.island) m
+          GROUP BY m.seqname
+        ), counts AS (
+          SELECT ev.seqname, sum(CASE WHEN ev.is_root THEN 1 ELSE 0 END) AS count_root, count(*) AS count_all
+          FROM ev GROUP BY ev.seqname
+        )
+        SELECT s.seqname, s.seqlength,
+               COALESCE(m.covered, 0)::BIGINT, COALESCE(c.count_root, 0)::BIGINT, COALESCE(c.count_all, 0)::BIGINT
+        FROM ' || quote_ident(_dsname) || '.sequences s
+        LEFT JOIN merged m ON m.seqname = s.seqname
+        LEFT JOIN counts c ON c.seqname = s.seqname
+        WHERE TRUE ' || _cond_seqname || '
+        ORDER BY s.seqname';
 
     EXCEPTION WHEN OTHERS THEN
-      RAISE EXCEPTION 'Some problem occured during filtering by event filters (%) of the task "%". (Details: ERROR %: %)', _filter, _taskname, SQLSTATE, SQLERRM;
+      RAISE EXCEPTION 'Some problem occured during calculation of events statistics of the task "%". (Details: ERROR %: %)', _taskname, SQLSTATE, SQLERRM;
   END;
-  $VT_filtered_events$
+  $VT_task_output_stats$
   LANGUAGE plpgsql CALLED ON NULL INPUT;
 
 
+-- TASK OUTPUT: class occurrences
+--   * i.e.: SELECT * FROM public.VT_task_output_classes('demo.demo2_out', 'task_demo2_1', '{video1}');
+-- Function behavior:
+--   * returns sums of "out_occurrence" per "out_class_id" over given sequences (or all)
+--   * class -1 is total keyframes count
+CREATE OR REPLACE FUNCTION VT_task_output_classes(_table VARCHAR, _taskname VARCHAR, _seqnames VARCHAR[])
+  RETURNS TABLE (class_id INT, occurrence DOUBLE PRECISION) AS
+  $VT_task_output_classes$
+  DECLARE
+    _dsname          NAME;
+    _cond_seqname    VARCHAR   DEFAULT '';
+
+  BEGIN
+
+    IF _taskname IS NULL
+    THEN
+      RAISE EXCEPTION 'Task name canot be null.';
+    END IF;
+
+    SELECT n.nspname INTO _dsname
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+      WHERE c.oid = _table::regclass;
+
+    IF array_length(_seqnames, 1) > 0 THEN
+      _cond_seqname := ' AND x.seqname = ANY (' || quote_literal(_seqnames) || '::NAME[])';
+    END IF;
+
+    IF public.VT_task_stats_maintained(_table) THEN
+      PERFORM public.VT_task_stats_refresh(_table, NULL, _taskname);
+
+      RETURN QUERY EXECUTE
+        ' SELECT x.class_id, sum(x.occurrence)::DOUBLE PRECISION
+          FROM ' || quote_ident(_dsname) || '.task_stats_classes x
+          WHERE x.taskname = ' || quote_literal(_taskname) || _cond_seqname || '
+          GROUP BY x.class_id';
+    ELSE
+      RETURN QUERY EXECUTE
+        ' SELECT x.out_class_id::INT, sum(x.out_occurrence)::DOUBLE PRECISION
+          FROM ' || _table || ' x
+          WHERE x.taskname = ' || quote_literal(_taskname) || _cond_seqname || '
+            AND x.out_class_id IS NOT NULL
+          GROUP BY x.out_class_id';
+    END IF;
+
+    EXCEPTION WHEN OTHERS THEN
+      RAISE EXCEPTION 'Some problem occured during summing of class occurrences of the task "%". (Details: ERROR %: %)', _taskname, SQLSTATE, SQLERRM;
+  END;
+  $VT_task_output_classes$
+  LANGUAGE plpgsql CALLED ON NULL INPUT;
+
+
+
+-- TASK OUTPUT: versions of events
+--   * i.e.: SELECT * FROM public.VT_task_output_versions('demo.demo2_out', 'task_demo2_1', '{video1}');
+-- Function behavior:
+--   * returns one row per sequence of dataset (or per given sequence): transaction ID of last
+--     change of task outputs in sequence, of last UPDATE or DELETE and number of all events,
+--     so that clients keeping loaded events can cheaply check if they are outdated
+--   * values are read from statistics maintained by trigger (0 = no change yet),
+--     -1 = unknown (statistics are not maintained, or count is being recalculated)
+CREATE OR REPLACE FUNCTION VT_task_output_versions(_table VARCHAR, _taskname VARCHAR, _seqnames VARCHAR[])
+  RETURNS TABLE (seqname NAME, modified BIGINT, changed BIGINT, count_all BIGINT) AS
+  $VT_task_output_versions$
+  DECLARE
+    _dsname          NAME;
+    _cond_seqname    VARCHAR   DEFAULT '';
+
+  BEGIN
+
+    IF _taskname IS NULL
+    THEN
+      RAISE EXCEPTION 'Task name canot be null.';
+    END IF;
+
+    SELECT n.nspname INTO _dsname
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+      WHERE c.oid = _table::regclass;
+
+    IF array_length(_seqnames, 1) > 0 THEN
+      _cond_seqname := ' AND s.seqname = ANY (' || quote_literal(_seqnames) || '::NAME[])';
+    END IF;
+
+    IF public.VT_task_stats_maintained(_table) THEN
+      RETURN QUERY EXECUTE
+        ' SELECT s.seqname, COALESCE(t.modified, 0)::BIGINT, COALESCE(t.changed, 0)::BIGINT,
+                 CASE WHEN t.valid IS FALSE THEN -1 ELSE COALESCE(t.count_all, 0) END::BIGINT
+          FROM ' || quote_ident(_dsname) || '.sequences s
+          LEFT JOIN ' || quote_ident(_dsname) || '.task_stats t
+            ON t.seqname = s.seqname AND t.taskname = ' || quote_literal(_taskname) || '
+          WHERE TRUE ' || _cond_seqname || '
+          ORDER BY s.seqname';
+    ELSE
+      RETURN QUERY EXECUTE
+        ' SELECT s.seqname, -1::BIGINT, -1::BIGINT, -1::BIGINT
+          FROM ' || quote_ident(_dsname) || '.sequences s
+          WHERE TRUE ' || _cond_seqname || '
+          ORDER BY s.seqname';
+    END IF;
+
+    EXCEPTION WHEN OTHERS THEN
+      RAISE EXCEPTION 'Some problem occured during reading of events versions of the task "%". (Details: ERROR %: %)', _taskname, SQLSTATE, SQLERRM;
+  END;
+  $VT_task_output_versions$
+  LANGUAGE plpgsql CALLED ON NULL INPUT;
+
+
+
+-- TASK OUTPUT: check for statistics maintenance
+-- Function behavior:
+--   * returns TRUE if statistics of task output table are maintained by trigger
+CREATE OR REPLACE FUNCTION VT_task_stats_maintained(_table VARCHAR)
+  RETURNS BOOLEAN AS
+  $VT_task_stats_maintained$
+  DECLARE
+    _dsname          NAME;
+
+  BEGIN
+    SELECT n.nspname INTO _dsname
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+      WHERE c.oid = _table::regclass;
+
+    -- dataset created before statistics tables were introduced
+    IF to_regclass(quote_ident(_dsname) || '.task_stats') IS NULL THEN
+      RETURN FALSE;
+    END IF;
+
+    RETURN EXISTS (SELECT 1
+                   FROM pg_catalog.pg_trigger
+                   WHERE tgrelid = _table::regclass
+                     AND tgfoid = 'public.trg_interval_update_stats'::regproc);
+  END;
+  $VT_task_stats_maintained$
+  LANGUAGE plpgsql STRICT STABLE;
+
+
+
+-- TASK OUTPUT: recalculation of invalidated statistics
+-- Function behavior:
+--   * recalculates statistics of sequences invalidated by UPDATE/DELETE of task outputs
+--   * returns TRUE if anything was recalculated
+CREATE OR REPLACE FUNCTION VT_task_stats_refresh(_table VARCHAR, _column VARCHAR, _taskname VARCHAR)
+  RETURNS BOOLEAN AS
+  $VT_task_stats_refresh$
+  DECLARE
+    _dsname          NAME;
+    _seqnames        NAME[];
+    _root            VARCHAR   DEFAULT 'FALSE';
+
+  BEGIN
+
+    IF _column IS NULL
+    THEN
+       _column := 'event';
+    END IF;
+
+    SELECT n.nspname INTO _dsname
+      FROM pg_catalog.pg_class c
+      JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace
+      WHERE c.oid = _table::regclass;
+
+    -- lock invalid rows, so that concurrent inserts wait for recalculation
+    EXECUTE 'SELECT array_agg(x.seqname)
+             FROM (SELECT seqname
+                   FROM ' || quote_ident(_dsname) || '.task_stats
+                   WHERE taskname = $1 AND NOT valid
+                   FOR UPDATE) x'
+      INTO _seqnames
+      USING _taskname;
+
+    IF _seqnames IS NULL THEN
+      RETURN FALSE;
+    END IF;
+
+    IF EXISTS (SELECT 1 FROM pg_catalog.pg_attribute
+               WHERE attrelid = _table::regclass AND attname = _column AND NOT attisdropped) THEN
+      _root := '(o.' || quote_ident(_column) || ').is_root';
+    END IF;
+
+    EXECUTE 'DELETE FROM ' || quote_ident(_dsname) || '.task_stats_coverage WHERE taskname = $1 AND seqname = ANY ($2)'
+      USING _taskname, _seqnames;
+    EXECUTE 'DELETE FROM ' || quote_ident(_dsname) || '.task_stats_classes WHERE taskname = $1 AND seqname = ANY ($2)'
+      USING _taskname, _seqnames;
+
+    -- merge intervals to disjoint covered ranges (same as VT_task_output_stats)
+    EXECUTE
+      ' WITH ev AS (
+          SELECT o.seqname,
+                 int4range(GREATEST(o.t1, 1), GREATEST(o.t2, o.t1, 1) + 1) *
+                 int4range(1, GREATEST(COALESCE(s.seqlength, 0), 0) + 1) AS r
+          FROM ' || _table || ' o
+          JOIN ' || quote_ident(_dsname) || '.sequences s ON s.seqname = o.seqname
+          WHERE o.taskname = $1 AND o.seqname = ANY ($2)
+        ), starts AS (
+          SELECT ev.seqname, ev.r,
+                 CASE WHEN lower(ev.r) <= max(upper(ev.r)) OVER w THEN 0 ELSE 1 END AS is_start
+          FROM ev
+          WHERE NOT isempty(ev.r)
+          WINDOW w AS (PARTITION BY ev.seqname ORDER BY lower(ev.r), upper(ev.r)
+                       ROWS BETWEEN UNBOUNDED PRECEDING AND 1 PRECEDING)
+        ), islands AS (
+          SELECT starts.seqname, starts.r,
+                 sum(starts.is_start) OVER (PARTITION BY starts.seqname ORDER BY lower(starts.r), upper(starts.r)) AS island
+          FROM starts
+        )
+        INSERT INTO ' || quote_ident(_dsname) || '.task_stats_coverage (taskname, seqname, frames)
+        SELECT $1, islands.seqname, int4range(min(lower(islands.r)), max(upper(islands.r)))
+        FROM islands
+        GROUP BY islands.seqname, islands.island'
+      USING _taskname, _seqnames;
+
+    IF EXISTS (SELECT 1 FROM pg_catalog.pg_attribute
+               WHERE attrelid = _table::regclass AND attname = 'out_class_id' AND NOT attisdropped) AND
+       EXISTS (SELECT 1 FROM pg_catalog.pg_attribute
+               WHERE attrelid = _table::regclass AND attname = 'out_occurrence' AND NOT attisdropped) THEN
+      EXECUTE
+        ' INSERT INTO ' || quote_ident(_dsname) || '.task_stats_classes (taskname, seqname, class_id, occurrence)
+          SELECT $1, o.seqname, o.out_class_id, COALESCE(sum(o.out_occurrence), 0)
+          FROM ' || _table || ' o
+          WHERE o.taskname = $1 AND o.seqname = ANY ($2) AND o.out_class_id IS NOT NULL
+          GROUP BY o.seqname, o.out_class_id'
+        USING _taskname, _seqnames;
+    END IF;
+
+    EXECUTE
+      ' UPDATE ' || quote_ident(_dsname) || '.task_stats t
+        SET count_root = COALESCE((SELECT sum(CASE WHEN ' || _root || ' THEN 1 ELSE 0 END)
+                                   FROM ' || _table || ' o
+                                   WHERE o.taskname = t.taskname AND o.seqname = t.seqname), 0),
+            count_all = (SELECT count(*)
+                         FROM ' || _table || ' o
+                         WHERE o.taskname = t.taskname AND o.seqname = t.seqname),
+            covered = COALESCE((SELECT sum(upper(c.frames) - lower(c.frames))
+                                FROM ' || quote_ident(_dsname) || '.task_stats_coverage c
+                                WHERE c.taskname = t.taskname AND c.seqname = t.seqname), 0),
+            valid = TRUE
+        WHERE t.taskname = $1 AND t.seqname = ANY ($2)'
+      USING _taskname, _seqnames;
+
+    RETURN TRUE;
+
+    EXCEPTION WHEN OTHERS THEN
+      RAISE EXCEPTION 'Some problem occured during recalculation of statistics of the task "%". (Details: ERROR %: %)', _taskname, SQLSTATE, SQLERRM;
+  END;
+  $VT_task_stats_refresh$
+  LANGUAGE plpgsql STRICT;
+
+
 -------------------------------------
 -- Functions to work with real time
 -------------------------------------
@@ -1366,3 +1793,150 @@ CREATE OR REPLACE FUNCTION trg_interval_provide_seclength_realtime ()
     END;
   $trg_interval_provide_seclength_realtime$
   LANGUAGE PLPGSQL;
+
+
+-- Statistics of task outputs (task_stats tables of dataset)
+--   * INSERT updates statistics incrementally, once per statement (inserted rows
+--     are in transition table new_rows): counts, class occurrences and covered
+--     frames (new intervals are merged with overlapping or adjacent covered ranges)
+--   * UPDATE and DELETE invalidate statistics of sequences, VT_task_stats_refresh recalculates them
+--   * any change stores its transaction ID to statistics of sequence (see VT_task_output_versions)
+--   * TRUNCATE empties statistics of all tasks with outputs in the table
+CREATE OR REPLACE FUNCTION trg_interval_update_stats ()
+  RETURNS TRIGGER AS
+  $trg_interval_update_stats$
+    DECLARE
+      _schema     VARCHAR            DEFAULT NULL;
+      _root       VARCHAR            DEFAULT 'FALSE';
+    BEGIN
+      _schema := quote_ident(TG_TABLE_SCHEMA);
+
+      -- dataset without statistics tables
+      IF to_regclass(_schema || '.task_stats') IS NULL THEN
+        RETURN NULL;
+      END IF;
+
+      -- statistics rows are kept (emptied), so that their versions show the change
+      IF TG_OP = 'TRUNCATE' THEN
+        EXECUTE 'DELETE FROM ' || _schema || '.task_stats_coverage
+                 WHERE taskname IN (SELECT taskname FROM ' || _schema || '.tasks WHERE outputs = $1)'
+          USING TG_RELID;
+        EXECUTE 'DELETE FROM ' || _schema || '.task_stats_classes
+                 WHERE taskname IN (SELECT taskname FROM ' || _schema || '.tasks WHERE outputs = $1)'
+          USING TG_RELID;
+        EXECUTE 'UPDATE ' || _schema || '.task_stats
+                 SET count_root = 0, count_all = 0, covered = 0, valid = TRUE,
+                     modified = txid_current(), changed = txid_current()
+                 WHERE taskname IN (SELECT taskname FROM ' || _schema || '.tasks WHERE outputs = $1)'
+          USING TG_RELID;
+        RETURN NULL;
+      END IF;
+
+      IF TG_OP = 'UPDATE' OR TG_OP = 'DELETE' THEN
+        EXECUTE 'UPDATE ' || _schema || '.task_stats t
+                 SET valid = FALSE, modified = txid_current(), changed = txid_current()
+                 FROM (SELECT DISTINCT taskname, seqname FROM old_rows) o
+                 WHERE t.taskname = o.taskname AND t.seqname = o.seqname';
+        IF TG_OP = 'UPDATE' THEN
+          EXECUTE 'INSERT INTO ' || _schema || '.task_stats (taskname, seqname, valid, changed)
+                   SELECT DISTINCT taskname, seqname, FALSE, txid_current() FROM new_rows
+                   ON CONFLICT (taskname, seqname) DO UPDATE
+                     SET valid = FALSE, modified = txid_current(), changed = txid_current()';
+        END IF;
+        RETURN NULL;
+      END IF;
+
+      -- INSERT: rows of sequences statistics are created or marked as modified,
+      -- so they are locked until end of transaction (in the same order by all inserts),
+      -- invalid ones will be recalculated anyway
+      EXECUTE 'INSERT INTO ' || _schema || '.task_stats (taskname, seqname)
+               SELECT DISTINCT taskname, seqname FROM new_rows
+               ORDER BY taskname, seqname
+               ON CONFLICT (taskname, seqname) DO UPDATE SET modified = txid_current()';
+
+      -- class occurrences
+      IF EXISTS (SELECT 1 FROM pg_catalog.pg_attribute
+                 WHERE attrelid = TG_RELID AND attname = 'out_class_id' AND NOT attisdropped) AND
+         EXISTS (SELECT 1 FROM pg_catalog.pg_attribute
+                 WHERE attrelid = TG_RELID AND attname = 'out_occurrence' AND NOT attisdropped) THEN
+        EXECUTE 'INSERT INTO ' || _schema || '.task_stats_classes (taskname, seqname, class_id, occurrence)
+                 SELECT n.taskname, n.seqname, n.out_class_id, COALESCE(sum(n.out_occurrence), 0)
+                 FROM new_rows n
+                 JOIN ' || _schema || '.task_stats t ON t.taskname = n.taskname AND t.seqname = n.seqname AND t.valid
+                 WHERE n.out_class_id IS NOT NULL
+                 GROUP BY n.taskname, n.seqname, n.out_class_id
+                 ON CONFLICT (taskname, seqname, class_id) DO UPDATE
+                   SET occurrence = task_stats_classes.occurrence + EXCLUDED.occurrence';
+      END IF;
+
+      IF EXISTS (SELECT 1 FROM pg_catalog.pg_attribute
+                 WHERE attrelid = TG_RELID AND attname = 'event' AND NOT attisdropped) THEN
+        _root := 'COALESCE((n.event).is_root, FALSE)';
+      END IF;
+
+      -- covered frames (clipped to sequence length as in VT_task_output_stats):
+      -- new intervals and covered ranges touching them are merged to disjoint
+      -- ranges (same as VT_task_stats_refresh), counts are added
+      EXECUTE
+        ' WITH ev AS (
+            SELECT n.taskname, n.seqname,
+                   int4range(GREATEST(n.t1, 1), GREATEST(n.t2, n.t1, 1) + 1) *
+                   int4range(1, GREATEST(COALESCE(s.seqlength, 0), 0) + 1) AS r,
+                   ' || _root || ' AS is_root
+            FROM new_rows n
+            JOIN ' || _schema || '.task_stats t ON t.taskname = n.taskname AND t.seqname = n.seqname AND t.valid
+            LEFT JOIN ' || _schema || '.sequences s ON s.seqname = n.seqname
+          ), old AS (
+            DELETE FROM ' || _schema || '.task_stats_coverage c
+            USING ev
+            WHERE c.taskname = ev.taskname AND c.seqname = ev.seqname AND NOT isempty(ev.r)
+              AND (c.frames && ev.r OR c.frames -|- ev.r)
+            RETURNING c.taskname, c.seqname, c.frames
+          ), ranges AS (
+            SELECT ev.taskname, ev.seqname, ev.r FROM ev WHERE NOT isempty(ev.r)
+            UNION ALL
+            SELECT old.taskname, old.seqname, old.frames FROM old
+          ), starts AS (
+            SELECT ranges.taskname, ranges.seqname, ranges.r,
+                   CASE WHEN lower(ranges.r) <= max(upper(ranges.r)) OVER w THEN 0 ELSE 1 END AS is_start
+            FROM ranges
+            WINDOW w AS (PARTITION BY ranges.taskname, ranges.seqname ORDER BY lower(ranges.r), upper(ranges.r)
+                         ROWS BETWEEN UNBOUNDED PRECEDING AND 1 PRECEDING)
+          ), islands AS (
+            SELECT starts.taskname, starts.seqname, starts.r,
+                   sum(starts.is_start) OVER (PARTITION BY starts.taskname, starts.seqname
+                                              ORDER BY lower(starts.r), upper(starts.r)) AS island
+            FROM starts
+          ), merged AS (
+            INSERT INTO ' || _schema || '.task_stats_coverage (taskname, seqname, frames)
+            SELECT islands.taskname, islands.seqname, int4range(min(lower(islands.r)), max(upper(islands.r)))
+            FROM islands
+            GROUP BY islands.taskname, islands.seqname, islands.island
+            RETURNING taskname, seqname, frames
+          ), added AS (
+            SELECT merged.taskname, merged.seqname, sum(upper(merged.frames) - lower(merged.frames)) AS frames
+            FROM merged
+            GROUP BY merged.taskname, merged.seqname
+          ), removed AS (
+            SELECT old.taskname, old.seqname, sum(upper(old.frames) - lower(old.frames)) AS frames
+            FROM old
+            GROUP BY old.taskname, old.seqname
+          ), counts AS (
+            SELECT ev.taskname, ev.seqname, count(*) AS count_all,
+                   sum(CASE WHEN ev.is_root THEN 1 ELSE 0 END) AS count_root
+            FROM ev
+            GROUP BY ev.taskname, ev.seqname
+          )
+          UPDATE ' || _schema || '.task_stats t
+          SET count_root = t.count_root + counts.count_root,
+              count_all = t.count_all + counts.count_all,
+              covered = t.covered + COALESCE(added.frames, 0) - COALESCE(removed.frames, 0)
+          FROM counts
+          LEFT JOIN added ON added.taskname = counts.taskname AND added.seqname = counts.seqname
+          LEFT JOIN removed ON removed.taskname = counts.taskname AND removed.seqname = counts.seqname
+          WHERE t.taskname = counts.taskname AND t.seqname = counts.seqname';
+
+      RETURN NULL;
+    END;
+  $trg_interval_update_stats$
+  LANGUAGE PLPGSQL;
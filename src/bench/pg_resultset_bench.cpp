@@ -0,0 +1,152 @@
+// VTApi microbenchmark - PGResultSet column decoders
+//
+// Decodes one int4 column of a synthetic binary result (built by libpq
+// without database connection) through per-column decoders precomputed by
+// PGResultSet, and compares it with the lookups the generic getter did for
+// every value before calling PQgetf (PQftype, DatabaseTypes map lookup,
+// length switch to pick the format). PQgetf itself can't be called on
+// a result not created through libpqtypes, so the old path is measured
+// without it (the real difference is larger).
+//
+// usage: bench_pg_resultset [rows] [repetitions]
+
+#include "pg_resultset.h"
+#include <vtapi/common/dbtypes.h>
+#include <libpq-fe.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#define INT4OID     23
+
+using namespace std;
+using namespace vtapi;
+
+static PGresult *makeResult(int rows)
+{
+    PGresult *res = PQmakeEmptyPGresult(NULL, PGRES_TUPLES_OK);
+
+    PGresAttDesc attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.name = const_cast<char *>("id");
+    attr.typid = INT4OID;
+    attr.format = 1;
+    attr.typlen = 4;
+    attr.atttypmod = -1;
+    PQsetResultAttrs(res, 1, &attr);
+
+    for (int i = 0; i < rows; i++) {
+        uint32_t value = htonl(static_cast<uint32_t>(i));
+        PQsetvalue(res, i, 0, reinterpret_cast<char *>(&value), sizeof(value));
+    }
+
+    return res;
+}
+
+static void makeTypes(DatabaseTypes &dbtypes)
+{
+    DatabaseTypes::TypeDefinition int4;
+    int4._length = 4;
+    int4._category = DatabaseTypes::CATEGORY_INT;
+    int4._flags = DatabaseTypes::FLAG_NUMERIC;
+    int4._name = "int4";
+    dbtypes.insert(INT4OID, int4);
+
+    // about as many types as loaded from real database (existing OIDs are kept)
+    for (int oid = 16; oid < 4000; oid += 7) {
+        DatabaseTypes::TypeDefinition type;
+        type._length = -1;
+        type._category = DatabaseTypes::CATEGORY_STRING;
+        dbtypes.insert(oid, type);
+    }
+}
+
+// per value work of generic getter before PQgetf
+static long long oldLookups(const PGresult *res, const DatabaseTypes &dbtypes, int rows)
+{
+    long long sum = 0;
+
+    for (int pos = 0; pos < rows; pos++) {
+        const DatabaseTypes::TypeDefinition &type = dbtypes.type(PQftype(res, 0));
+        const char *format;
+        switch (type._length)
+        {
+        case 2: format = "%int2"; break;
+        case 4: format = "%int4"; break;
+        default: format = "%int8"; break;
+        }
+        if (!PQgetisnull(res, pos, 0))
+            sum += format[4];
+    }
+
+    return sum;
+}
+
+static long long newGetter(PGResultSet &rs, int rows)
+{
+    long long sum = 0;
+
+    for (int pos = 0; pos < rows; pos++) {
+        rs.setPosition(pos);
+        sum += rs.getInt(0);
+    }
+
+    return sum;
+}
+
+static long long newColumn(PGResultSet &rs)
+{
+    long long sum = 0;
+
+    for (int value : rs.getIntColumn(0))
+        sum += value;
+
+    return sum;
+}
+
+template <typename F>
+static void measure(const char *name, int rows, int repetitions, F run)
+{
+    vector<double> times;
+    volatile long long sink = 0;
+
+    for (int r = 0; r < repetitions; r++) {
+        auto start = chrono::steady_clock::now();
+        sink += run();
+        times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+
+    printf("%-28s min %8.2f ms  median %8.2f ms  %6.1f ns/value\n", name,
+           times.front(), times[times.size() / 2], times.front() * 1e6 / rows);
+}
+
+int main(int argc, char *argv[])
+{
+    int rows = argc > 1 ? atoi(argv[1]) : 1000000;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 10;
+    if (rows <= 0 || repetitions <= 0) {
+        fprintf(stderr, "usage: %s [rows] [repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    DatabaseTypes dbtypes;
+    makeTypes(dbtypes);
+
+    // result set owns the result
+    PGresult *res = makeResult(rows);
+    PGResultSet rs(dbtypes);
+    rs.newResult(res);
+
+    printf("%d rows of int4, %d repetitions\n", rows, repetitions);
+    measure("old lookups (w/o PQgetf)", rows, repetitions, [&] { return oldLookups(res, dbtypes, rows); });
+    measure("new getInt", rows, repetitions, [&] { return newGetter(rs, rows); });
+    measure("new getIntColumn", rows, repetitions, [&] { return newColumn(rs); });
+
+    return 0;
+}
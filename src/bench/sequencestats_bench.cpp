@@ -0,0 +1,139 @@
+// VTServer microbenchmark - coverage bitmap of sequence
+//
+// Sets random events on 24 h of 30 fps video and counts coverage by
+// SequenceStats (64-bit words, popcount), compared with byte bitmap walked
+// frame by frame as it was done before. Build with -march=native to let
+// compiler use vector popcount.
+//
+// usage: bench_sequencestats [events] [repetitions]
+
+#include "sequencestats.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#define VIDEO_LENGTH    (24 * 3600 * 30)    // frames
+#define MAX_EVENT       300                 // frames
+
+using namespace std;
+
+// previous implementation: byte bitmap, frames set and counted bit by bit
+class ByteCoverage
+{
+public:
+    explicit ByteCoverage(unsigned int length)
+        : _length(length), _bitmap((length + 7) >> 3, '\0') {}
+
+    void processEvent(unsigned int t1_frame, unsigned int t2_frame)
+    {
+        int t1 = t1_frame - 1;
+        int t2 = t2_frame - 1;
+        if (t1 < 0) t1 = 0;
+        if (t2 > static_cast<int>(_length) - 1) t2 = _length - 1;
+        if (t2 < t1) t2 = t1;
+
+        int x1 = t1 >> 3, x2 = t2 >> 3;
+        int y1 = 7 & t1, y2 = 7 & t2;
+        int bits = t2 - t1 + 1;
+
+        if (y1 > 0 && bits) {
+            for (int y = 7 - y1; (y >= 0) && bits; y--, bits--)
+                _bitmap[x1] |= (1 << y);
+            x1++;
+        }
+        if (bits) {
+            for (int y = 7; (y >= 7 - y2) && bits; y--, bits--)
+                _bitmap[x2] |= (1 << y);
+            x2--;
+        }
+        if (bits > 0) memset(&_bitmap[x1], 0xFF, x2 - x1 + 1);
+    }
+
+    double calculateCoverage() const
+    {
+        int x = 0, y = 7, total = 0;
+        for (unsigned int i = 0; i < _length; i++) {
+            if ((_bitmap[x]) & (1 << y)) total++;
+            if (--y < 0) {
+                x++;
+                y = 7;
+            }
+        }
+
+        return static_cast<double>(total) / _length;
+    }
+
+private:
+    unsigned int _length;
+    vector<char> _bitmap;
+};
+
+template <typename F>
+static double measure(int repetitions, F run)
+{
+    double best = 0.0;
+
+    for (int r = 0; r < repetitions; r++) {
+        auto start = chrono::steady_clock::now();
+        run();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (r == 0 || ms < best) best = ms;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int events = argc > 1 ? atoi(argv[1]) : 20000;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 20;
+    if (events <= 0 || repetitions <= 0) {
+        fprintf(stderr, "usage: %s [events] [repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    // deterministic events
+    mt19937 rng(2);
+    vector< pair<unsigned int,unsigned int> > ranges;
+    for (int i = 0; i < events; i++) {
+        unsigned int t1 = rng() % VIDEO_LENGTH + 1;
+        ranges.push_back(make_pair(t1, t1 + rng() % MAX_EVENT));
+    }
+
+    vtapi::IntervalEvent event;
+    event.is_root = true;
+
+    ByteCoverage old_stats(VIDEO_LENGTH);
+    vtserver::SequenceStats new_stats(VIDEO_LENGTH);
+    vtserver::SequenceStats other_stats(VIDEO_LENGTH);
+
+    double old_set = measure(1, [&] {
+        for (const auto & range : ranges) old_stats.processEvent(range.first, range.second);
+    });
+    double new_set = measure(1, [&] {
+        for (const auto & range : ranges) new_stats.processEvent(range.first, range.second, event);
+    });
+    for (const auto & range : ranges)
+        other_stats.processEvent(range.second, range.second + MAX_EVENT, event);
+
+    volatile double sink = 0.0;
+    double old_cov = measure(repetitions, [&] { sink += old_stats.calculateCoverage(); });
+    double new_cov = measure(repetitions, [&] { sink += new_stats.calculateCoverage(); });
+
+    vtserver::SequenceStats combined = new_stats;
+    double unite = measure(repetitions, [&] { combined.unite(other_stats); });
+    double intersect = measure(repetitions, [&] { combined.intersect(other_stats); });
+
+    printf("%d frames, %d events, best of %d\n", VIDEO_LENGTH, events, repetitions);
+    printf("set events:  old %8.3f ms  new %8.3f ms\n", old_set, new_set);
+    printf("coverage:    old %8.3f ms  new %8.3f ms  (%.4f, %.4f)\n", old_cov, new_cov,
+           old_stats.calculateCoverage(), new_stats.calculateCoverage());
+    printf("unite:       %8.3f ms\n", unite);
+    printf("intersect:   %8.3f ms\n", intersect);
+
+    return 0;
+}
@@ -169,6 +169,29 @@ void Commons::loadConfig(const Poco::Util::AbstractConfiguration &config)
         _pconfig->log_messages = config.hasProperty("log_messages");
         _pconfig->log_queries = config.hasProperty("log_queries");
 
+        // server properties
+
+        if (config.hasProperty("server_port"))
+            _pconfig->server.port = config.getInt("server_port");
+        if (config.hasProperty("server_io_threads"))
+            _pconfig->server.io_threads = config.getInt("server_io_threads");
+        if (config.hasProperty("server_workers"))
+            _pconfig->server.workers = config.getInt("server_workers");
+        if (config.hasProperty("server_heavy_workers"))
+            _pconfig->server.heavy_workers = config.getInt("server_heavy_workers");
+        if (config.hasProperty("server_connections"))
+            _pconfig->server.connections = config.getInt("server_connections");
+        if (config.hasProperty("server_queue_size"))
+            _pconfig->server.queue_size = config.getInt("server_queue_size");
+        if (config.hasProperty("server_cache_size"))
+            _pconfig->server.cache_size = config.getInt("server_cache_size");
+        if (config.hasProperty("server_sequence_threads"))
+            _pconfig->server.sequence_threads = config.getInt("server_sequence_threads");
+        if (config.hasProperty("server_index_size"))
+            _pconfig->server.index_size = config.getInt("server_index_size");
+        if (config.hasProperty("server_descindex_size"))
+            _pconfig->server.descindex_size = config.getInt("server_descindex_size");
+
         // context properties
 
         if (config.hasProperty("dataset"))
@@ -205,6 +228,29 @@ void Commons::saveConfig(Poco::Util::AbstractConfiguration &config) const
     if (_pconfig->log_queries)
         config.setBool("log_queries", true);
 
+    // server properties
+
+    if (_pconfig->server.port > 0)
+        config.setInt("server_port", _pconfig->server.port);
+    if (_pconfig->server.io_threads > 0)
+        config.setInt("server_io_threads", _pconfig->server.io_threads);
+    if (_pconfig->server.workers > 0)
+        config.setInt("server_workers", _pconfig->server.workers);
+    if (_pconfig->server.heavy_workers > 0)
+        config.setInt("server_heavy_workers", _pconfig->server.heavy_workers);
+    if (_pconfig->server.connections > 0)
+        config.setInt("server_connections", _pconfig->server.connections);
+    if (_pconfig->server.queue_size > 0)
+        config.setInt("server_queue_size", _pconfig->server.queue_size);
+    if (_pconfig->server.cache_size != 0)
+        config.setInt("server_cache_size", _pconfig->server.cache_size);
+    if (_pconfig->server.sequence_threads > 0)
+        config.setInt("server_sequence_threads", _pconfig->server.sequence_threads);
+    if (_pconfig->server.index_size != 0)
+        config.setInt("server_index_size", _pconfig->server.index_size);
+    if (_pconfig->server.descindex_size != 0)
+        config.setInt("server_descindex_size", _pconfig->server.descindex_size);
+
     // context properties
 
     if (!_context.dataset.empty())
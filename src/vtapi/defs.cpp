@@ -4,6 +4,10 @@
 namespace vtapi {
 
 const int def_select_limit = 10000;
+const int def_select_stream_limit = 1000;
+const int def_insert_batch_limit = 500;
+const int def_output_async_pending = 2;
+const int def_count_estimate_min = 10000;
 
 const std::string def_val_video = "video";
 const std::string def_val_images = "images";
@@ -16,6 +20,9 @@ const std::string def_fnc_mt_delete = "public.VT_method_delete";
 const std::string def_fnc_task_create = "public.VT_task_create";
 const std::string def_fnc_task_delete = "public.VT_task_delete";
 const std::string def_fnc_event_filter = "public.VT_filtered_events";
+const std::string def_fnc_event_stats = "public.VT_task_output_stats";
+const std::string def_fnc_event_classes = "public.VT_task_output_classes";
+const std::string def_fnc_event_versions = "public.VT_task_output_versions";
 
 const std::string def_tab_datasets = "public.datasets";
 const std::string def_tab_methods = "public.methods";
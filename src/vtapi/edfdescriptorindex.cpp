@@ -0,0 +1,247 @@
+/**
+ * @file
+ * @brief   Methods of EdfDescriptorIndex class
+ *
+ * @author   Vojtech Froml, xfroml00 (at) stud.fit.vutbr.cz
+ * @author   Tomas Volf, ivolf (at) fit.vutbr.cz
+ *
+ * @licence   @ref licence "BUT OPEN SOURCE LICENCE (Version 1)"
+ *
+ * @copyright   &copy; 2011 &ndash; 2018, Brno University of Technology
+ */
+
+#include <vtapi/data/edfdescriptorindex.h>
+#include <algorithm>
+#include <utility>
+
+#define MAX_DESCRIPTOR_SIZE     65536   // squared distance fits unsigned int
+#define TRAIN_SAMPLES_PER_LIST  64      // k-means sample size
+#define TRAIN_ITERATIONS        10      // k-means iterations
+
+using namespace std;
+
+namespace vtapi {
+
+
+// squared euclidean distance of byte vectors, one pass without branches
+// (vectorized by compiler), all descriptors are compared by it
+static unsigned int distance(const unsigned char *a, const unsigned char *b, size_t dim)
+{
+    unsigned int sum = 0;
+    for (size_t i = 0; i < dim; i++) {
+        int d = static_cast<int>(a[i]) - static_cast<int>(b[i]);
+        sum += static_cast<unsigned int>(d * d);
+    }
+
+    return sum;
+}
+
+static size_t nearestCentroid(const vector<unsigned char> &centroids, size_t dim, const unsigned char *desc)
+{
+    size_t count = centroids.size() / dim;
+    size_t nearest = 0;
+    unsigned int nearest_dist = distance(centroids.data(), desc, dim);
+    for (size_t c = 1; c < count; c++) {
+        unsigned int dist = distance(centroids.data() + c * dim, desc, dim);
+        if (dist < nearest_dist) {
+            nearest = c;
+            nearest_dist = dist;
+        }
+    }
+
+    return nearest;
+}
+
+// ordering of neighbours, worse is greater
+static bool closer(const EdfDescriptorIndex::Neighbor &a, const EdfDescriptorIndex::Neighbor &b)
+{
+    return a.distance < b.distance || (a.distance == b.distance && a.event_id < b.event_id);
+}
+
+
+EdfDescriptorIndex::EdfDescriptorIndex()
+    : _version(0), _dim(0), _size(0), _trained_size(0), _lists(1, make_shared<List>())
+{
+}
+
+bool EdfDescriptorIndex::add(int event_id, const EyedeaEdfDescriptor &desc)
+{
+    if (desc.data.empty() || desc.data.size() > MAX_DESCRIPTOR_SIZE)
+        return false;
+
+    if (_dim == 0) {
+        _version = desc.version;
+        _dim = desc.data.size();
+    }
+    else if (desc.version != _version || desc.data.size() != _dim) {
+        return false;
+    }
+
+    addData(event_id, desc.data.data());
+
+    return true;
+}
+
+void EdfDescriptorIndex::addFrom(const EdfDescriptorIndex &other, int event_id)
+{
+    if (other._dim == 0 || (_dim != 0 && (other._version != _version || other._dim != _dim)))
+        return;
+
+    _version = other._version;
+    _dim = other._dim;
+
+    // lists are not ordered by IDs, new descriptors are collected first
+    vector< pair<int,const unsigned char*> > added;
+    for (const auto & list : other._lists) {
+        for (size_t i = 0; i < list->event_ids.size(); i++) {
+            if (list->event_ids[i] > event_id)
+                added.push_back(make_pair(list->event_ids[i], list->data.data() + i * _dim));
+        }
+    }
+    std::sort(added.begin(), added.end());
+
+    for (const auto & item : added)
+        addData(item.first, item.second);
+}
+
+void EdfDescriptorIndex::train(size_t lists)
+{
+    // all descriptors to one list (in order of lists), lists may be shared with copies
+    shared_ptr<List> all_ptr = make_shared<List>();
+    List &all = *all_ptr;
+    all.data.reserve(_size * _dim);
+    all.event_ids.reserve(_size);
+    for (const auto & list : _lists) {
+        all.data.insert(all.data.end(), list->data.begin(), list->data.end());
+        all.event_ids.insert(all.event_ids.end(), list->event_ids.begin(), list->event_ids.end());
+    }
+
+    _lists.clear();
+    _centroids.clear();
+    _trained_size = 0;
+
+    if (lists < 2 || _size < lists) {
+        _lists.push_back(std::move(all_ptr));
+        return;
+    }
+
+    // k-means on evenly spread sample, centroids start at evenly spread descriptors
+    size_t samples = std::min(_size, lists * TRAIN_SAMPLES_PER_LIST);
+    vector<unsigned char> centroids(lists * _dim);
+    for (size_t c = 0; c < lists; c++) {
+        const unsigned char *desc = all.data.data() + (c * _size / lists) * _dim;
+        std::copy(desc, desc + _dim, centroids.begin() + c * _dim);
+    }
+
+    vector<double> sums(lists * _dim);
+    vector<size_t> counts(lists);
+    for (int iter = 0; iter < TRAIN_ITERATIONS; iter++) {
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for (size_t s = 0; s < samples; s++) {
+            const unsigned char *desc = all.data.data() + (s * _size / samples) * _dim;
+            size_t c = nearestCentroid(centroids, _dim, desc);
+            double *sum = sums.data() + c * _dim;
+            for (size_t i = 0; i < _dim; i++)
+                sum[i] += desc[i];
+            counts[c]++;
+        }
+
+        // empty cluster keeps its centroid
+        for (size_t c = 0; c < lists; c++) {
+            if (counts[c] == 0)
+                continue;
+            for (size_t i = 0; i < _dim; i++)
+                centroids[c * _dim + i] = static_cast<unsigned char>(sums[c * _dim + i] / counts[c] + 0.5);
+        }
+    }
+
+    _centroids.swap(centroids);
+    _lists.resize(lists);
+    for (auto & list : _lists)
+        list = make_shared<List>();
+    for (size_t i = 0; i < all.event_ids.size(); i++) {
+        const unsigned char *desc = all.data.data() + i * _dim;
+        List &list = *_lists[nearestList(desc)];
+        list.data.insert(list.data.end(), desc, desc + _dim);
+        list.event_ids.push_back(all.event_ids[i]);
+    }
+    _trained_size = _size;
+}
+
+vector<EdfDescriptorIndex::Neighbor> EdfDescriptorIndex::search(const EyedeaEdfDescriptor &desc, size_t k,
+                                                                size_t probes) const
+{
+    vector<Neighbor> heap;    // k best so far, worst on top
+    if (k == 0 || _size == 0 || desc.version != _version || desc.data.size() != _dim)
+        return heap;
+
+    const unsigned char *query = desc.data.data();
+
+    // lists with nearest centroids, or all lists
+    vector<size_t> visit;
+    if (trained() && probes > 0 && probes < _lists.size()) {
+        vector< pair<unsigned int,size_t> > order(_lists.size());
+        for (size_t c = 0; c < _lists.size(); c++)
+            order[c] = make_pair(distance(_centroids.data() + c * _dim, query, _dim), c);
+        std::partial_sort(order.begin(), order.begin() + probes, order.end());
+        for (size_t i = 0; i < probes; i++)
+            visit.push_back(order[i].second);
+    }
+    else {
+        for (size_t c = 0; c < _lists.size(); c++)
+            visit.push_back(c);
+    }
+
+    heap.reserve(std::min(k, _size) + 1);
+    for (size_t l : visit) {
+        const List &list = *_lists[l];
+        const unsigned char *data = list.data.data();
+        for (size_t i = 0; i < list.event_ids.size(); i++) {
+            Neighbor neighbor = { list.event_ids[i], distance(data + i * _dim, query, _dim) };
+            if (heap.size() < k) {
+                heap.push_back(neighbor);
+                std::push_heap(heap.begin(), heap.end(), closer);
+            }
+            else if (closer(neighbor, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), closer);
+                heap.back() = neighbor;
+                std::push_heap(heap.begin(), heap.end(), closer);
+            }
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), closer);
+
+    return heap;
+}
+
+size_t EdfDescriptorIndex::bytes() const
+{
+    size_t size = sizeof(*this) + _centroids.capacity() + _lists.capacity() * (sizeof(List) + sizeof(_lists[0]));
+    for (const auto & list : _lists)
+        size += list->data.capacity() + list->event_ids.capacity() * sizeof(int);
+
+    return size;
+}
+
+size_t EdfDescriptorIndex::nearestList(const unsigned char *desc) const
+{
+    return nearestCentroid(_centroids, _dim, desc);
+}
+
+void EdfDescriptorIndex::addData(int event_id, const unsigned char *desc)
+{
+    // list shared with copies is copied first
+    shared_ptr<List> &list = _lists[trained() ? nearestList(desc) : 0];
+    if (list.use_count() > 1)
+        list = make_shared<List>(*list);
+
+    list->data.insert(list->data.end(), desc, desc + _dim);
+    list->event_ids.push_back(event_id);
+    _size++;
+}
+
+
+} // namespace vtapi
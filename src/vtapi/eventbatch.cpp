@@ -0,0 +1,266 @@
+#include <vtapi/common/exception.h>
+#include <vtapi/data/eventbatch.h>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cmath>
+
+#define SECONDS_PER_DAY     86400.0
+
+using namespace std;
+
+namespace vtapi {
+
+void EventBatch::reserve(size_t count)
+{
+    group_id.reserve(count);
+    is_root.reserve(count);
+    t1.reserve(count);
+    t2.reserve(count);
+    sec_length.reserve(count);
+    rt_start.reserve(count);
+    x_low.reserve(count);
+    y_low.reserve(count);
+    x_high.reserve(count);
+    y_high.reserve(count);
+}
+
+void EventBatch::clear()
+{
+    group_id.clear();
+    is_root.clear();
+    t1.clear();
+    t2.clear();
+    sec_length.clear();
+    rt_start.clear();
+    x_low.clear();
+    y_low.clear();
+    x_high.clear();
+    y_high.clear();
+}
+
+size_t EventBatch::bytes() const
+{
+    return group_id.capacity() * sizeof(int) +
+           is_root.capacity() * sizeof(unsigned char) +
+           (t1.capacity() + t2.capacity()) * sizeof(unsigned int) +
+           (sec_length.capacity() + rt_start.capacity() + x_low.capacity() +
+            y_low.capacity() + x_high.capacity() + y_high.capacity()) * sizeof(double);
+}
+
+void EventBatch::add(unsigned int t1, unsigned int t2, double sec_length,
+                     const chrono::system_clock::time_point &rt_start,
+                     const IntervalEvent &event)
+{
+    this->group_id.push_back(event.group_id);
+    this->is_root.push_back(event.is_root ? 1 : 0);
+    this->t1.push_back(t1);
+    this->t2.push_back(t2);
+    this->sec_length.push_back(sec_length);
+
+    if (rt_start.time_since_epoch() != chrono::system_clock::duration::zero()) {
+        auto usecs = chrono::duration_cast<chrono::microseconds>(rt_start.time_since_epoch());
+        this->rt_start.push_back(static_cast<double>(usecs.count()) / 1000000.0);
+    }
+    else {
+        this->rt_start.push_back(numeric_limits<double>::quiet_NaN());
+    }
+
+    this->x_low.push_back(std::min(event.region.low.x, event.region.high.x));
+    this->y_low.push_back(std::min(event.region.low.y, event.region.high.y));
+    this->x_high.push_back(std::max(event.region.low.x, event.region.high.x));
+    this->y_high.push_back(std::max(event.region.low.y, event.region.high.y));
+}
+
+
+EventBatchFilter::EventBatchFilter(const EventFilter &filter)
+    : _conditions(0),
+      _duration_low(0), _duration_high(0), _time_low(0), _time_high(0),
+      _daytime_low(0), _daytime_high(0), _x_low(0), _y_low(0), _x_high(0), _y_high(0)
+{
+    if (filter.hasDurationFilter()) {
+        EventFilter::Duration duration = filter.getDurationFilter();
+        if (duration._low > duration._high)
+            throw RuntimeException("Minimal duration cannot be greater than maximal duration");
+
+        _conditions |= COND_DURATION;
+        _duration_low = static_cast<double>(duration._low.count()) / 1000000.0;
+        _duration_high = static_cast<double>(duration._high.count()) / 1000000.0;
+    }
+
+    if (filter.hasTimeRangeFilter()) {
+        EventFilter::TimeRange timerange = filter.getTimeRangeFilter();
+        auto low = chrono::duration_cast<chrono::microseconds>(timerange._low.time_since_epoch());
+        auto high = chrono::duration_cast<chrono::microseconds>(timerange._high.time_since_epoch());
+
+        _conditions |= COND_TIMERANGE;
+        _time_low = static_cast<double>(low.count()) / 1000000.0;
+        _time_high = static_cast<double>(high.count()) / 1000000.0;
+    }
+
+    if (filter.hasDayTimeRangeFilter()) {
+        EventFilter::DayTimeRange daytime = filter.getDayTimeRangeFilter();
+
+        if (daytime._low > daytime._high)
+            throw RuntimeException("Minimal day time cannot be greater than maximal day time");
+
+        _conditions |= COND_DAYTIME;
+        _daytime_low = static_cast<double>(daytime._low.count()) / 1000000.0;
+        _daytime_high = static_cast<double>(daytime._high.count()) / 1000000.0;
+    }
+
+    if (filter.hasRegionFilter()) {
+        IntervalEvent::Box region = filter.getRegionFilter();
+
+        _conditions |= COND_REGION;
+        _x_low = std::min(region.low.x, region.high.x);
+        _y_low = std::min(region.low.y, region.high.y);
+        _x_high = std::max(region.low.x, region.high.x);
+        _y_high = std::max(region.low.y, region.high.y);
+    }
+}
+
+void EventBatchFilter::evaluate(const EventBatch &batch, vector<unsigned char> &mask) const
+{
+    evaluate(batch, _conditions, mask);
+}
+
+vector<int> EventBatchFilter::matchingGroups(const EventBatch &batch) const
+{
+    const size_t count = batch.size();
+    vector<unsigned char> mask;
+    vector<int> groups;
+
+    // duration and time conditions are evaluated on roots only
+    if (_conditions & COND_TIME) {
+        evaluate(batch, _conditions & COND_TIME, mask);
+        for (size_t i = 0; i < count; i++) {
+            if (mask[i] & batch.is_root[i])
+                groups.push_back(batch.group_id[i]);
+        }
+        std::sort(groups.begin(), groups.end());
+        groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+    }
+
+    // region condition is evaluated on all events
+    if (_conditions & COND_REGION) {
+        vector<int> region_groups;
+
+        evaluate(batch, COND_REGION, mask);
+        for (size_t i = 0; i < count; i++) {
+            if (mask[i])
+                region_groups.push_back(batch.group_id[i]);
+        }
+        std::sort(region_groups.begin(), region_groups.end());
+        region_groups.erase(std::unique(region_groups.begin(), region_groups.end()), region_groups.end());
+
+        if (_conditions & COND_TIME) {
+            vector<int> both;
+            std::set_intersection(groups.begin(), groups.end(),
+                                  region_groups.begin(), region_groups.end(),
+                                  std::back_inserter(both));
+            groups.swap(both);
+        }
+        else {
+            groups.swap(region_groups);
+        }
+    }
+
+    return groups;
+}
+
+vector<size_t> EventBatchFilter::select(const EventBatch &batch) const
+{
+    const size_t count = batch.size();
+    vector<size_t> indices;
+
+    if (empty()) {
+        indices.resize(count);
+        for (size_t i = 0; i < count; i++)
+            indices[i] = i;
+    }
+    else {
+        vector<int> groups = matchingGroups(batch);
+        if (!groups.empty()) {
+            for (size_t i = 0; i < count; i++) {
+                if (std::binary_search(groups.begin(), groups.end(), batch.group_id[i]))
+                    indices.push_back(i);
+            }
+        }
+    }
+
+    return indices;
+}
+
+void EventBatchFilter::evaluate(const EventBatch &batch, unsigned int conditions, vector<unsigned char> &mask) const
+{
+    // loops over raw arrays, each comparison clears mask by select
+    // (no short-circuit branches), so that compiler vectorizes them
+    const size_t count = batch.size();
+    mask.assign(count, 1);
+    unsigned char *m = mask.data();
+
+    // BETWEEN duration_low AND duration_high
+    if (conditions & COND_DURATION) {
+        const double *len = batch.sec_length.data();
+        const double low = _duration_low, high = _duration_high;
+        for (size_t i = 0; i < count; i++) {
+            unsigned char v = m[i];
+            v = len[i] >= low ? v : 0;
+            v = len[i] <= high ? v : 0;
+            m[i] = v;
+        }
+    }
+
+    // [rt_start, rt_start + sec_length] overlaps [time_low, time_high), unknown start never does
+    if (conditions & COND_TIMERANGE) {
+        const double *start = batch.rt_start.data();
+        const double *len = batch.sec_length.data();
+        const double low = _time_low, high = _time_high;
+        for (size_t i = 0; i < count; i++) {
+            unsigned char v = m[i];
+            v = start[i] < high ? v : 0;
+            v = start[i] + len[i] >= low ? v : 0;
+            m[i] = v;
+        }
+    }
+
+    // daytimenumrange(rt_start, sec_length) && [daytime_low, daytime_high]:
+    // start and end are times of day, end wraps over midnight (TIME + interval),
+    // so event crossing midnight has inverted range and never overlaps
+    // (database refuses it); floor is vectorized only with SSE4.1 and -fno-trapping-math
+    if (conditions & COND_DAYTIME) {
+        const double *start = batch.rt_start.data();
+        const double *len = batch.sec_length.data();
+        const double low = _daytime_low, high = _daytime_high;
+        const double day = SECONDS_PER_DAY;
+        for (size_t i = 0; i < count; i++) {
+            double start_time = start[i] - std::floor(start[i] / day) * day;
+            double end_time = start_time + len[i];
+            end_time -= std::floor(end_time / day) * day;
+            unsigned char v = m[i];
+            v = start_time <= high ? v : 0;
+            v = end_time >= low ? v : 0;
+            v = end_time >= start_time ? v : 0;
+            m[i] = v;
+        }
+    }
+
+    // region && box
+    if (conditions & COND_REGION) {
+        const double *xl = batch.x_low.data(), *yl = batch.y_low.data();
+        const double *xh = batch.x_high.data(), *yh = batch.y_high.data();
+        const double x_low = _x_low, y_low = _y_low, x_high = _x_high, y_high = _y_high;
+        for (size_t i = 0; i < count; i++) {
+            unsigned char v = m[i];
+            v = xl[i] <= x_high ? v : 0;
+            v = xh[i] >= x_low ? v : 0;
+            v = yl[i] <= y_high ? v : 0;
+            v = yh[i] >= y_low ? v : 0;
+            m[i] = v;
+        }
+    }
+}
+
+
+} // namespace vtapi
@@ -17,6 +17,7 @@
 #include <vtapi/data/sequence.h>
 #include <vtapi/data/interval.h>
 #include <utility>
+#include <algorithm>
 
 using namespace std;
 
@@ -30,12 +31,15 @@ Interval::Interval(const Interval &copy)
 {}
 
 Interval::Interval(const Commons& commons, const string& selection, const bool forceAll)
-    : KeyValues(commons, selection)
+    : KeyValues(commons, selection),
+    _key_id(def_col_int_id), _key_seqname(def_col_int_seqname),
+    _key_t1(def_col_int_t1), _key_t2(def_col_int_t2),
+    _key_seclength(def_col_int_seclength), _edfdesc_not_null(false)
 {
     if (_context.dataset.empty())
         throw BadConfigurationException("dataset not specified");
 
-    _select.setOrderBy(def_col_int_id);
+    _select.setKeyset({ def_col_int_id });
 
     if (! forceAll) {
         if (!_context.sequence.empty())
@@ -102,7 +106,7 @@ string Interval::getParentSequenceName() const
     if (!_context.sequence.empty())
         return _context.sequence;
     else
-        return this->getString(def_col_int_seqname);
+        return this->getString(this->getKeyIndex(_key_seqname));
 }
 
 Sequence *Interval::getParentSequence() const
@@ -126,17 +130,17 @@ Sequence *Interval::getParentSequence() const
 
 int Interval::getId() const
 {
-    return this->getInt(def_col_int_id);
+    return this->getInt(this->getKeyIndex(_key_id));
 }
 
 unsigned int Interval::getStartTime() const
 {
-    return this->getInt(def_col_int_t1);
+    return this->getInt(this->getKeyIndex(_key_t1));
 }
 
 unsigned int Interval::getEndTime() const
 {
-    return this->getInt(def_col_int_t2);
+    return this->getInt(this->getKeyIndex(_key_t2));
 }
 
 EyedeaEdfDescriptor Interval::getEdfDesc() const
@@ -186,7 +190,7 @@ chrono::system_clock::time_point Interval::calculateRealEndTime()
 
 double Interval::getLengthSeconds() const
 {
-    return this->getFloat8(def_col_int_seclength);
+    return this->getFloat8(this->getKeyIndex(_key_seclength));
 }
 
 bool Interval::preUpdate()
@@ -233,6 +237,71 @@ bool Interval::filterNotNullEdfDescriptor(const string &key) {
     return _select.querybuilder().whereKeyNull(key, false);
 }
 
+size_t Interval::loadEdfDescriptors(EdfDescriptorIndex &index)
+{
+    size_t count = 0;
+
+    if (!_edfdesc_not_null)
+        _edfdesc_not_null = filterNotNullEdfDescriptor(def_col_int_edfdesc);
+
+    setStreaming(true);
+    try {
+        while (nextPage()) {
+            vector<int> ids = getIntColumn(def_col_int_id);
+            vector<EyedeaEdfDescriptor> descs = getEdfDescriptorColumn(def_col_int_edfdesc);
+            for (size_t i = 0; i < descs.size(); i++) {
+                if (index.add(ids[i], descs[i]))
+                    count++;
+            }
+        }
+    }
+    catch (...) {
+        setStreaming(false);
+        throw;
+    }
+    setStreaming(false);
+
+    return count;
+}
+
+vector<EdfDescriptorIndex::Neighbor> Interval::findSimilarEdfDescriptors(const EyedeaEdfDescriptor &desc, size_t k)
+{
+    vector<EdfDescriptorIndex::Neighbor> result;
+    auto closer = [](const EdfDescriptorIndex::Neighbor &a, const EdfDescriptorIndex::Neighbor &b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.event_id < b.event_id);
+    };
+
+    if (!_edfdesc_not_null)
+        _edfdesc_not_null = filterNotNullEdfDescriptor(def_col_int_edfdesc);
+
+    // every page is searched separately, k nearest of each are merged
+    setStreaming(true);
+    try {
+        while (k > 0 && nextPage()) {
+            vector<int> ids = getIntColumn(def_col_int_id);
+            vector<EyedeaEdfDescriptor> descs = getEdfDescriptorColumn(def_col_int_edfdesc);
+
+            EdfDescriptorIndex page;
+            for (size_t i = 0; i < descs.size(); i++) {
+                if (descs[i].version == desc.version && descs[i].data.size() == desc.data.size())
+                    page.add(ids[i], descs[i]);
+            }
+
+            vector<EdfDescriptorIndex::Neighbor> nearest = page.search(desc, k);
+            result.insert(result.end(), nearest.begin(), nearest.end());
+            std::sort(result.begin(), result.end(), closer);
+            if (result.size() > k)
+                result.resize(k);
+        }
+    }
+    catch (...) {
+        setStreaming(false);
+        throw;
+    }
+    setStreaming(false);
+
+    return result;
+}
 
 //=================================== IMAGE ====================================
 
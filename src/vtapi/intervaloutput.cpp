@@ -1,5 +1,6 @@
 
 #include <exception>
+#include <iterator>
 #include <vtapi/common/global.h>
 #include <vtapi/common/exception.h>
 #include <vtapi/common/defs.h>
@@ -12,11 +13,25 @@ using namespace std;
 namespace vtapi {
 
 
+// intervals of the same shape (keys and their value types) may be batched
+static string batchShape(QueryBuilder &qb)
+{
+    string shape = qb.getInsertBatchQuery(1);
+    if (!shape.empty()) {
+        shape += '\0';
+        shape += qb.getCopyTypes();
+    }
+
+    return shape;
+}
+
 IntervalOutput::IntervalOutput(const Commons &commons,
                                const string &sequence,
                                const string &output,
-                               unsigned int cache_limit)
-    : Commons(commons, false), _cache_limit(cache_limit)
+                               unsigned int cache_limit,
+                               bool async)
+    : Commons(commons, false), _cache_limit(cache_limit), _copy(true),
+      _writer_stop(false), _writer_failed(false)
 {
     if (!sequence.empty())
         _context.sequence = sequence;
@@ -31,6 +46,35 @@ IntervalOutput::IntervalOutput(const Commons &commons,
         string error = "cannot create interval output without dataset, task, sequence or output table";
         throw BadConfigurationException(error);
     }
+
+    if (async) {
+        _writer = std::unique_ptr<IntervalOutput>(new IntervalOutput(*this));
+        _writer_thread = std::thread(&IntervalOutput::writerLoop, this);
+    }
+}
+
+IntervalOutput::IntervalOutput(const IntervalOutput &orig)
+    : Commons(orig, true), _cache_limit(0), _copy(orig._copy),
+      _writer_stop(false), _writer_failed(false)
+{
+}
+
+IntervalOutput::~IntervalOutput()
+{
+    if (_writer_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_writer_mtx);
+            _writer_stop = true;
+        }
+        _writer_cond.notify_all();
+        _writer_thread.join();
+    }
+}
+
+void IntervalOutput::setCopy(bool enable)
+{
+    std::lock_guard<std::mutex> lock(_writer_mtx);
+    _copy = enable;
 }
 
 bool IntervalOutput::newInterval(int t1, int t2)
@@ -38,12 +82,13 @@ bool IntervalOutput::newInterval(int t1, int t2)
     bool ret = true;
 
     if (_cache_limit > 0 && _inserts.size() >= _cache_limit)
-        ret = this->commit();
+        ret = _writer ? enqueue() : this->commit();
 
     if (ret) {
         _inserts.push_back(std::shared_ptr<Insert>(new Insert(*this, _context.selection)));
         Insert & i = last_insert();
 
+        i.querybuilder().setCopyCapture(true);
         ret &= i.querybuilder().keyString(def_col_int_taskname, _context.task);
         ret &= i.querybuilder().keyString(def_col_int_seqname, _context.sequence);
         ret &= i.querybuilder().keyInt(def_col_int_t1, t1);
@@ -67,26 +112,233 @@ bool IntervalOutput::commit()
 {
     bool ret = true;
 
-    if (_inserts.size() > 0) {
-        bool transaction = QueryBeginTransaction(*this).execute();
+    if (_writer) {
+        ret = enqueue();
+        ret &= waitWriter();
+    }
+    else if (_inserts.size() > 0) {
+        IntervalWrite write = prepare(_inserts, _copy);
+        ret = flush(write);
+        if (!ret) _inserts.swap(write._inserts);  // keep cache as it was
+    }
+
+    return ret;
+}
 
-        for (auto insert : _inserts) {
-            if (!(ret = insert->execute())) break;
+IntervalOutput::IntervalWrite IntervalOutput::prepare(InsertList &inserts, bool copy)
+{
+    IntervalWrite write;
+    write._inserts.swap(inserts);
+
+    // consecutive intervals with the same keys form one batch
+    string copy_shape;
+    bool same_shape = true;
+    auto it = write._inserts.begin();
+    while (it != write._inserts.end()) {
+        QueryBuilder & first = (*it)->querybuilder();
+        string shape = batchShape(first);
+        InsertBatch batch;
+        batch._rows = 0;
+
+        if (!shape.empty()) {
+            auto batch_start = it;
+            while (it != write._inserts.end() &&
+                   batch._rows < static_cast<unsigned int>(def_insert_batch_limit) &&
+                   batchShape((*it)->querybuilder()) == shape)
+            {
+                ++it;
+                batch._rows++;
+            }
+            batch._query = first.getInsertBatchQuery(batch._rows);
+
+            // too many parameters for one query, insert single interval
+            if (batch._query.empty() && batch._rows > 1) {
+                it = std::next(batch_start);
+                batch._rows = 1;
+                batch._query = first.getInsertBatchQuery(1);
+            }
+            batch._types = first.getCopyTypes();
+        }
+
+        // interval which cannot be batched is inserted with its own parameters
+        if (batch._query.empty() || batch._types.empty()) {
+            batch._query = (*it)->getQuery();
+            batch._types.clear();
+            batch._rows = 1;
+            ++it;
+            same_shape = false;
         }
+        else if (write._batches.empty()) {
+            copy_shape = shape;
+        }
+        else if (shape != copy_shape) {
+            same_shape = false;
+        }
+
+        write._batches.push_back(std::move(batch));
+    }
+
+    // bulk copy is possible only when all intervals have the same keys
+    // (and their values types match column types)
+    if (copy && same_shape && !write._inserts.empty())
+        write._copy_query = write._inserts.front()->querybuilder().getCopyQuery();
 
-        if (transaction) {
-            if (ret)
-                QueryCommitTransaction(*this).execute();
-            else
+    return write;
+}
+
+bool IntervalOutput::flush(IntervalWrite &write)
+{
+    bool ret = true;
+
+    bool transaction = QueryBeginTransaction(*this).execute();
+
+    if (!write._copy_query.empty()) {
+        ret = flushCopy(write);
+        if (!ret) {
+            // failed copy aborts transaction, intervals are inserted in new one
+            VTLOG_WARNING("Bulk copy of intervals failed, inserting them instead");
+            if (transaction) {
                 QueryRollbackTransaction(*this).execute();
+                transaction = QueryBeginTransaction(*this).execute();
+            }
+            ret = flushBatches(write);
+        }
+    }
+    else {
+        ret = flushBatches(write);
+    }
+
+    if (transaction) {
+        if (ret)
+            QueryCommitTransaction(*this).execute();
+        else
+            QueryRollbackTransaction(*this).execute();
+    }
+
+    return ret;
+}
+
+bool IntervalOutput::flushCopy(IntervalWrite &write)
+{
+    string data;
+
+    for (auto insert : write._inserts) {
+        if (!insert->querybuilder().appendCopyRow(data))
+            return false;
+    }
+
+    return connection().copyFrom(write._copy_query, data);
+}
+
+bool IntervalOutput::flushBatches(IntervalWrite &write)
+{
+    // single intervals are executed by pipeline on this object's connection
+    // (inserts may come from the other one)
+    vector< pair<string, void *> > singles;
+    auto it = write._inserts.begin();
+
+    for (const InsertBatch & batch : write._batches) {
+        if (batch._types.empty()) {
+            singles.push_back(std::make_pair(batch._query, (*it)->querybuilder().getQueryParam()));
+            ++it;
+            continue;
         }
 
-        if (ret) discard(true);
+        // keep order of inserts
+        if (!singles.empty()) {
+            if (!connection().executePipeline(singles))
+                return false;
+            singles.clear();
+        }
+
+        string data;
+        for (unsigned int r = 0; r < batch._rows; r++, ++it) {
+            if (!(*it)->querybuilder().appendCopyRow(data))
+                return false;
+        }
+        if (!connection().executeBatch(batch._query, batch._types, data))
+            return false;
     }
 
+    return singles.empty() || connection().executePipeline(singles);
+}
+
+bool IntervalOutput::enqueue()
+{
+    // queries are built here, with this object's connection
+    IntervalWrite write;
+    if (!_inserts.empty()) {
+        bool copy;
+        {
+            std::lock_guard<std::mutex> lock(_writer_mtx);
+            copy = _copy;
+        }
+        write = prepare(_inserts, copy);
+    }
+
+    std::unique_lock<std::mutex> lock(_writer_mtx);
+
+    // back-pressure: wait until writer catches up
+    _writer_cond.wait(lock, [this] {
+        return _pending.size() < static_cast<size_t>(def_output_async_pending);
+    });
+
+    if (!write._inserts.empty()) {
+        _pending.push_back(std::move(write));
+        _writer_cond.notify_all();
+    }
+
+    // report error from previously written buffer
+    bool ret = !_writer_failed;
+    _writer_failed = false;
+
     return ret;
 }
 
+bool IntervalOutput::waitWriter()
+{
+    std::unique_lock<std::mutex> lock(_writer_mtx);
+
+    _writer_cond.wait(lock, [this] { return _pending.empty(); });
+
+    bool ret = !_writer_failed;
+    _writer_failed = false;
+
+    return ret;
+}
+
+void IntervalOutput::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(_writer_mtx);
+
+    while (true) {
+        _writer_cond.wait(lock, [this] { return _writer_stop || !_pending.empty(); });
+        if (_pending.empty()) break;
+
+        // list element stays valid while other buffers are appended
+        IntervalWrite & write = _pending.front();
+
+        lock.unlock();
+        bool ret = false;
+        try {
+            ret = _writer->flush(write);
+        }
+        catch (std::exception &e) {
+            VTLOG_ERROR(e.what());
+        }
+        if (!ret) {
+            VTLOG_ERROR("Asynchronous commit of " + toString(write._inserts.size()) +
+                        " intervals failed: " + _writer->connection().getErrorMessage());
+        }
+        write._inserts.clear();
+        lock.lock();
+
+        if (!ret) _writer_failed = true;
+        _pending.pop_front();
+        _writer_cond.notify_all();
+    }
+}
+
 bool IntervalOutput::discard(bool only_cached)
 {
     bool ret = true;
@@ -94,6 +346,9 @@ bool IntervalOutput::discard(bool only_cached)
     _inserts.clear();
 
     if (!only_cached) {
+        // pending intervals must be written before deleting
+        if (_writer) waitWriter();
+
         Delete d(*this, _context.selection);
         ret &= d.querybuilder().whereString(def_col_int_taskname, _context.task);
         ret &= d.querybuilder().whereString(def_col_int_seqname, _context.sequence);
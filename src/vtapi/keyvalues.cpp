@@ -16,6 +16,8 @@
 #include <vtapi/common/defs.h>
 #include <vtapi/data/keyvalues.h>
 #include <utility>
+#include <algorithm>
+#include <cstdlib>
 
 using namespace std;
 
@@ -58,7 +60,7 @@ bool KeyValues::next()
     // use previous resultset
     else {
         // check SELECT limit, should new resultset be fetched?
-        if (def_select_limit > 0 && _select.resultset().getPosition() + 1 >= def_select_limit) {
+        if (_select.getLimit() > 0 && _select.resultset().getPosition() + 1 >= _select.getLimit()) {
             if (!_select.executeNext() || _select.resultset().countRows() == 0) {
                 _select.resultset().setPosition(-1);
                 return false;
@@ -82,18 +84,75 @@ bool KeyValues::next()
     }
 }
 
-int KeyValues::count()
+bool KeyValues::nextPage()
 {
-    int cnt = -1;
+    // UPDATE data is handled automatically here
+    if (_pupdate && !updateExecute())
+        return false;
+
+    bool ok = false;
+    ResultSet &rs = _select.resultset();
+
+    // first page
+    if (rs.getPosition() == -1)
+        ok = _select.execute();
+    // following page only if the previous one was full
+    else if (_select.getLimit() > 0 && rs.countRows() >= _select.getLimit())
+        ok = _select.executeNext();
+
+    if (!ok || rs.countRows() == 0) {
+        rs.setPosition(-1);
+        return false;
+    }
+    else {
+        // whole page is consumed at once
+        rs.setPosition(rs.countRows() - 1);
+        return true;
+    }
+}
+
+long long KeyValues::count(CountMode mode, bool *estimated)
+{
+    if (estimated) *estimated = false;
+
+    if (mode == COUNT_ESTIMATE) {
+        // planner estimates of small (or never analyzed) tables are poor,
+        // so objects are counted exactly, but only up to the limit
+        long long cnt = countQuery(_select.querybuilder().getCountLimitQuery(def_count_estimate_min), false);
+        if (cnt < def_count_estimate_min)
+            return cnt;
+
+        long long est = countQuery(_select.querybuilder().getCountEstimateQuery(), true);
+        if (est < 0)
+            return est;
+
+        if (estimated) *estimated = true;
+        return std::max(cnt, est);
+    }
+
+    return countQuery(_select.querybuilder().getCountQuery(), false);
+}
+
+long long KeyValues::countQuery(const std::string& query, bool estimate)
+{
+    long long cnt = -1;
 
-    std::string query   = _select.querybuilder().getCountQuery();
     void *param         = _select.querybuilder().getQueryParam();
     void *paramDup      = _select.querybuilder().duplicateQueryParam(param);
     ResultSet *res      = backend().createResultSet(connection().getDBTypes());
 
     if (connection().fetch(query, paramDup, *res) > 0) {
         res->setPosition(0);
-        cnt = res->getInt8(0);
+        if (estimate) {
+            // first row of plan is top node: "... (cost=0.00..1.00 rows=N width=4)"
+            std::string plan = res->getString(0);
+            size_t pos = plan.find(" rows=");
+            if (pos != std::string::npos)
+                cnt = std::strtoll(plan.c_str() + pos + 6, NULL, 10);
+        }
+        else {
+            cnt = res->getInt8(0);
+        }
     }
 
     if (paramDup) _select.querybuilder().destroyQueryParam(paramDup);
@@ -102,6 +161,12 @@ int KeyValues::count()
     return cnt;
 }
 
+void KeyValues::setStreaming(bool enable)
+{
+    _select.setStreaming(enable);
+    _select.setLimit(enable ? def_select_stream_limit : def_select_limit);
+}
+
 Update &KeyValues::update()
 {
     if (!_pupdate) {
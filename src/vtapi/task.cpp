@@ -11,10 +11,12 @@
  */
 
 #include <exception>
+#include <list>
 #include <vtapi/common/global.h>
 #include <vtapi/common/exception.h>
 #include <vtapi/common/defs.h>
 #include <vtapi/queries/insert.h>
+#include <vtapi/queries/pipeline.h>
 #include <vtapi/queries/delete.h>
 #include <vtapi/queries/predefined.h>
 #include <vtapi/data/task.h>
@@ -172,6 +174,41 @@ Interval *Task::loadOutputData(std::string outputDataTable) const
     return new Interval(*this, std::string(this->getParentDataset()->getName() + "." + outputDataTable), true);
 }
 
+bool Task::getOutputStats(const string& key,
+                          const vector<string>& seqnames,
+                          const EventFilter *filter,
+                          vector<QueryEventsStats::Stats>& stats) const
+{
+    QueryEventsStats q(*this, this->getOutputDataTable(), key, this->getName(), seqnames, filter);
+    if (!q.execute())
+        return false;
+
+    stats = q.getStats();
+    return true;
+}
+
+bool Task::getOutputClassOccurrences(const vector<string>& seqnames,
+                                     map<int,double>& occurrences) const
+{
+    QueryClassOccurrences q(*this, this->getOutputDataTable(), this->getName(), seqnames);
+    if (!q.execute())
+        return false;
+
+    occurrences = q.getOccurrences();
+    return true;
+}
+
+bool Task::getOutputVersions(const vector<string>& seqnames,
+                             vector<QueryEventsVersions::Version>& versions) const
+{
+    QueryEventsVersions q(*this, this->getOutputDataTable(), this->getName(), seqnames);
+    if (!q.execute())
+        return false;
+
+    versions = q.getVersions();
+    return true;
+}
+
 Process* Task::loadProcesses(int id) const
 {
     return (new Process(*this, id));
@@ -229,16 +266,18 @@ Process* Task::createProcess(const vector<string>& seqnames) const
                     retval &= update.execute();
                 }
                 else {
+                    // independent inserts, send them at once
+                    list<Insert> inserts;
+                    QueryPipeline pipeline(*this);
                     for (auto & item : seqnames) {
-                        Insert insert2(*this, def_tab_processes_seq);
+                        inserts.emplace_back(static_cast<const Commons&>(*this), def_tab_processes_seq);
+                        Insert & insert2 = inserts.back();
                         retval &= insert2.querybuilder().keyInt(def_col_prss_prsid, prsid);
                         retval &= insert2.querybuilder().keyString(def_col_prss_seqname, item);
-                        if (retval && (retval = insert2.execute())) {
-                        }
-                        else {
-                            break;
-                        }
+                        if (!retval) break;
+                        pipeline.add(insert2);
                     }
+                    if (retval) retval = pipeline.execute();
                 }
 
                 delete mt;
@@ -44,7 +44,17 @@ namespace vtapi {
     ADD_OPTION_ARG(opts, cfg, "logfile", "file", "log file location");\
     ADD_OPTION(opts, cfg, "log_errors", "log error messages");\
     ADD_OPTION(opts, cfg, "log_warnings", "log warning messages");\
-    ADD_OPTION(opts, cfg, "log_debug", "log debug messages");
+    ADD_OPTION(opts, cfg, "log_debug", "log debug messages");\
+    ADD_OPTION_ARG(opts, cfg, "server_port", "port", "VTServer TCP port");\
+    ADD_OPTION_ARG(opts, cfg, "server_io_threads", "count", "VTServer ZeroMQ IO threads");\
+    ADD_OPTION_ARG(opts, cfg, "server_workers", "count", "VTServer worker threads");\
+    ADD_OPTION_ARG(opts, cfg, "server_heavy_workers", "count", "VTServer workers for heavy requests");\
+    ADD_OPTION_ARG(opts, cfg, "server_connections", "count", "VTServer database connections");\
+    ADD_OPTION_ARG(opts, cfg, "server_queue_size", "count", "VTServer max. queued requests");\
+    ADD_OPTION_ARG(opts, cfg, "server_cache_size", "MB", "VTServer response cache size (-1 = disabled)");\
+    ADD_OPTION_ARG(opts, cfg, "server_sequence_threads", "count", "VTServer threads processing sequences of one request");\
+    ADD_OPTION_ARG(opts, cfg, "server_index_size", "MB", "VTServer spatial indexes memory (-1 = not kept)");\
+    ADD_OPTION_ARG(opts, cfg, "server_descindex_size", "MB", "VTServer descriptor indexes memory (-1 = not kept)");
 
 
 VTApi::VTApi(int argc, char** argv)
@@ -222,5 +232,24 @@ Process *VTApi::getRunnableProcess() const
     return prs;
 }
 
+const ServerConfig& VTApi::getServerConfig() const
+{
+    return _pcommons->config().server;
+}
+
+bool VTApi::checkConnection(bool reconnect) const
+{
+    Connection & conn = _pcommons->connection();
+
+    if (conn.isConnected())
+        return true;
+    else if (!reconnect)
+        return false;
+
+    VTLOG_WARNING("Database connection lost, reconnecting");
+    conn.disconnect();
+    return conn.connect();
+}
+
 
 }
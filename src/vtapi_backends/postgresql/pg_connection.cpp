@@ -1,9 +1,16 @@
 
 #include <cstdarg>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <vector>
 #include <vtapi/common/global.h>
 #include "pg_connection.h"
+#include "pg_copy.h"
 
 #define PG_FORMAT 1   // postgres data transfer format: 0=text, 1=binary
+#define PG_STMT_CACHE_SIZE 256  // max. prepared statements per connection
+#define PG_PIPELINE_SIZE 256    // max. queries sent before pipeline sync
 
 #define PGCONN ((PGconn *)_conn)
 
@@ -48,9 +55,12 @@ bool PGConnection::connect()
 
 void PGConnection::disconnect ()
 {
-    if (isConnected()) {
+    // also broken connection must be freed
+    if (PGCONN) {
         VTLOG_MESSAGE("Disconnecting DB : " + _connection_info);
 
+        clearStatements();
+        _column_types.clear();
         PQclearTypes(PGCONN);
         PQfinish(PGCONN);
         _conn = NULL;
@@ -62,6 +72,14 @@ bool PGConnection::isConnected () const
     return (PGCONN && PQstatus(PGCONN) == CONNECTION_OK);
 }
 
+bool PGConnection::isInTransaction() const
+{
+    if (!PGCONN) return false;
+
+    PGTransactionStatusType status = PQtransactionStatus(PGCONN);
+    return (status == PQTRANS_INTRANS || status == PQTRANS_INERROR);
+}
+
 bool PGConnection::execute(const string& query, void *param)
 {
     PGresult    *pgres  = NULL;
@@ -71,10 +89,7 @@ bool PGConnection::execute(const string& query, void *param)
 
     _error_message.clear();
 
-    if (param)
-        pgres = PQparamExec(PGCONN, (PGparam *) param, query.c_str(), PG_FORMAT);
-    else
-        pgres = PQexecf(PGCONN, query.c_str(), PG_FORMAT);
+    pgres = execParam(query, param);
 
     if (!pgres) {
         _error_message = PQgeterror();
@@ -98,6 +113,101 @@ bool PGConnection::execute(const string& query, void *param)
     return retval;
 }
 
+bool PGConnection::executePipeline(const vector< pair<string, void *> >& queries)
+{
+    bool retval = true;
+
+    _error_message.clear();
+
+    // pipeline is synced in parts, all queries are run in one transaction
+    // so that they are not committed partially (user's one, if there is any)
+    bool transaction = !isInTransaction();
+    if (transaction && !execute("BEGIN;", NULL))
+        return false;
+
+#ifdef LIBPQ_HAS_PIPELINING
+    for (size_t start = 0; retval && start < queries.size(); start += PG_PIPELINE_SIZE) {
+        size_t end = std::min(queries.size(), start + PG_PIPELINE_SIZE);
+        size_t sent = 0;
+
+        if (!PQenterPipelineMode(PGCONN)) {
+            _error_message = PQerrorMessage(PGCONN);
+            VTLOG_ERROR(_error_message);
+            retval = false;
+            break;
+        }
+
+        // send queries
+        for (size_t i = start; i < end; i++) {
+            const string & query = queries[i].first;
+            PGQueryParam *qparam = (PGQueryParam *) queries[i].second;
+
+            VTLOG_QUERY(query);
+
+            int sendret = qparam ?
+                PQparamSendQuery(PGCONN, qparam->_param, query.c_str(), PG_FORMAT) :
+                PQsendQueryParams(PGCONN, query.c_str(), 0, NULL, NULL, NULL, NULL, PG_FORMAT);
+            if (!sendret) {
+                _error_message = qparam ? PQgeterror() : PQerrorMessage(PGCONN);
+                VTLOG_ERROR(_error_message);
+                retval = false;
+                break;
+            }
+            sent++;
+        }
+
+        if (!PQpipelineSync(PGCONN)) {
+            _error_message = PQerrorMessage(PGCONN);
+            VTLOG_ERROR(_error_message);
+            retval = false;
+        }
+
+        // collect results of sent queries, every one is terminated by NULL
+        for (size_t i = 0; i < sent; i++) {
+            PGresult *pgres = NULL;
+            while ((pgres = PQgetResult(PGCONN)) != NULL) {
+                int result = PQresultStatus(pgres);
+                if (result == PGRES_PIPELINE_ABORTED) {
+                    // skipped after previous error
+                    retval = false;
+                }
+                else if (result != PGRES_TUPLES_OK &&
+                         result != PGRES_COMMAND_OK &&
+                         result != PGRES_NONFATAL_ERROR) {
+                    _error_message = PQresultErrorMessage(pgres);
+                    VTLOG_ERROR(_error_message);
+                    retval = false;
+                }
+                PQclear(pgres);
+            }
+        }
+
+        // pipeline sync result
+        PGresult *pgres = PQgetResult(PGCONN);
+        if (pgres) PQclear(pgres);
+
+        PQexitPipelineMode(PGCONN);
+    }
+#else
+    // libpq without pipeline mode => sequential execution
+    for (const auto & query : queries) {
+        if (!(retval = execute(query.first, query.second)))
+            break;
+    }
+#endif
+
+    if (transaction) {
+        // keep error message of failed query
+        string error = _error_message;
+        if (!execute(retval ? "COMMIT;" : "ROLLBACK;", NULL))
+            retval = false;
+        else if (!retval)
+            _error_message = error;
+    }
+
+    return retval;
+}
+
 int PGConnection::fetch(const string& query, void *param, ResultSet &resultSet)
 {
     int retval  = -1;
@@ -107,10 +217,7 @@ int PGConnection::fetch(const string& query, void *param, ResultSet &resultSet)
 
     _error_message.clear();
 
-    if (param)
-        pgres = PQparamExec(PGCONN, (PGparam *) param, query.c_str(), PG_FORMAT);
-    else
-        pgres = PQexecf(PGCONN, query.c_str(), PG_FORMAT);
+    pgres = execParam(query, param);
 
     resultSet.newResult((void *) pgres);
 
@@ -136,6 +243,245 @@ int PGConnection::fetch(const string& query, void *param, ResultSet &resultSet)
     return retval;
 }
 
+PGresult *PGConnection::execParam(const string& query, void *param)
+{
+    PGresult *pgres = NULL;
+
+    if (!param) {
+        pgres = PQexecf(PGCONN, query.c_str(), PG_FORMAT);
+    }
+    else {
+        PGQueryParam *qparam = (PGQueryParam *) param;
+
+        string stmt = getPreparedStatement(query, *qparam);
+        if (!stmt.empty())
+            pgres = PQparamExecPrepared(PGCONN, qparam->_param, stmt.c_str(), PG_FORMAT);
+        else
+            pgres = PQparamExec(PGCONN, qparam->_param, query.c_str(), PG_FORMAT);
+    }
+    updateTransactionSerial();
+
+    return pgres;
+}
+
+string PGConnection::getPreparedStatement(const string& query, const PGQueryParam &param)
+{
+    string key = query;
+    key += '\0';
+    key += param._types;
+
+    auto it = _stmt_index.find(key);
+
+    // first occurence => only remember query, one-off queries are not worth preparing
+    if (it == _stmt_index.end()) {
+        _stmt_cache_misses++;
+
+        _stmt_lru.push_front(make_pair(key, PreparedStatement()));
+        _stmt_index[key] = _stmt_lru.begin();
+
+        if (_stmt_lru.size() > PG_STMT_CACHE_SIZE) {
+            const auto & lru = _stmt_lru.back();
+            if (!lru.second._name.empty()) {
+                PGresult *pgres = PQexec(PGCONN, ("DEALLOCATE " + lru.second._name + ';').c_str());
+                if (pgres) PQclear(pgres);
+            }
+            _stmt_index.erase(lru.first);
+            _stmt_lru.pop_back();
+        }
+
+        return string();
+    }
+
+    _stmt_lru.splice(_stmt_lru.begin(), _stmt_lru, it->second);
+    PreparedStatement & stmt = it->second->second;
+
+    if (!stmt._name.empty()) {
+        _stmt_cache_hits++;
+        return stmt._name;
+    }
+
+    _stmt_cache_misses++;
+
+    // repeated query => prepare it, but only outside of transaction block
+    // (failed PREPARE would abort user's transaction)
+    if (stmt._preparable && PQtransactionStatus(PGCONN) == PQTRANS_IDLE) {
+        vector<Oid> oids;
+        if (getParamTypes(param._types, oids) && (int)oids.size() == PQparamCount(param._param)) {
+            string name = "vtapi_stmt_" + toString(++_stmt_counter);
+            PGresult *pgres = PQprepare(PGCONN, name.c_str(), query.c_str(), oids.size(), oids.data());
+            if (pgres && PQresultStatus(pgres) == PGRES_COMMAND_OK)
+                stmt._name = name;
+            if (pgres) PQclear(pgres);
+        }
+
+        if (stmt._name.empty()) {
+            VTLOG_WARNING("Failed to prepare statement, query will be executed directly");
+            stmt._preparable = false;
+        }
+    }
+
+    return stmt._name;
+}
+
+bool PGConnection::getParamTypes(const string& types, vector<Oid>& oids) const
+{
+    istringstream iss(types);
+    string spec;
+
+    while (iss >> spec) {
+        // "%public.name" => "name"
+        if (spec[0] == '%')
+            spec.erase(0, 1);
+        size_t dot = spec.find('.');
+        if (dot != string::npos)
+            spec.erase(0, dot + 1);
+
+        auto it = _type_oids.find(spec);
+        if (it == _type_oids.end())
+            return false;
+        oids.push_back(it->second);
+    }
+
+    return true;
+}
+
+const unordered_map<string, Oid> * PGConnection::getColumnTypes(const string& table)
+{
+    auto it = _column_types.find(table);
+    if (it != _column_types.end())
+        return &it->second;
+
+    const char *values[] = { table.c_str() };
+    PGresult *pgres = PQexecParams(PGCONN,
+        "SELECT attname, atttypid FROM pg_catalog.pg_attribute\n"
+        "WHERE attrelid = $1::regclass AND attnum > 0 AND NOT attisdropped;",
+        1, NULL, values, NULL, NULL, 0);
+    if (!pgres || PQresultStatus(pgres) != PGRES_TUPLES_OK) {
+        VTLOG_WARNING("Failed to load column types of table " + table + ": " + PQerrorMessage(PGCONN));
+        if (pgres) PQclear(pgres);
+        return NULL;
+    }
+
+    unordered_map<string, Oid> & types = _column_types[table];
+    int ntuples = PQntuples(pgres);
+    for (int i = 0; i < ntuples; i++)
+        types[PQgetvalue(pgres, i, 0)] = (Oid) strtoul(PQgetvalue(pgres, i, 1), NULL, 10);
+    PQclear(pgres);
+
+    return &types;
+}
+
+void PGConnection::clearStatements()
+{
+    // statements are deallocated by server when connection is closed
+    _stmt_lru.clear();
+    _stmt_index.clear();
+}
+
+bool PGConnection::copyFrom(const string& query, const string& data)
+{
+    PGresult    *pgres  = NULL;
+    bool        retval  = true;
+
+    VTLOG_QUERY(query);
+
+    _error_message.clear();
+
+    do {
+        pgres = PQexec(PGCONN, query.c_str());
+        if (!pgres || PQresultStatus(pgres) != PGRES_COPY_IN) {
+            _error_message = PQerrorMessage(PGCONN);
+            VTLOG_ERROR(_error_message);
+            retval = false;
+            break;
+        }
+        PQclear(pgres);
+        pgres = NULL;
+
+        // whole copy stream = header + rows + trailer
+        string header, trailer;
+        PGCopyEncoder::putHeader(header);
+        PGCopyEncoder::putTrailer(trailer);
+
+        retval = PQputCopyData(PGCONN, header.data(), header.size()) == 1 &&
+                 PQputCopyData(PGCONN, data.data(), data.size()) == 1 &&
+                 PQputCopyData(PGCONN, trailer.data(), trailer.size()) == 1;
+
+        // on failure, abort the copy so that the connection is usable again
+        if (PQputCopyEnd(PGCONN, retval ? NULL : "vtapi copy failed") != 1)
+            retval = false;
+
+        // fetch copy result, all results must be consumed
+        while ((pgres = PQgetResult(PGCONN)) != NULL) {
+            if (PQresultStatus(pgres) != PGRES_COMMAND_OK)
+                retval = false;
+            PQclear(pgres);
+        }
+
+        if (!retval) {
+            _error_message = PQerrorMessage(PGCONN);
+            VTLOG_ERROR(_error_message);
+        }
+    } while (0);
+
+    if (pgres) PQclear(pgres);
+    updateTransactionSerial();
+
+    return retval;
+}
+
+bool PGConnection::executeBatch(const string& query, const string& types, const string& data)
+{
+    PGresult    *pgres  = NULL;
+    bool        retval  = true;
+    vector<const char *> values;
+    vector<int> lengths;
+    vector<Oid> row_oids;
+
+    VTLOG_QUERY(query);
+
+    _error_message.clear();
+
+    if (!PGCopyEncoder::getFields(data, values, lengths)) {
+        _error_message = "Invalid batch data";
+        VTLOG_ERROR(_error_message);
+        return false;
+    }
+
+    if (!getParamTypes(types, row_oids) || row_oids.empty() || values.size() % row_oids.size() != 0) {
+        _error_message = "Invalid batch value types: " + types;
+        VTLOG_ERROR(_error_message);
+        return false;
+    }
+
+    // values are in binary format of their types, server casts them to column types
+    vector<Oid> oids;
+    oids.reserve(values.size());
+    while (oids.size() < values.size())
+        oids.insert(oids.end(), row_oids.begin(), row_oids.end());
+
+    vector<int> formats(values.size(), 1);
+    pgres = PQexecParams(PGCONN, query.c_str(), values.size(), oids.data(),
+                         values.data(), lengths.data(), formats.data(), PG_FORMAT);
+    updateTransactionSerial();
+
+    if (!pgres) {
+        _error_message = PQerrorMessage(PGCONN);
+        VTLOG_ERROR(_error_message);
+        retval = false;
+    }
+    else {
+        if (PQresultStatus(pgres) != PGRES_COMMAND_OK) {
+            _error_message = PQerrorMessage(PGCONN);
+            VTLOG_ERROR(_error_message);
+            retval = false;
+        }
+        PQclear(pgres);
+    }
+
+    return retval;
+}
+
 bool PGConnection::loadDBTypes()
 {
     bool retval = true;
@@ -207,6 +553,7 @@ bool PGConnection::loadDBTypes()
                        0, &oid, 1, &name, 2, &cat, 3, &length, 4, &oid_elem);
 
             def._name = name;
+            _type_oids.insert(make_pair(def._name, (Oid) oid));
 
             // get type category and flags
             getTypeCategoryFlags(cat, def._name, def._category, def._flags);
@@ -222,6 +569,7 @@ bool PGConnection::loadDBTypes()
             DatabaseTypes::TypeDefinition &def_arr = _dbtypes.type(oid_item.first);
             DatabaseTypes::TypeDefinition &def_elem = _dbtypes.type(oid_item.second);
             def_arr._name = def_elem._name;
+            _type_oids[def_elem._name + "[]"] = (Oid) oid_item.first;
             def_arr._flags |= def_elem._flags;
             def_arr._length = def_elem._length;
         }
@@ -3,10 +3,33 @@
 #include <vtapi/plugins/backend_connection.h>
 #include <libpq-fe.h>
 #include <libpqtypes.h>
+#include <list>
+#include <unordered_map>
 
 namespace vtapi {
 
 
+/**
+ * @brief Query parameters created by PGQueryBuilder and executed by PGConnection
+ */
+class PGQueryParam
+{
+public:
+    PGparam *_param;        /**< parameter values */
+    std::string _types;     /**< parameter type specifiers (space separated) */
+
+    explicit PGQueryParam(PGparam *param)
+        : _param(param) {}
+
+    ~PGQueryParam()
+    { if (_param) PQparamClear(_param); }
+
+private:
+    PGQueryParam(const PGQueryParam&) = delete;
+    PGQueryParam & operator=(const PGQueryParam&) = delete;
+};
+
+
 class PGConnection : public Connection
 {
 public:
@@ -31,6 +54,12 @@ public:
      */
     bool isConnected() const override;
 
+    /**
+     * Checks if connection is inside explicit transaction block
+     * @return transaction is open (or failed and not ended yet)
+     */
+    bool isInTransaction() const override;
+
     /**
      * Executes query without fetching any result set
      * @param query SQL query string
@@ -39,6 +68,16 @@ public:
      */
     bool execute(const std::string& query, void *param) override;
 
+    /**
+     * Executes independent queries without waiting for each result (if
+     * supported by backend, sequentially otherwise), execution stops on error.
+     * Queries run in one transaction (current one, or one opened for them),
+     * so either all of them or none are committed.
+     * @param queries SQL query strings with query parameters
+     * @return success of all queries
+     */
+    bool executePipeline(const std::vector< std::pair<std::string, void *> >& queries) override;
+
     /**
      * Executes query and fetc hes new result set
      * @param query SQl query string
@@ -48,6 +87,24 @@ public:
      */
     int fetch(const std::string& query, void *param, ResultSet &resultSet) override;
 
+    /**
+     * Executes bulk copy of rows into table
+     * @param query copy query string (@see QueryBuilder::getCopyQuery)
+     * @param data rows data (@see QueryBuilder::appendCopyRow)
+     * @return success
+     */
+    bool copyFrom(const std::string& query, const std::string& data) override;
+
+    /**
+     * Executes query with values given as bulk copy rows data
+     * @param query query string (@see QueryBuilder::getInsertBatchQuery)
+     * @param types types of values in one row (@see QueryBuilder::getCopyTypes)
+     * @param data rows data (@see QueryBuilder::appendCopyRow)
+     * @return success
+     */
+    bool executeBatch(const std::string& query, const std::string& types,
+                      const std::string& data) override;
+
 
     // ////////////////////////////////////////////////////////////////////////
     // OWN IMPLEMENTATION
@@ -55,12 +112,47 @@ public:
 
 
     explicit PGConnection(const std::string& connection_info)
-        : Connection(connection_info) {}
+        : Connection(connection_info), _stmt_counter(0) {}
 
     virtual ~PGConnection()
     { disconnect(); }
 
+    /**
+     * Gets types of table columns, they are loaded once per table
+     * @param table table name as used in queries (possibly quoted and with schema)
+     * @return column name => type OID, NULL if table was not found
+     */
+    const std::unordered_map<std::string, Oid> * getColumnTypes(const std::string& table);
+
+    /**
+     * Gets OIDs of libpqtypes type specifiers
+     * @param types type specifiers (space separated)
+     * @param oids output type OIDs
+     * @return success, false if some type is unknown
+     */
+    bool getParamTypes(const std::string& types, std::vector<Oid>& oids) const;
+
 private:
+    class PreparedStatement
+    {
+    public:
+        std::string _name;  // server-side statement name, empty = not prepared
+        bool _preparable;   // false => preparing failed, always execute directly
+
+        PreparedStatement() : _preparable(true) {}
+    };
+    typedef std::list< std::pair<std::string, PreparedStatement> > StatementList;
+
+    StatementList _stmt_lru;    /**< statements by query, most recently used first */
+    std::unordered_map<std::string, StatementList::iterator> _stmt_index;   /**< query => LRU item */
+    std::unordered_map<std::string, Oid> _type_oids;    /**< type name => OID */
+    std::unordered_map<std::string, std::unordered_map<std::string, Oid> > _column_types; /**< table => column types */
+    unsigned int _stmt_counter; /**< for unique statement names */
+
+    PGresult *execParam(const std::string& query, void *param);
+    std::string getPreparedStatement(const std::string& query, const PGQueryParam &param);
+    void clearStatements();
+
     bool loadDBTypes();
     void getTypeCategoryFlags(char c, const std::string &name,
                               short int & category, char & flags) const;
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <vtapi/data/intervalevent.h>
+#include <vtapi/data/eyedea_edfdescriptor.h>
+#include <opencv2/opencv.hpp>
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace vtapi {
+
+
+// /////////////////////////////////////////////////
+// BINARY COPY ENCODER
+//
+// Encodes values to PostgreSQL binary COPY format. Every put method appends
+// one complete field (32-bit length followed by type's binary send format).
+// Fixed builtin type OIDs are used inside arrays and composites.
+
+class PGCopyEncoder
+{
+public:
+    enum BuiltinOid
+    {
+        OID_BOOL        = 16,
+        OID_BYTEA       = 17,
+        OID_INT8        = 20,
+        OID_INT4        = 23,
+        OID_TEXT        = 25,
+        OID_FLOAT4      = 700,
+        OID_FLOAT8      = 701,
+        OID_BOX         = 603,
+        OID_INT4_ARRAY  = 1007,
+        OID_BPCHAR      = 1042,
+        OID_VARCHAR     = 1043
+    };
+
+    /**
+     * @brief Checks if type is string type (with text binary format)
+     * @param oid type OID
+     * @return string type
+     */
+    static bool isStringOid(unsigned int oid)
+    { return oid == OID_TEXT || oid == OID_BPCHAR || oid == OID_VARCHAR; }
+
+    /**
+     * @brief Appends COPY file header
+     * @param buf output buffer
+     */
+    static void putHeader(std::string &buf)
+    {
+        static const char signature[] = "PGCOPY\n\377\r\n";
+        buf.append(signature, sizeof(signature));   // including trailing '\0'
+        putUInt32(buf, 0);  // flags
+        putUInt32(buf, 0);  // header extension length
+    }
+
+    /**
+     * @brief Appends COPY file trailer
+     * @param buf output buffer
+     */
+    static void putTrailer(std::string &buf)
+    { putUInt16(buf, 0xFFFF); }
+
+    /**
+     * @brief Appends tuple header
+     * @param buf output buffer
+     * @param fields number of fields in tuple
+     */
+    static void putTupleHeader(std::string &buf, int fields)
+    { putUInt16(buf, static_cast<uint16_t>(fields)); }
+
+    static void putBool(std::string &buf, bool value)
+    {
+        putUInt32(buf, 1);
+        buf.push_back(value ? 1 : 0);
+    }
+
+    static void putChar(std::string &buf, char value)
+    {
+        putUInt32(buf, 1);
+        buf.push_back(value);
+    }
+
+    static void putText(std::string &buf, const std::string &value)
+    { putBytes(buf, value.data(), value.size()); }
+
+    static void putInt4(std::string &buf, int value)
+    {
+        putUInt32(buf, 4);
+        putUInt32(buf, static_cast<uint32_t>(value));
+    }
+
+    static void putInt8(std::string &buf, long long value)
+    {
+        putUInt32(buf, 8);
+        putUInt64(buf, static_cast<uint64_t>(value));
+    }
+
+    static void putFloat4(std::string &buf, float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putUInt32(buf, 4);
+        putUInt32(buf, bits);
+    }
+
+    static void putFloat8(std::string &buf, double value)
+    {
+        putUInt32(buf, 8);
+        putRawFloat8(buf, value);
+    }
+
+    static void putTimestamp(std::string &buf, const std::chrono::system_clock::time_point &value)
+    {
+        // microseconds since 2000-01-01 00:00:00 (integer datetimes)
+        static const long long pg_epoch_usec = 946684800LL * 1000 * 1000;
+        auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(value.time_since_epoch());
+        putInt8(buf, usecs.count() - pg_epoch_usec);
+    }
+
+    static void putPoint(std::string &buf, const Point &value)
+    {
+        putUInt32(buf, 16);
+        putRawFloat8(buf, value.x);
+        putRawFloat8(buf, value.y);
+    }
+
+    static void putBox(std::string &buf, const Box &value)
+    {
+        putUInt32(buf, 32);
+        putRawFloat8(buf, value.high.x);
+        putRawFloat8(buf, value.high.y);
+        putRawFloat8(buf, value.low.x);
+        putRawFloat8(buf, value.low.y);
+    }
+
+    static void putBytes(std::string &buf, const char *data, size_t len)
+    {
+        putUInt32(buf, static_cast<uint32_t>(len));
+        buf.append(data, len);
+    }
+
+    /**
+     * @brief Appends one-dimensional array of fixed length elements
+     * @param buf output buffer
+     * @param elem_oid element type OID
+     * @param values array elements
+     * @param put element encoder
+     */
+    template<typename T>
+    static void putArray(std::string &buf, uint32_t elem_oid,
+                         const std::vector<T> &values,
+                         void (*put)(std::string &, T))
+    {
+        std::string arr;
+        putUInt32(arr, 1);          // dimensions
+        putUInt32(arr, 0);          // has nulls
+        putUInt32(arr, elem_oid);
+        putUInt32(arr, static_cast<uint32_t>(values.size()));
+        putUInt32(arr, 1);          // lower bound
+        for (const T & value : values)
+            put(arr, value);
+
+        putBytes(buf, arr.data(), arr.size());
+    }
+
+    static void putIntervalEvent(std::string &buf, const IntervalEvent &value)
+    {
+        std::string comp;
+        putUInt32(comp, 6);
+        putUInt32(comp, OID_INT4);
+        putInt4(comp, value.group_id);
+        putUInt32(comp, OID_INT4);
+        putInt4(comp, value.class_id);
+        putUInt32(comp, OID_BOOL);
+        putBool(comp, value.is_root);
+        putUInt32(comp, OID_BOX);
+        putBox(comp, value.region);
+        putUInt32(comp, OID_FLOAT8);
+        putFloat8(comp, value.score);
+        putUInt32(comp, OID_BYTEA);
+        putBytes(comp, value.user_data.data(), value.user_data.size());
+
+        putBytes(buf, comp.data(), comp.size());
+    }
+
+    static void putEdfDescriptor(std::string &buf, const EyedeaEdfDescriptor &value)
+    {
+        std::string comp;
+        putUInt32(comp, 2);
+        putUInt32(comp, OID_INT4);
+        putInt4(comp, value.version);
+        putUInt32(comp, OID_BYTEA);
+        putBytes(comp, reinterpret_cast<const char *>(value.data.data()), value.data.size());
+
+        putBytes(buf, comp.data(), comp.size());
+    }
+
+    static void putCvMat(std::string &buf, const cv::Mat &value)
+    {
+        std::vector<int> dims(value.size.p, value.size.p + value.dims);
+
+        std::string comp;
+        putUInt32(comp, 3);
+        putUInt32(comp, OID_INT4);
+        putInt4(comp, value.type());
+        putUInt32(comp, OID_INT4_ARRAY);
+        putArray(comp, OID_INT4, dims, putInt4);
+        putUInt32(comp, OID_BYTEA);
+        putBytes(comp, reinterpret_cast<const char *>(value.data), value.dataend - value.datastart);
+
+        putBytes(buf, comp.data(), comp.size());
+    }
+
+    /**
+     * @brief Splits rows data (without header and trailer) to field values
+     * @param data rows data
+     * @param values output field values (pointing to data), NULL for null field
+     * @param lengths output field lengths
+     * @return success
+     */
+    static bool getFields(const std::string &data,
+                          std::vector<const char *> &values,
+                          std::vector<int> &lengths)
+    {
+        size_t pos = 0;
+
+        while (pos < data.size()) {
+            uint16_t fields;
+            if (!getUInt16(data, pos, fields)) return false;
+
+            for (uint16_t i = 0; i < fields; i++) {
+                uint32_t len;
+                if (!getUInt32(data, pos, len)) return false;
+
+                if (len == 0xFFFFFFFF) {
+                    values.push_back(NULL);
+                    lengths.push_back(0);
+                }
+                else {
+                    if (data.size() - pos < len) return false;
+                    values.push_back(data.data() + pos);
+                    lengths.push_back(static_cast<int>(len));
+                    pos += len;
+                }
+            }
+        }
+
+        return true;
+    }
+
+private:
+    static bool getUInt16(const std::string &data, size_t &pos, uint16_t &value)
+    {
+        if (data.size() - pos < sizeof(value)) return false;
+        memcpy(&value, data.data() + pos, sizeof(value));
+        value = ntohs(value);
+        pos += sizeof(value);
+        return true;
+    }
+
+    static bool getUInt32(const std::string &data, size_t &pos, uint32_t &value)
+    {
+        if (data.size() - pos < sizeof(value)) return false;
+        memcpy(&value, data.data() + pos, sizeof(value));
+        value = ntohl(value);
+        pos += sizeof(value);
+        return true;
+    }
+
+    static void putUInt16(std::string &buf, uint16_t value)
+    {
+        uint16_t val = htons(value);
+        buf.append(reinterpret_cast<const char *>(&val), sizeof(val));
+    }
+
+    static void putUInt32(std::string &buf, uint32_t value)
+    {
+        uint32_t val = htonl(value);
+        buf.append(reinterpret_cast<const char *>(&val), sizeof(val));
+    }
+
+    static void putUInt64(std::string &buf, uint64_t value)
+    {
+        putUInt32(buf, static_cast<uint32_t>(value >> 32));
+        putUInt32(buf, static_cast<uint32_t>(value));
+    }
+
+    static void putRawFloat8(std::string &buf, double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putUInt64(buf, bits);
+    }
+};
+
+
+}
@@ -3,6 +3,7 @@
 #include <vtapi/common/global.h>
 #include <vtapi/common/defs.h>
 #include "pg_querybuilder.h"
+#include "pg_copy.h"
 
 #define DEF_NO_SCHEMA   "!NO_SCHEMA!"
 #define DEF_NO_TABLE    "!NO_TABLE!"
@@ -21,24 +22,56 @@ void PGQueryBuilder::reset()
     _listWhere.clear();
     _cnt_param = 0;
     destroyQueryParam(_pquery_param);
+    _pquery_param = NULL;
 }
 
 void *PGQueryBuilder::createQueryParam() const
 {
-    return (void*)PQparamCreate((PGconn *)_connection.getConnectionObject());
+    PGparam *param = PQparamCreate((PGconn *)_connection.getConnectionObject());
+    if (param)
+        return new PGQueryParam(param);
+    else
+        return NULL;
 }
 
 void PGQueryBuilder::destroyQueryParam(void *param) const
 {
-    if (param) PQparamClear((PGparam *)param);
+    delete (PGQueryParam *)param;
 }
 
 void *PGQueryBuilder::duplicateQueryParam(void *param) const
 {
-    if (param)
-        return PQparamDup((PGparam *) param);
-    else
+    PGparam *dup = NULL;
+
+    if (param && (dup = PQparamDup(((PGQueryParam *) param)->_param))) {
+        PGQueryParam *ret = new PGQueryParam(dup);
+        ret->_types = ((PGQueryParam *) param)->_types;
+        return ret;
+    }
+    else {
         return NULL;
+    }
+}
+
+void *PGQueryBuilder::createSeekQueryParam(const vector<string>& seekvalues) const
+{
+    PGQueryParam *param = (PGQueryParam *)(_pquery_param ?
+        duplicateQueryParam(_pquery_param) : createQueryParam());
+    if (!param)
+        return NULL;
+
+    // values are sent as text and cast to key types in query
+    for (const auto & value : seekvalues) {
+        if (PQputf(param->_param, "%text", value.c_str()) == 0) {
+            VTLOG_WARNING("Failed to add seek value to query: " + value + " (" + PQgeterror() + ")");
+            destroyQueryParam(param);
+            return NULL;
+        }
+        if (!param->_types.empty()) param->_types += ' ';
+        param->_types += "%text";
+    }
+
+    return param;
 }
 
 string PGQueryBuilder::getGenericQuery() const
@@ -52,46 +85,61 @@ string PGQueryBuilder::getGenericQuery() const
 string PGQueryBuilder::getSelectQuery(const string& groupby, const string& orderby,
                                       int limit, int offset) const
 {
-    string tablesStr;
-    string columnsStr;
-    set<string> setTables;
+    string queryString = constructSelectFrom();
+    queryString += constructWhereClause();
+    if (!groupby.empty())
+        queryString += "\nGROUP BY " + groupby;
+    if (!orderby.empty())
+        queryString += "\nORDER BY " + orderby;
+    if (limit > 0)
+        queryString += "\nLIMIT " + toString<int>(limit);
+    if (offset > 0)
+        queryString += "\nOFFSET " + toString<int>(offset);
+    queryString += ';';
 
-    // select * from default table if not specified otherwise
-    if (_listMain.empty()) {
-        columnsStr = '*';
-        tablesStr = constructTable(_defaultTable);
+    return queryString;
+}
+
+string PGQueryBuilder::getSelectSeekQuery(const string& groupby,
+                                          const vector<string>& seekkeys,
+                                          const vector<string>& seektypes,
+                                          int limit) const
+{
+    if (seekkeys.empty()) {
+        VTLOG_ERROR("No seek keys for SELECT query");
+        return DEF_NO_QUERY;
+    }
+    else if (!seektypes.empty() && seektypes.size() != seekkeys.size()) {
+        VTLOG_ERROR("Seek keys and types count mismatch");
+        return DEF_NO_QUERY;
     }
-    // or go through keys, construct tables/columns
-    else {
-        for (const MainItem & item : _listMain) {
-            // add column after SELECT
-            if (!columnsStr.empty())
-                columnsStr += ',';
-            columnsStr += constructColumn(item._key, item._table);
-            columnsStr += " AS " + constructAlias(item._key);
 
-            // add table after FROM
-            string tab = constructTable(item._table);
-            if (setTables.count(tab) == 0) {
-                if (!tablesStr.empty())
-                    tablesStr += ',';
-                tablesStr += tab;
-                setTables.insert(tab);
-            }
+    // last values are parameters following the query ones (createSeekQueryParam)
+    string keysStr;
+    string valuesStr;
+    for (size_t i = 0; i < seekkeys.size(); i++) {
+        if (i > 0) {
+            keysStr += ',';
+            valuesStr += ',';
         }
+        keysStr += constructColumn(seekkeys[i]);
+        if (!seektypes.empty())
+            valuesStr += '$' + toString<unsigned int>(_cnt_param + i + 1) + "::" + seektypes[i];
     }
 
-    string queryString = "SELECT " + columnsStr;
-    queryString += "\nFROM " + tablesStr;
-    queryString += constructWhereClause();
+    string queryString = constructSelectFrom();
+    string where = constructWhereClause();
+    if (!seektypes.empty()) {
+        // row comparison, text values are cast to key types
+        where += where.empty() ? "\nWHERE\n" : "\nAND\n";
+        where += "(" + keysStr + ") > (" + valuesStr + ")";
+    }
+    queryString += where;
     if (!groupby.empty())
         queryString += "\nGROUP BY " + groupby;
-    if (!orderby.empty())
-        queryString += "\nORDER BY " + orderby;
+    queryString += "\nORDER BY " + keysStr;
     if (limit > 0)
         queryString += "\nLIMIT " + toString<int>(limit);
-    if (offset > 0)
-        queryString += "\nOFFSET " + toString<int>(offset);
     queryString += ';';
 
     return queryString;
@@ -204,6 +252,40 @@ string PGQueryBuilder::getCountQuery() const
     }
 }
 
+string PGQueryBuilder::getCountLimitQuery(int limit) const
+{
+    string queryString = getSelectQuery(string(), string(), 0, 0);
+    size_t fromPos = queryString.find("\nFROM ");
+
+    // select is used as subquery, without terminator
+    if (fromPos != string::npos) {
+        queryString.erase(queryString.find_last_not_of("; \n") + 1);
+        return "SELECT COUNT(*) AS count\nFROM (SELECT 1" + queryString.substr(fromPos) +
+               "\nLIMIT " + toString<int>(limit) + ") t;";
+    }
+    else {
+        VTLOG_ERROR("Failed to get COUNT query");
+        return DEF_NO_QUERY;
+    }
+}
+
+string PGQueryBuilder::getCountEstimateQuery() const
+{
+    string queryString = getSelectQuery(string(), string(), 0, 0);
+    size_t fromPos = queryString.find("\nFROM ");
+
+    // EXPLAIN only plans query, estimate comes from table statistics
+    // (pg_class.reltuples scaled to current table size)
+    if (fromPos != string::npos) {
+        queryString.erase(queryString.find_last_not_of("; \n") + 1);
+        return "EXPLAIN SELECT 1" + queryString.substr(fromPos) + ';';
+    }
+    else {
+        VTLOG_ERROR("Failed to get COUNT estimate query");
+        return DEF_NO_QUERY;
+    }
+}
+
 string PGQueryBuilder::getBeginQuery() const
 {
     return "BEGIN;";
@@ -219,6 +301,30 @@ string PGQueryBuilder::getRollbackQuery() const
     return "ROLLBACK;";
 }
 
+string PGQueryBuilder::getDeclareCursorQuery(const string& name, const string& query) const
+{
+    string q = query;
+    size_t end = q.find_last_not_of("; \n");
+    if (end == string::npos) {
+        VTLOG_ERROR("No query for cursor: " + name);
+        return DEF_NO_QUERY;
+    }
+    q.erase(end + 1);
+
+    // cursor lives in transaction, WITH HOLD would materialize whole result at commit
+    return "DECLARE " + escapeIdent(name) + " NO SCROLL CURSOR FOR\n" + q + ';';
+}
+
+string PGQueryBuilder::getFetchCursorQuery(const string& name, int count) const
+{
+    return "FETCH FORWARD " + toString<int>(count > 0 ? count : 1) + " FROM " + escapeIdent(name) + ';';
+}
+
+string PGQueryBuilder::getCloseCursorQuery(const string& name) const
+{
+    return "CLOSE " + escapeIdent(name) + ';';
+}
+
 string PGQueryBuilder::getDatasetCreateQuery(const string& name,
                                              const string& location,
                                              const string& friendly_name,
@@ -337,11 +443,204 @@ string PGQueryBuilder::getTaskDeleteQuery(const string &dsname,
     return q;
 }
 
+string PGQueryBuilder::getEventsStatsQuery(const string &table,
+                                           const string &key,
+                                           const string &taskname,
+                                           const vector<string> &seqnames,
+                                           const EventFilter *filter) const
+{
+    string q;
+    q += "SELECT * FROM ";
+    q += def_fnc_event_stats;
+    q += '(';
+    q += escapeLiteral(constructTable(table));
+    q += ',';
+    q += escapeLiteral(key);
+    q += ',';
+    q += escapeLiteral(taskname);
+    q += ',';
+    q += escapeLiteralArray(seqnames);
+    q += ',';
+    q += filter ? "\'" + toString<EventFilter>(*filter) + "\'" : "NULL";
+    q += ");";
+
+    return q;
+}
+
+string PGQueryBuilder::getClassOccurrencesQuery(const string &table,
+                                                const string &taskname,
+                                                const vector<string> &seqnames) const
+{
+    string q;
+    q += "SELECT * FROM ";
+    q += def_fnc_event_classes;
+    q += '(';
+    q += escapeLiteral(constructTable(table));
+    q += ',';
+    q += escapeLiteral(taskname);
+    q += ',';
+    q += escapeLiteralArray(seqnames);
+    q += ");";
+
+    return q;
+}
+
+string PGQueryBuilder::getEventsVersionsQuery(const string &table,
+                                              const string &taskname,
+                                              const vector<string> &seqnames) const
+{
+    string q;
+    q += "SELECT * FROM ";
+    q += def_fnc_event_versions;
+    q += '(';
+    q += escapeLiteral(constructTable(table));
+    q += ',';
+    q += escapeLiteral(taskname);
+    q += ',';
+    q += escapeLiteralArray(seqnames);
+    q += ");";
+
+    return q;
+}
+
 string PGQueryBuilder::getLastInsertedIdQuery() const
 {
     return "SELECT lastval();";
 }
 
+void PGQueryBuilder::setCopyCapture(bool enable)
+{
+    _copy_capture = enable;
+}
+
+string PGQueryBuilder::getCopyQuery() const
+{
+    string tabStr = constructTable(_defaultTable);
+    string intoStr;
+
+    if (!_copy_capture || _listMain.empty())
+        return string();
+
+    for (const MainItem & item : _listMain) {
+        if (!item._copy_valid)
+            return string();
+
+        if (!item._table.empty())
+            tabStr = constructTable(item._table);
+
+        if (!intoStr.empty())
+            intoStr += ',';
+        intoStr += escapeIdent(item._key);
+    }
+
+    // values are encoded by types of setters, columns must have the same ones
+    if (!checkCopyTypes(tabStr))
+        return string();
+
+    return "COPY " + tabStr + '(' + intoStr + ")\nFROM STDIN (FORMAT binary);";
+}
+
+bool PGQueryBuilder::checkCopyTypes(const string& table) const
+{
+    const auto *columns = _pgconnection.getColumnTypes(table);
+    if (!columns)
+        return false;
+
+    for (const MainItem & item : _listMain) {
+        vector<Oid> oids;
+        auto it = columns->find(item._key);
+        if (it == columns->end() || !_pgconnection.getParamTypes(item._type, oids) || oids.size() != 1)
+            return false;
+        if (oids[0] == it->second)
+            continue;
+
+        // string types share binary format
+        if (!PGCopyEncoder::isStringOid(oids[0]) || !PGCopyEncoder::isStringOid(it->second)) {
+            VTLOG_MESSAGE("Column " + item._key + " type differs from value type " + item._type +
+                        ", bulk copy is not used");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+string PGQueryBuilder::getInsertBatchQuery(unsigned int rows) const
+{
+    string tabStr = constructTable(_defaultTable);
+    string intoStr;
+    string valuesStr;
+    unsigned int cnt = 0;
+
+    if (!_copy_capture || _listMain.empty() || rows == 0)
+        return string();
+
+    // libpq limits number of parameters per query
+    if (rows * _listMain.size() > 65535)
+        return string();
+
+    for (const MainItem & item : _listMain) {
+        if (!item._copy_valid)
+            return string();
+
+        if (!item._table.empty())
+            tabStr = constructTable(item._table);
+
+        if (!intoStr.empty())
+            intoStr += ',';
+        intoStr += escapeIdent(item._key);
+    }
+
+    // parameters are numbered row by row
+    for (unsigned int r = 0; r < rows; r++) {
+        if (r > 0) valuesStr += ',';
+        valuesStr += '(';
+        for (size_t c = 0; c < _listMain.size(); c++) {
+            if (c > 0) valuesStr += ',';
+            valuesStr += '$' + toString<unsigned int>(++cnt);
+        }
+        valuesStr += ')';
+    }
+
+    return "INSERT INTO " + tabStr + '(' + intoStr + ")\nVALUES" + valuesStr + ';';
+}
+
+string PGQueryBuilder::getCopyTypes() const
+{
+    string types;
+
+    if (!_copy_capture)
+        return types;
+
+    for (const MainItem & item : _listMain) {
+        if (!item._copy_valid)
+            return string();
+
+        if (!types.empty())
+            types += ' ';
+        types += item._type;
+    }
+
+    return types;
+}
+
+bool PGQueryBuilder::appendCopyRow(string& data) const
+{
+    if (!_copy_capture || _listMain.empty())
+        return false;
+
+    for (const MainItem & item : _listMain) {
+        if (!item._copy_valid)
+            return false;
+    }
+
+    PGCopyEncoder::putTupleHeader(data, _listMain.size());
+    for (const MainItem & item : _listMain)
+        data += item._copy_value;
+
+    return true;
+}
+
 template<typename T>
 bool PGQueryBuilder::keySingleValue(const string& key,
                                     const T& value,
@@ -356,7 +655,7 @@ bool PGQueryBuilder::keySingleValue(const string& key,
         idParam = addToParam(type, value);
         if (!idParam) break;
 
-        _listMain.push_back(MainItem(key, from, idParam));
+        _listMain.push_back(MainItem(key, from, idParam, type));
     } while (0);
 
     return (idParam > 0);
@@ -386,7 +685,7 @@ bool PGQueryBuilder::keyVector(const string& key,
         idParam = addToParam(type_arr, &arr);
         if (!idParam) break;
 
-        _listMain.push_back(MainItem(key, from, idParam));
+        _listMain.push_back(MainItem(key, from, idParam, type_arr));
     } while (0);
 
     if (arr.param) PQparamClear(arr.param);
@@ -394,6 +693,18 @@ bool PGQueryBuilder::keyVector(const string& key,
     return (idParam > 0);
 }
 
+template<typename F>
+bool PGQueryBuilder::captureCopyValue(bool added, F encode)
+{
+    if (added && _copy_capture) {
+        MainItem & item = _listMain.back();
+        encode(item._copy_value);
+        item._copy_valid = true;
+    }
+
+    return added;
+}
+
 bool PGQueryBuilder::keyFrom(const string& table, const string& column)
 {
     if (column.empty()) {
@@ -409,17 +720,23 @@ bool PGQueryBuilder::keyFrom(const string& table, const string& column)
 
 bool PGQueryBuilder::keyBool(const string &key, bool value, const string &from)
 {
-    return keySingleValue(key, value, "%bool", from);
+    return captureCopyValue(
+        keySingleValue(key, value, "%bool", from),
+        [&](string & buf) { PGCopyEncoder::putBool(buf, value); });
 }
 
 bool PGQueryBuilder::keyChar(const string &key, char value, const string &from)
 {
-    return keySingleValue(key, value, "%char", from);
+    return captureCopyValue(
+        keySingleValue(key, value, "%char", from),
+        [&](string & buf) { PGCopyEncoder::putChar(buf, value); });
 }
 
 bool PGQueryBuilder::keyString(const string& key, const string& value, const string& from)
 {
-    return keySingleValue(key, value.c_str(), "%varchar", from);
+    return captureCopyValue(
+        keySingleValue(key, value.c_str(), "%varchar", from),
+        [&](string & buf) { PGCopyEncoder::putText(buf, value); });
 }
 
 bool PGQueryBuilder::keyStringVector(const string& key, const vector<string>& values, const string& from)
@@ -431,48 +748,66 @@ bool PGQueryBuilder::keyStringVector(const string& key, const vector<string>& va
 
 bool PGQueryBuilder::keyInt(const string& key, int value, const string& from)
 {
-    return keySingleValue(key, value, "%int4", from);
+    return captureCopyValue(
+        keySingleValue(key, value, "%int4", from),
+        [&](string & buf) { PGCopyEncoder::putInt4(buf, value); });
 }
 
 bool PGQueryBuilder::keyIntVector(const string& key, const vector<int> &values, const string& from)
 {
-    return keyVector(key, values, "%int4", "%int4[]", from);
+    return captureCopyValue(
+        keyVector(key, values, "%int4", "%int4[]", from),
+        [&](string & buf) { PGCopyEncoder::putArray(buf, PGCopyEncoder::OID_INT4, values, PGCopyEncoder::putInt4); });
 }
 
 bool PGQueryBuilder::keyInt8(const string& key, long long value, const string& from)
 {
-    return keySingleValue(key, value, "%int8", from);
+    return captureCopyValue(
+        keySingleValue(key, value, "%int8", from),
+        [&](string & buf) { PGCopyEncoder::putInt8(buf, value); });
 }
 
 bool PGQueryBuilder::keyInt8Vector(const string& key, const vector<long long> &values, const string& from)
 {
-    return keyVector(key, values, "%int8", "%int8[]", from);
+    return captureCopyValue(
+        keyVector(key, values, "%int8", "%int8[]", from),
+        [&](string & buf) { PGCopyEncoder::putArray(buf, PGCopyEncoder::OID_INT8, values, PGCopyEncoder::putInt8); });
 }
 
 bool PGQueryBuilder::keyFloat(const string& key, float value, const string& from)
 {
-    return keySingleValue(key, value, "%float4", from);
+    return captureCopyValue(
+        keySingleValue(key, value, "%float4", from),
+        [&](string & buf) { PGCopyEncoder::putFloat4(buf, value); });
 }
 
 bool PGQueryBuilder::keyFloatVector(const string& key, const vector<float> &values, const string& from)
 {
-    return keyVector(key, values, "%float4", "%float4[]", from);
+    return captureCopyValue(
+        keyVector(key, values, "%float4", "%float4[]", from),
+        [&](string & buf) { PGCopyEncoder::putArray(buf, PGCopyEncoder::OID_FLOAT4, values, PGCopyEncoder::putFloat4); });
 }
 
 bool PGQueryBuilder::keyFloat8(const string& key, double value, const string& from)
 {
-    return keySingleValue(key, value, "%float8", from);
+    return captureCopyValue(
+        keySingleValue(key, value, "%float8", from),
+        [&](string & buf) { PGCopyEncoder::putFloat8(buf, value); });
 }
 
 bool PGQueryBuilder::keyFloat8Vector(const string& key, const vector<double> &values, const string& from)
 {
-    return keyVector(key, values, "%float8", "%float8[]", from);
+    return captureCopyValue(
+        keyVector(key, values, "%float8", "%float8[]", from),
+        [&](string & buf) { PGCopyEncoder::putArray(buf, PGCopyEncoder::OID_FLOAT8, values, PGCopyEncoder::putFloat8); });
 }
 
 bool PGQueryBuilder::keyTimestamp(const string& key, const std::chrono::system_clock::time_point &value, const string& from)
 {
     PGtimestamp ts = UnixTimeToTimestamp(value);
-    return keySingleValue(key, &ts, "%timestamp", from);
+    return captureCopyValue(
+        keySingleValue(key, &ts, "%timestamp", from),
+        [&](string & buf) { PGCopyEncoder::putTimestamp(buf, value); });
 }
 
 bool PGQueryBuilder::keyCvMat(const string& key, const cv::Mat& value, const string& from)
@@ -508,7 +843,9 @@ bool PGQueryBuilder::keyCvMat(const string& key, const cv::Mat& value, const str
                                 (PGint4) value.type(), &mat_dims, &mat_data));
         if (!ret) break;
 
-        ret = keySingleValue(key, cvmat, "%public.cvmat", from);
+        ret = captureCopyValue(
+            keySingleValue(key, cvmat, "%public.cvmat", from),
+            [&](string & buf) { PGCopyEncoder::putCvMat(buf, value); });
     } while (0);
 
     if (cvmat) PQparamClear(cvmat);
@@ -520,7 +857,9 @@ bool PGQueryBuilder::keyCvMat(const string& key, const cv::Mat& value, const str
 bool PGQueryBuilder::keyPoint(const string& key, Point value, const string& from)
 {
     PGpoint pt = { value.x, value.y };
-    return keySingleValue(key, &pt, "%point", from);
+    return captureCopyValue(
+        keySingleValue(key, &pt, "%point", from),
+        [&](string & buf) { PGCopyEncoder::putPoint(buf, value); });
 }
 
 bool PGQueryBuilder::keyPointVector(const string& key, const vector<Point> &values, const string& from)
@@ -553,7 +892,9 @@ bool PGQueryBuilder::keyIntervalEvent(const string& key, const IntervalEvent& va
                                 (PGbox *) & value.region, (PGfloat8) value.score, &data));
         if (!ret) break;
 
-        ret = keySingleValue(key, event, "%public.vtevent", from);
+        ret = captureCopyValue(
+            keySingleValue(key, event, "%public.vtevent", from),
+            [&](string & buf) { PGCopyEncoder::putIntervalEvent(buf, value); });
     } while (0);
 
     if (event) PQparamClear(event);
@@ -583,7 +924,9 @@ bool PGQueryBuilder::keyEdfDescriptor(const string &key, const EyedeaEdfDescript
 
         if (! ret) break;
 
-        ret = keySingleValue(key, edfdesc, "%public.eyedea_edfdescriptor", from);
+        ret = captureCopyValue(
+            keySingleValue(key, edfdesc, "%public.eyedea_edfdescriptor", from),
+            [&](string & buf) { PGCopyEncoder::putEdfDescriptor(buf, value); });
     } while (0);
 
     if (edfdesc) PQparamClear(edfdesc);
@@ -594,23 +937,31 @@ bool PGQueryBuilder::keyEdfDescriptor(const string &key, const EyedeaEdfDescript
 
 bool PGQueryBuilder::keyProcessStatus(const string& key, ProcessState::Status value, const string& from)
 {
-    return keySingleValue(key, ProcessState::toStatusString(value).c_str(), "%public.pstatus", from);
+    return captureCopyValue(
+        keySingleValue(key, ProcessState::toStatusString(value).c_str(), "%public.pstatus", from),
+        [&](string & buf) { PGCopyEncoder::putText(buf, ProcessState::toStatusString(value)); });
 }
 
 bool PGQueryBuilder::keyBlob(const string& key, const vector<char> &data, const string &from)
 {
     PGbytea bytea = { static_cast<int>(data.size()), const_cast<char*>(data.data()) };
-    return keySingleValue(key, &bytea, "%bytea", from);
+    return captureCopyValue(
+        keySingleValue(key, &bytea, "%bytea", from),
+        [&](string & buf) { PGCopyEncoder::putBytes(buf, data.data(), data.size()); });
 }
 
 bool PGQueryBuilder::keySeqtype(const string& key, const string& value, const string& from)
 {
-    return checkSeqtype(value) && keySingleValue(key, value.c_str(), "%public.seqtype", from);
+    return checkSeqtype(value) && captureCopyValue(
+        keySingleValue(key, value.c_str(), "%public.seqtype", from),
+        [&](string & buf) { PGCopyEncoder::putText(buf, value); });
 }
 
 bool PGQueryBuilder::keyInouttype(const string& key, const string& value, const string& from)
 {
-    return checkInouttype(value) && keySingleValue(key, value.c_str(), "%public.inouttype", from);
+    return checkInouttype(value) && captureCopyValue(
+        keySingleValue(key, value.c_str(), "%public.inouttype", from),
+        [&](string & buf) { PGCopyEncoder::putText(buf, value); });
 }
 
 template<typename T>
@@ -805,12 +1156,13 @@ bool PGQueryBuilder::whereInouttype(const string& key, const string& value, cons
 
 bool PGQueryBuilder::whereEvent(const string &key, const string &taskname, const vector<string> &seqnames, const EventFilter &filter, const string& from)
 {
-//id = ANY (public.VT_filtered_events('demo.demo2_out', 'event', 'task_demo2_1', 'video1', '(,,,,,,"(0,0),(0,0)")'))
-    string val = "ANY (" + def_fnc_event_filter + "(" +
+//(event).group_id IN (SELECT public.VT_filtered_events('demo.demo2_out', 'event', 'task_demo2_1', '{video1}', '(,,,,,,"(0,0),(0,0)")'))
+    // set of group IDs is semi-joined (hash), not compared row by row as array
+    string val = "(SELECT " + def_fnc_event_filter + "(" +
             escapeLiteral(constructTable(from)) + "," + escapeLiteral(key) + "," +
             escapeLiteral(taskname) + "," + escapeLiteralArray(seqnames) + "," +
             "\'" + toString<EventFilter>(filter) + "\'))";
-    return whereExpression("(" + key + ").group_id", val, "=");
+    return whereExpression("(" + key + ").group_id", val, "IN");
 }
 
 bool PGQueryBuilder::whereEdfDescriptor(const string& key, const EyedeaEdfDescriptor& value, const string& oper, const string& from)
@@ -834,11 +1186,16 @@ unsigned int PGQueryBuilder::addToParam(const char* type, const T& value)
     do {
         if (!_pquery_param && !(_pquery_param = createQueryParam())) break;
 
-        if (PQputf((PGparam *)_pquery_param, type, value) == 0) {
+        PGQueryParam *param = (PGQueryParam *)_pquery_param;
+        if (PQputf(param->_param, type, value) == 0) {
             VTLOG_WARNING("Failed to add value to query: " + toString<T>(value) + " (" + PQgeterror() + ")");
             break;
         }
 
+        // types are needed for preparing statement
+        if (!param->_types.empty()) param->_types += ' ';
+        param->_types += type;
+
         ret = ++_cnt_param;
     } while (0);
 
@@ -993,6 +1350,40 @@ string PGQueryBuilder::escapeLiteralArray(const vector<string> &literals) const
     return "\'" + str + "\'";
 }
 
+string PGQueryBuilder::constructSelectFrom() const
+{
+    string tablesStr;
+    string columnsStr;
+    set<string> setTables;
+
+    // select * from default table if not specified otherwise
+    if (_listMain.empty()) {
+        columnsStr = '*';
+        tablesStr = constructTable(_defaultTable);
+    }
+    // or go through keys, construct tables/columns
+    else {
+        for (const MainItem & item : _listMain) {
+            // add column after SELECT
+            if (!columnsStr.empty())
+                columnsStr += ',';
+            columnsStr += constructColumn(item._key, item._table);
+            columnsStr += " AS " + constructAlias(item._key);
+
+            // add table after FROM
+            string tab = constructTable(item._table);
+            if (setTables.count(tab) == 0) {
+                if (!tablesStr.empty())
+                    tablesStr += ',';
+                tablesStr += tab;
+                setTables.insert(tab);
+            }
+        }
+    }
+
+    return "SELECT " + columnsStr + "\nFROM " + tablesStr;
+}
+
 string PGQueryBuilder::constructWhereClause() const
 {
     string where;
@@ -45,6 +45,15 @@ public:
      */
      void *duplicateQueryParam(void *param) const override;
 
+    /**
+     * @brief Duplicates query param and appends key values of the last fetched
+     * row, for query built by getSelectSeekQuery with seek types
+     * @note should be destroyed with destroyQueryParam()
+     * @param seekvalues key values of the last fetched row
+     * @return new query param object
+     */
+     void *createSeekQueryParam(const std::vector<std::string>& seekvalues) const override;
+
     // ////////////////////////////////////////////////////////////////////////
     // query builder methods
     // ////////////////////////////////////////////////////////////////////////
@@ -69,6 +78,20 @@ public:
         int limit,
         int offset) const override;
 
+    /**
+     * @brief Builds SELECT query string for keyset (seek) pagination
+     * @param groupby GROUP BY argument
+     * @param seekkeys ordering keys (must be unique together and selected)
+     * @param seektypes types of seek keys, empty = first page
+     * @param limit LIMIT argument, 0 = no limit
+     * @return query string, empty on error
+     */
+     std::string getSelectSeekQuery(
+        const std::string& groupby,
+        const std::vector<std::string>& seekkeys,
+        const std::vector<std::string>& seektypes,
+        int limit) const override;
+
     /**
      * @brief Builds INSERT query string
      * @return query string, empty on error
@@ -93,6 +116,20 @@ public:
      */
      std::string getCountQuery() const override;
 
+    /**
+     * Builds SELECT COUNT(*) query which stops counting at limit
+     * @param limit maximum count
+     * @return query string, empty on error
+     */
+     std::string getCountLimitQuery(int limit) const override;
+
+    /**
+     * Builds query to get planner's estimate of row count (without executing
+     * SELECT), first row of result contains top plan node with "rows=N"
+     * @return query string, empty on error
+     */
+     std::string getCountEstimateQuery() const override;
+
     /**
      * Builds BEGIN TRANSACTION query
      * @return query string, empty on error
@@ -111,6 +148,31 @@ public:
      */
      std::string getRollbackQuery() const override;
 
+    /**
+     * Builds query declaring server-side cursor over given query
+     * @param name cursor name
+     * @param query query to iterate over (its parameters are used with it)
+     * @return query string, empty on error
+     */
+     std::string getDeclareCursorQuery(const std::string& name,
+                                       const std::string& query) const override;
+
+    /**
+     * Builds query fetching next rows from server-side cursor
+     * @param name cursor name
+     * @param count maximum number of rows to fetch
+     * @return query string, empty on error
+     */
+     std::string getFetchCursorQuery(const std::string& name,
+                                     int count) const override;
+
+    /**
+     * Builds query closing server-side cursor
+     * @param name cursor name
+     * @return query string, empty on error
+     */
+     std::string getCloseCursorQuery(const std::string& name) const override;
+
     /**
      * @brief Builds query to create new dataset
      * @param name dataset name
@@ -184,12 +246,92 @@ public:
      std::string getTaskDeleteQuery(const std::string& dsname,
                                    const std::string& taskname) const override;
 
+    /**
+     * @brief Builds query to get events statistics of task output per sequence
+     * (sequence name, length, covered frames, root events count, all events count)
+     * @param table task output table
+     * @param key event key
+     * @param taskname task name
+     * @param seqnames sequences to get statistics for (empty = all)
+     * @param filter event filter, NULL for no filter
+     * @return query string, empty on error
+     */
+     std::string getEventsStatsQuery(const std::string& table,
+                                    const std::string& key,
+                                    const std::string& taskname,
+                                    const std::vector<std::string>& seqnames,
+                                    const EventFilter *filter) const override;
+
+    /**
+     * @brief Builds query to get summed class occurrences of task output
+     * (class ID, occurrence)
+     * @param table task output table
+     * @param taskname task name
+     * @param seqnames sequences to sum occurrences over (empty = all)
+     * @return query string, empty on error
+     */
+     std::string getClassOccurrencesQuery(const std::string& table,
+                                         const std::string& taskname,
+                                         const std::vector<std::string>& seqnames) const override;
+
+    /**
+     * @brief Builds query to get versions of task output per sequence
+     * (sequence name, last change, last update or delete, all events count)
+     * @param table task output table
+     * @param taskname task name
+     * @param seqnames sequences to get versions for (empty = all)
+     * @return query string, empty on error
+     */
+     std::string getEventsVersionsQuery(const std::string& table,
+                                       const std::string& taskname,
+                                       const std::vector<std::string>& seqnames) const override;
+
     /**
      * @brief Builds query to get last inserted ID
      * @return query string, empty on error
      */
      std::string getLastInsertedIdQuery() const override;
 
+    // ////////////////////////////////////////////////////////////////////////
+    // bulk copy (for INSERT)
+    // ////////////////////////////////////////////////////////////////////////
+
+    /**
+     * @brief Enables capturing of key values for bulk copy
+     * @note Must be enabled before keys are set.
+     * @param enable capture key values
+     */
+     void setCopyCapture(bool enable) override;
+
+    /**
+     * @brief Builds bulk copy query for captured keys (alternative to INSERT)
+     * @note Values are copied in format of their types, so their types must
+     * match column types (cached per table by connection).
+     * @return query string, empty if keys cannot be copied
+     */
+     std::string getCopyQuery() const override;
+
+    /**
+     * @brief Appends captured key values as one row of bulk copy data
+     * @param data copy data buffer
+     * @return success
+     */
+     bool appendCopyRow(std::string& data) const override;
+
+    /**
+     * @brief Builds multi-row INSERT query for captured keys
+     * @note Values are passed as bulk copy rows data (@see appendCopyRow)
+     * @param rows number of inserted rows
+     * @return query string, empty if keys cannot be batched
+     */
+     std::string getInsertBatchQuery(unsigned int rows) const override;
+
+     /**
+      * @brief Gets type specifiers of captured key values (of one row)
+      * @return type specifiers (space separated), empty if values aren't captured
+      */
+     std::string getCopyTypes() const override;
+
 
     // ////////////////////////////////////////////////////////////////////////
     // setting query table (for SELECT or DELETE)
@@ -808,7 +950,7 @@ public:
 
 
     explicit PGQueryBuilder(PGConnection &connection)
-        : QueryBuilder(connection), _cnt_param(0) {}
+        : QueryBuilder(connection), _pgconnection(connection), _cnt_param(0), _copy_capture(false) {}
 
     ~PGQueryBuilder()
      { reset(); }
@@ -820,11 +962,15 @@ private:
         std::string _key;
         std::string _table;
         unsigned int _id_param;
+        std::string _type;          // type specifier of value
+        std::string _copy_value;    // value in binary copy format
+        bool _copy_valid;           // _copy_value was captured
 
         MainItem(const std::string& key,
          const std::string& table,
-         const unsigned int id_param)
-        : _key(key), _table(table), _id_param(id_param) { }
+         const unsigned int id_param,
+         const std::string& type = std::string())
+        : _key(key), _table(table), _id_param(id_param), _type(type), _copy_valid(false) { }
     };
 
     class WhereItem
@@ -850,9 +996,11 @@ private:
             : _key(key), _oper(oper), _value(value), _id_param(0) {}
     };
 
+    PGConnection &_pgconnection;        /**< connection (column types for bulk copy) */
     std::list<MainItem> _listMain;      /**< list of items for main query part */
     std::list<WhereItem> _listWhere;    /**< list of WHERE clause items */
     uint _cnt_param;            /**< keys counter */
+    bool _copy_capture;         /**< capture key values for bulk copy */
 
 
     std::string constructTable(const std::string& table = std::string(),
@@ -865,6 +1013,7 @@ private:
     std::string escapeLiteral(const std::string& literal) const;
     std::string escapeLiteralArray(const std::vector<std::string>& idents) const;
 
+    std::string constructSelectFrom() const;
     std::string constructWhereClause() const;
 
     PGtimestamp UnixTimeToTimestamp(const std::chrono::system_clock::time_point & utime) const;
@@ -885,6 +1034,11 @@ private:
                    const char* type_arr,
                    const std::string& from);
 
+    template<typename F>
+    bool captureCopyValue(bool added, F encode);
+
+    bool checkCopyTypes(const std::string& table) const;
+
     template<typename T>
     bool whereSingleValue(const std::string& key,
                           const T& value,
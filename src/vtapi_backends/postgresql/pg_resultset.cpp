@@ -4,6 +4,9 @@
 #include <vtapi/common/global.h>
 #include <vtapi/common/serialize.h>
 #include <libpqtypes.h>
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
 
 
 #define CHECK_PGRES\
@@ -14,10 +17,126 @@ using namespace std;
 namespace vtapi {
 
 
+// =============== BINARY DECODERS  ===============
+
+// Direct decoders of binary transferred fixed-length values, they bypass
+// libpqtypes format string parsing. NULL values are returned as 0 just like
+// libpqtypes does.
+
+static inline uint32_t readUInt32(const char *data)
+{
+    uint32_t val;
+    memcpy(&val, data, sizeof(val));
+    return ntohl(val);
+}
+
+static long long decodeInt2(const PGresult *res, int pos, int col)
+{
+    if (PQgetisnull(res, pos, col)) return 0;
+    uint16_t val;
+    memcpy(&val, PQgetvalue(res, pos, col), sizeof(val));
+    return static_cast<int16_t>(ntohs(val));
+}
+
+static long long decodeInt4(const PGresult *res, int pos, int col)
+{
+    if (PQgetisnull(res, pos, col)) return 0;
+    return static_cast<int32_t>(readUInt32(PQgetvalue(res, pos, col)));
+}
+
+static long long decodeInt8(const PGresult *res, int pos, int col)
+{
+    if (PQgetisnull(res, pos, col)) return 0;
+    const char *data = PQgetvalue(res, pos, col);
+    uint64_t val = (static_cast<uint64_t>(readUInt32(data)) << 32) | readUInt32(data + 4);
+    return static_cast<int64_t>(val);
+}
+
+static double decodeFloat4(const PGresult *res, int pos, int col)
+{
+    if (PQgetisnull(res, pos, col)) return 0;
+    uint32_t bits = readUInt32(PQgetvalue(res, pos, col));
+    float val;
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+static double decodeFloat8(const PGresult *res, int pos, int col)
+{
+    if (PQgetisnull(res, pos, col)) return 0;
+    const char *data = PQgetvalue(res, pos, col);
+    uint64_t bits = (static_cast<uint64_t>(readUInt32(data)) << 32) | readUInt32(data + 4);
+    double val;
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+
 void PGResultSet::newResult(void *res)
 {
     clear();
     _res = res;
+    _generation++;
+
+    // map column keys to indexes, so that key getters need not scan columns
+    if (_res) {
+        int cols = PQnfields(static_cast<const PGresult *>(_res));
+        _keyindex.reserve(cols);
+        for (int col = 0; col < cols; col++)
+            _keyindex.insert(std::make_pair(PQfname(static_cast<const PGresult *>(_res), col), col));
+
+        createDecoders();
+    }
+}
+
+void PGResultSet::createDecoders()
+{
+    const PGresult *res = static_cast<const PGresult *>(_res);
+    int cols = PQnfields(res);
+
+    _decoders.resize(cols);
+    for (int col = 0; col < cols; col++) {
+        ColumnDecoder & dec = _decoders[col];
+        dec._oid = PQftype(res, col);
+
+        const DatabaseTypes::TypeDefinition *type = _dbtypes.find(dec._oid);
+        if (type) {
+            dec._length = type->_length;
+            dec._category = type->_category;
+            dec._flags = type->_flags;
+        }
+
+        // direct decoders only for binary scalars, otherwise use libpqtypes
+        if (PQfformat(res, col) != 1 || (dec._flags & DatabaseTypes::FLAG_ARRAY))
+            continue;
+
+        if (dec._category == DatabaseTypes::CATEGORY_INT) {
+            switch (dec._length)
+            {
+            case 2: dec._integer = decodeInt2; break;
+            case 4: dec._integer = decodeInt4; break;
+            case 8: dec._integer = decodeInt8; break;
+            default: break;
+            }
+        }
+        else if (dec._category == DatabaseTypes::CATEGORY_FLOAT) {
+            switch (dec._length)
+            {
+            case 4: dec._float = decodeFloat4; break;
+            case 8: dec._float = decodeFloat8; break;
+            default: break;
+            }
+        }
+    }
+}
+
+const PGResultSet::ColumnDecoder & PGResultSet::getDecoder(int col) const
+{
+    CHECK_PGRES;
+    if (col < 0 || col >= static_cast<int>(_decoders.size()))
+        throw RuntimeException("Failed to get value: colum index is invalid");
+
+    return _decoders[col];
 }
 
 int PGResultSet::countRows() const
@@ -43,6 +162,8 @@ void PGResultSet::clear()
         PQclear(static_cast<PGresult *>(_res));
         _res = NULL;
     }
+    _keyindex.clear();
+    _decoders.clear();
 }
 
 TKey PGResultSet::getKey(int col) const
@@ -71,14 +192,18 @@ string PGResultSet::getKeyType(int col) const
 
 short PGResultSet::getKeyTypeLength(int col, short def) const
 {
-    CHECK_PGRES;
-    return _dbtypes.type(PQftype(static_cast<const PGresult *>(_res), col))._length;
+    return getDecoder(col)._length;
 }
 
 int PGResultSet::getKeyIndex(const string& key) const
 {
     CHECK_PGRES;
 
+    auto it = _keyindex.find(key);
+    if (it != _keyindex.end())
+        return it->second;
+
+    // quoted or upper-case keys are resolved by libpq rules
     int idx = PQfnumber(static_cast<const PGresult *>(_res), key.c_str());
     if (idx < 0) throw RuntimeException("Failed to find key: " + key);
     return idx;
@@ -89,7 +214,14 @@ int PGResultSet::getKeyIndex(const string& key) const
 template <typename T>
 T PGResultSet::getIntegerSingle(int col) const
 {
-    switch (getKeyTypeLength(col, 4))
+    const ColumnDecoder & dec = getDecoder(col);
+    if (dec._integer) {
+        if (_pos < 0)
+            throw RuntimeException("Failed to get value: result set position is invalid");
+        return static_cast<T>(dec._integer(static_cast<const PGresult *>(_res), _pos, col));
+    }
+
+    switch (dec._length)
     {
     case -1:
         return GetterSingle<PGnumeric,T>::get(static_cast<const PGresult *>(_res), _pos, col, "%numeric");
@@ -130,7 +262,14 @@ vector<T> PGResultSet::getIntegerVector(int col) const
 template <typename T>
 T PGResultSet::getFloatSingle(int col) const
 {
-    switch (getKeyTypeLength(col, 4))
+    const ColumnDecoder & dec = getDecoder(col);
+    if (dec._float) {
+        if (_pos < 0)
+            throw RuntimeException("Failed to get value: result set position is invalid");
+        return static_cast<T>(dec._float(static_cast<const PGresult *>(_res), _pos, col));
+    }
+
+    switch (dec._length)
     {
     case -1:
         return GetterSingle<PGnumeric,T>::get(static_cast<const PGresult *>(_res), _pos, col, "%numeric");
@@ -164,6 +303,36 @@ vector<T> PGResultSet::getFloatVector(int col) const
     return vector<T>();
 }
 
+template <typename T>
+bool PGResultSet::decodeIntegerColumn(int col, vector<T> &values) const
+{
+    IntegerDecoder decoder = getDecoder(col)._integer;
+    if (!decoder) return false;
+
+    const PGresult *res = static_cast<const PGresult *>(_res);
+    int rows = PQntuples(res);
+    values.resize(rows);
+    for (int row = 0; row < rows; row++)
+        values[row] = static_cast<T>(decoder(res, row, col));
+
+    return true;
+}
+
+template <typename T>
+bool PGResultSet::decodeFloatColumn(int col, vector<T> &values) const
+{
+    FloatDecoder decoder = getDecoder(col)._float;
+    if (!decoder) return false;
+
+    const PGresult *res = static_cast<const PGresult *>(_res);
+    int rows = PQntuples(res);
+    values.resize(rows);
+    for (int row = 0; row < rows; row++)
+        values[row] = static_cast<T>(decoder(res, row, col));
+
+    return true;
+}
+
 // =============== GETTERS  ===============
 
 
@@ -272,8 +441,7 @@ string PGResultSet::getValue(int col) const
     CHECK_PGRES;
     string ret;
 
-    Oid oid = PQftype(static_cast<const PGresult *>(_res), col);
-    const DatabaseTypes::TypeDefinition & type = _dbtypes.type(oid);
+    const ColumnDecoder & type = getDecoder(col);
 
     switch (type._category)
     {
@@ -406,4 +574,24 @@ string PGResultSet::getValue(int col) const
 }
 
 
+// =============== COLUMN GETTERS  ===============
+
+vector<int> PGResultSet::getIntColumn(int col)
+{
+    vector<int> values;
+    return decodeIntegerColumn(col, values) ? values : ResultSet::getIntColumn(col);
+}
+
+vector<long long> PGResultSet::getInt8Column(int col)
+{
+    vector<long long> values;
+    return decodeIntegerColumn(col, values) ? values : ResultSet::getInt8Column(col);
+}
+
+vector<double> PGResultSet::getFloat8Column(int col)
+{
+    vector<double> values;
+    return decodeFloatColumn(col, values) ? values : ResultSet::getFloat8Column(col);
+}
+
 }
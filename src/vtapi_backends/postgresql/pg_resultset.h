@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vtapi/plugins/backend_resultset.h>
+#include <libpq-fe.h>
+#include <vector>
 
 namespace vtapi {
 
@@ -218,6 +220,29 @@ public:
      */
     std::vector<char> getBlob(int col) const override;
 
+    // =============== COLUMN GETTERS ===============
+
+    /**
+     * Gets integer values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    std::vector<int> getIntColumn(int col) override;
+
+    /**
+     * Gets long integer values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    std::vector<long long> getInt8Column(int col) override;
+
+    /**
+     * Gets double values of all rows of a column
+     * @param col column index
+     * @return contiguous vector of values, one per row
+     */
+    std::vector<double> getFloat8Column(int col) override;
+
 
     // ////////////////////////////////////////////////////////////////////////
     // OWN IMPLEMENTATION
@@ -231,6 +256,31 @@ public:
     { clear(); }
 
 private:
+    typedef long long (*IntegerDecoder)(const PGresult *res, int pos, int col);
+    typedef double (*FloatDecoder)(const PGresult *res, int pos, int col);
+
+    /**
+     * @brief Column type information and decoders precomputed for each result
+     */
+    class ColumnDecoder
+    {
+    public:
+        Oid _oid;                   /**< column type OID */
+        short _length;              /**< type length in bytes, -1 = variable */
+        short _category;            /**< DatabaseTypes::TypeCategory */
+        char _flags;                /**< DatabaseTypes::TypeFlag combination */
+        IntegerDecoder _integer;    /**< integer value decoder, NULL = generic */
+        FloatDecoder _float;        /**< float value decoder, NULL = generic */
+
+        ColumnDecoder()
+            : _oid(0), _length(0), _category(0), _flags(0),
+            _integer(NULL), _float(NULL) {}
+    };
+
+    std::vector<ColumnDecoder> _decoders;   /**< per column decoders of current result */
+
+    void createDecoders();
+    const ColumnDecoder & getDecoder(int col) const;
     short getKeyTypeLength(int col, short def) const;
 
     template <typename T>
@@ -244,6 +294,12 @@ private:
 
     template <typename T>
     std::vector<T> getFloatVector(int col) const;
+
+    template <typename T>
+    bool decodeIntegerColumn(int col, std::vector<T> &values) const;
+
+    template <typename T>
+    bool decodeFloatColumn(int col, std::vector<T> &values) const;
 };
 
 }
@@ -53,6 +53,11 @@ bool SLConnection::isConnected () const
     }
 }
 
+bool SLConnection::isInTransaction() const
+{
+    return (SLCONN && sqlite3_get_autocommit(SLCONN) == 0);
+}
+
 bool SLConnection::execute(const string& query, void *param)
 {
     SLparam     *sl_param   = (SLparam *) param;
@@ -70,6 +75,7 @@ bool SLConnection::execute(const string& query, void *param)
     }
     else {
         retval = sqlite3_exec(SLCONN, query.c_str(), NULL, NULL, &errmsg) == SQLITE_OK;
+        updateTransactionSerial();
         if (!retval) {
             if (errmsg) {
                 _error_message = string(errmsg);
@@ -85,6 +91,25 @@ bool SLConnection::execute(const string& query, void *param)
     return retval;
 }
 
+bool SLConnection::executePipeline(const vector< pair<string, void *> >& queries)
+{
+    bool retval = true;
+
+    bool transaction = !isInTransaction();
+    if (transaction && !execute("BEGIN;", NULL))
+        return false;
+
+    for (const auto & query : queries) {
+        if (!(retval = execute(query.first, query.second)))
+            break;
+    }
+
+    if (transaction && !execute(retval ? "COMMIT;" : "ROLLBACK;", NULL))
+        retval = false;
+
+    return retval;
+}
+
 int SLConnection::fetch(const string& query, void *param, ResultSet &resultSet)
 {
     SLparam     *sl_param   = (SLparam *) param;
@@ -104,6 +129,7 @@ int SLConnection::fetch(const string& query, void *param, ResultSet &resultSet)
     else {
         retquery = sqlite3_get_table(SLCONN, query.c_str(), &(sl_res->res),
                                          &(sl_res->rows), &(sl_res->cols), &errmsg);
+        updateTransactionSerial();
         resultSet.newResult((void *) sl_res);
         if (retquery == SQLITE_OK) {
             retval = sl_res->rows;
@@ -123,6 +149,18 @@ int SLConnection::fetch(const string& query, void *param, ResultSet &resultSet)
     return retval;
 }
 
+bool SLConnection::copyFrom(const string& query, const string& data)
+{
+    throw RuntimeException("unimplemented");
+    return false;
+}
+
+bool SLConnection::executeBatch(const string& query, const string& types, const string& data)
+{
+    throw RuntimeException("unimplemented");
+    return false;
+}
+
 bool SLConnection::fixSlashes(string& path) const
 {
     size_t len = path.length();
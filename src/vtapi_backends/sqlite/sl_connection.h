@@ -31,6 +31,12 @@ public:
      */
     bool isConnected() const override;
 
+    /**
+     * Checks if connection is inside explicit transaction block
+     * @return transaction is open (or failed and not ended yet)
+     */
+    bool isInTransaction() const override;
+
     /**
      * Executes query without fetching any result set
      * @param query SQL query string
@@ -39,6 +45,16 @@ public:
      */
     bool execute(const std::string& query, void *param) override;
 
+    /**
+     * Executes independent queries without waiting for each result (if
+     * supported by backend, sequentially otherwise), execution stops on error.
+     * Queries run in one transaction (current one, or one opened for them),
+     * so either all of them or none are committed.
+     * @param queries SQL query strings with query parameters
+     * @return success of all queries
+     */
+    bool executePipeline(const std::vector< std::pair<std::string, void *> >& queries) override;
+
     /**
      * Executes query and fetc hes new result set
      * @param query SQl query string
@@ -48,6 +64,24 @@ public:
      */
     int fetch(const std::string& query, void *param, ResultSet &resultSet) override;
 
+    /**
+     * Executes bulk copy of rows into table
+     * @param query copy query string (@see QueryBuilder::getCopyQuery)
+     * @param data rows data (@see QueryBuilder::appendCopyRow)
+     * @return success
+     */
+    bool copyFrom(const std::string& query, const std::string& data) override;
+
+    /**
+     * Executes query with values given as bulk copy rows data
+     * @param query query string (@see QueryBuilder::getInsertBatchQuery)
+     * @param types types of values in one row (@see QueryBuilder::getCopyTypes)
+     * @param data rows data (@see QueryBuilder::appendCopyRow)
+     * @return success
+     */
+    bool executeBatch(const std::string& query, const std::string& types,
+                      const std::string& data) override;
+
 
     // ////////////////////////////////////////////////////////////////////////
     // OWN IMPLEMENTATION
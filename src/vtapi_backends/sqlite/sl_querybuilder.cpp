@@ -43,6 +43,12 @@ void *SLQueryBuilder::duplicateQueryParam(void *param) const
     }
 }
 
+void *SLQueryBuilder::createSeekQueryParam(const vector<string> &seekvalues) const
+{
+    throw RuntimeException("unimplemented");
+    return NULL;
+}
+
 string SLQueryBuilder::getGenericQuery() const
 {
     throw RuntimeException("unimplemented");
@@ -55,6 +61,13 @@ string SLQueryBuilder::getSelectQuery(const string &groupby, const string &order
     return string();
 }
 
+string SLQueryBuilder::getSelectSeekQuery(const string &groupby, const vector<string> &seekkeys,
+                                          const vector<string> &seektypes, int limit) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
 string SLQueryBuilder::getInsertQuery() const
 {
     throw RuntimeException("unimplemented");
@@ -79,6 +92,18 @@ string SLQueryBuilder::getCountQuery() const
     return string();
 }
 
+string SLQueryBuilder::getCountLimitQuery(int limit) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
+string SLQueryBuilder::getCountEstimateQuery() const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
 string SLQueryBuilder::getBeginQuery() const
 {
     throw RuntimeException("unimplemented");
@@ -97,6 +122,24 @@ string SLQueryBuilder::getRollbackQuery() const
     return string();
 }
 
+string SLQueryBuilder::getDeclareCursorQuery(const string &name, const string &query) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
+string SLQueryBuilder::getFetchCursorQuery(const string &name, int count) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
+string SLQueryBuilder::getCloseCursorQuery(const string &name) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
 string SLQueryBuilder::getDatasetCreateQuery(const string &name, const string &location, const string &friendly_name, const string &description) const
 {
     throw RuntimeException("unimplemented");
@@ -139,12 +182,55 @@ string SLQueryBuilder::getTaskDeleteQuery(const string &dsname, const string &ta
     return string();
 }
 
+string SLQueryBuilder::getEventsStatsQuery(const string &table, const string &key, const string &taskname, const vector<string> &seqnames, const EventFilter *filter) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
+string SLQueryBuilder::getClassOccurrencesQuery(const string &table, const string &taskname, const vector<string> &seqnames) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
+string SLQueryBuilder::getEventsVersionsQuery(const string &table, const string &taskname, const vector<string> &seqnames) const
+{
+    throw RuntimeException("unimplemented");
+    return string();
+}
+
 string SLQueryBuilder::getLastInsertedIdQuery() const
 {
     throw RuntimeException("unimplemented");
     return string();
 }
 
+void SLQueryBuilder::setCopyCapture(bool enable)
+{
+    // bulk copy is not supported, INSERT is used instead
+}
+
+string SLQueryBuilder::getCopyQuery() const
+{
+    return string();
+}
+
+bool SLQueryBuilder::appendCopyRow(string& data) const
+{
+    return false;
+}
+
+string SLQueryBuilder::getInsertBatchQuery(unsigned int rows) const
+{
+    return string();
+}
+
+string SLQueryBuilder::getCopyTypes() const
+{
+    return string();
+}
+
 bool SLQueryBuilder::keyBool(const string &key, bool value, const string &from)
 {
     throw RuntimeException("unimplemented");
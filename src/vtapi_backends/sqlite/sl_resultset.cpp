@@ -15,6 +15,16 @@ void SLResultSet::newResult(void *res)
 {
     clear();
     _res = res;
+    _generation++;
+
+    // first row of result table contains column keys
+    if (_res) {
+        _keyindex.reserve(SLRES->cols);
+        for (int col = 0; col < SLRES->cols; col++) {
+            if (SLRES->res[col])
+                _keyindex.insert(std::make_pair(SLRES->res[col], col));
+        }
+    }
 }
 
 int SLResultSet::countRows() const
@@ -39,6 +49,7 @@ void SLResultSet::clear()
         delete SLRES;
         _res = NULL;
     }
+    _keyindex.clear();
 }
 
 TKey SLResultSet::getKey(int col) const
@@ -64,12 +75,8 @@ string SLResultSet::getKeyType(const int col) const
 
 int SLResultSet::getKeyIndex(const string& key) const
 {
-    for (int col = 0; col < SLRES->cols; col++) {
-        if (string(SLRES->res[col]).compare(key) == 0) {
-            return col;
-        }
-    }
-    return -1;
+    auto it = _keyindex.find(key);
+    return (it != _keyindex.end()) ? it->second : -1;
 }
 
 
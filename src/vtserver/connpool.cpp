@@ -0,0 +1,106 @@
+// VTServer application - database connection pool
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// Pool of VTApi objects (each with own DB connection) shared by RPC threads.
+// Every thread remembers slot it used last time and tries to take it again
+// without locking. Mutex is used only when thread has to wait for free slot.
+
+#include "connpool.h"
+
+namespace vtserver {
+
+
+ConnectionPool::ConnectionPool(const vtapi::VTApi &vtapi, unsigned int size, unsigned int timeout_ms)
+    : _timeout(timeout_ms), _waiting(0)
+{
+    if (size == 0) size = 1;
+
+    _slots.reserve(size);
+    for (unsigned int i = 0; i < size; i++)
+        _slots.push_back(std::unique_ptr<Slot>(new Slot(vtapi)));
+}
+
+ConnectionPool::Handle ConnectionPool::checkout()
+{
+    // slot used last time by this thread
+    static thread_local ConnectionPool *last_pool = NULL;
+    static thread_local int last_index = -1;
+
+    if (last_pool == this && tryAcquire(last_index))
+        return acquired(last_index);
+
+    int index = tryAcquireAny();
+
+    if (index < 0) {
+        std::unique_lock<std::mutex> lock(_mtx);
+
+        _waiting++;
+        _cond.wait_for(lock, _timeout, [&] { return (index = tryAcquireAny()) >= 0; });
+        _waiting--;
+    }
+
+    if (index < 0)
+        return Handle();
+
+    last_pool = this;
+    last_index = index;
+
+    return acquired(index);
+}
+
+ConnectionPool::Handle ConnectionPool::tryCheckout()
+{
+    int index = tryAcquireAny();
+    if (index < 0)
+        return Handle();
+
+    return acquired(index);
+}
+
+bool ConnectionPool::tryAcquire(int index)
+{
+    bool expected = false;
+    return _slots[index]->_in_use.compare_exchange_strong(expected, true);
+}
+
+int ConnectionPool::tryAcquireAny()
+{
+    for (size_t i = 0; i < _slots.size(); i++) {
+        if (tryAcquire(i)) return i;
+    }
+
+    return -1;
+}
+
+ConnectionPool::Handle ConnectionPool::acquired(int index)
+{
+    // health check, reconnect broken connection
+    if (!_slots[index]->_vtapi->checkConnection()) {
+        release(index);
+        return Handle();
+    }
+
+    return Handle(this, index);
+}
+
+void ConnectionPool::release(int index)
+{
+    _slots[index]->_in_use = false;
+
+    // waiter increments counter under lock before checking slots
+    if (_waiting > 0) {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _cond.notify_one();
+    }
+}
+
+void ConnectionPool::Handle::release()
+{
+    if (_pool) {
+        _pool->release(_index);
+        _pool = NULL;
+    }
+}
+
+
+}
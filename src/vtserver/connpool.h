@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vtapi/vtapi.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+namespace vtserver {
+
+
+class ConnectionPool
+{
+public:
+    /**
+     * @brief Checked out connection, returned to pool on destruction
+     */
+    class Handle
+    {
+    public:
+        Handle()
+            : _pool(NULL), _index(-1) {}
+        Handle(Handle && other)
+            : _pool(other._pool), _index(other._index)
+        { other._pool = NULL; }
+        ~Handle()
+        { release(); }
+
+        explicit operator bool() const
+        { return _pool != NULL; }
+
+        vtapi::VTApi & operator*() const
+        { return *_pool->_slots[_index]->_vtapi; }
+
+        void release();
+
+    private:
+        ConnectionPool *_pool;
+        int _index;
+
+        Handle(ConnectionPool *pool, int index)
+            : _pool(pool), _index(index) {}
+
+        Handle(const Handle &) = delete;
+        Handle & operator=(const Handle &) = delete;
+
+        friend class ConnectionPool;
+    };
+
+    ConnectionPool(const vtapi::VTApi &vtapi, unsigned int size, unsigned int timeout_ms);
+
+    /**
+     * @brief Checks out free connection, waits up to timeout if there is none
+     * @return connection handle, empty on timeout or broken connection
+     */
+    Handle checkout();
+
+    /**
+     * @brief Checks out free connection without waiting
+     * @return connection handle, empty if there is no free connection
+     */
+    Handle tryCheckout();
+
+    unsigned int size() const
+    { return _slots.size(); }
+
+private:
+    class Slot
+    {
+    public:
+        std::unique_ptr<vtapi::VTApi> _vtapi;
+        std::atomic_bool _in_use;
+
+        explicit Slot(const vtapi::VTApi &vtapi)
+            : _vtapi(new vtapi::VTApi(vtapi)), _in_use(false) {}
+    };
+
+    std::vector< std::unique_ptr<Slot> > _slots;
+    const std::chrono::milliseconds _timeout;
+    std::mutex _mtx;                // only for waiting on free slot
+    std::condition_variable _cond;
+    std::atomic_int _waiting;
+
+    bool tryAcquire(int index);
+    int tryAcquireAny();
+    Handle acquired(int index);
+    void release(int index);
+
+    ConnectionPool() = delete;
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool & operator=(const ConnectionPool &) = delete;
+};
+
+
+}
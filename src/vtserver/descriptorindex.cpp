@@ -0,0 +1,338 @@
+// VTServer application - similarity index of event descriptors
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// In-memory vector index of EDF descriptors of task output in whole dataset,
+// for k nearest neighbours search. Small indexes are searched by brute force,
+// larger ones are grouped to inverted lists (IVF) and only lists nearest
+// to query are searched. Kept index is not rebuilt when only new events
+// were inserted, they are added to its copy instead (copy shares unchanged
+// data with it). Lists are regrouped by background thread of store.
+
+#include "descriptorindex.h"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+#define MIN_LISTS_SIZE      4096    // smaller indexes are searched by brute force
+#define LISTS_REGROUP       2       // lists are regrouped after index has grown 2x
+#define SEARCH_PROBES       8       // lists searched by non-exact search
+#define EVENTS_CHUNK        4096    // indexed events in one chunk
+
+using namespace std;
+
+namespace vtserver {
+
+
+DescriptorIndex::DescriptorIndex()
+    : _seqnames(make_shared<SequenceNames>()), _last_id(0), _events(0),
+      _created(chrono::steady_clock::now())
+{
+}
+
+void DescriptorIndex::addEvent(int event_id, const string &seqname, const vtapi::EyedeaEdfDescriptor &desc)
+{
+    _last_id = event_id;
+    _events++;
+
+    if (!_descriptors.add(event_id, desc))
+        return;
+
+    // data shared with copies are copied before change
+    auto it = _seqnames->index.find(seqname);
+    if (it == _seqnames->index.end()) {
+        if (_seqnames.use_count() > 1)
+            _seqnames = make_shared<SequenceNames>(*_seqnames);
+        it = _seqnames->index.emplace(seqname, static_cast<uint32_t>(_seqnames->names.size())).first;
+        _seqnames->names.push_back(seqname);
+    }
+
+    if (_chunks.empty() || _chunks.back()->event_ids.size() >= EVENTS_CHUNK) {
+        _chunks.push_back(make_shared<Chunk>());
+        _chunks.back()->event_ids.reserve(EVENTS_CHUNK);
+        _chunks.back()->sequences.reserve(EVENTS_CHUNK);
+    }
+    else if (_chunks.back().use_count() > 1) {
+        _chunks.back() = make_shared<Chunk>(*_chunks.back());
+    }
+    _chunks.back()->event_ids.push_back(event_id);
+    _chunks.back()->sequences.push_back(it->second);
+}
+
+bool DescriptorIndex::needsTraining() const
+{
+    size_t size = _descriptors.size();
+
+    return size >= MIN_LISTS_SIZE &&
+           (!_descriptors.trained() || size >= _descriptors.trainedSize() * LISTS_REGROUP);
+}
+
+void DescriptorIndex::train()
+{
+    if (needsTraining())
+        _descriptors.train(static_cast<size_t>(std::sqrt(static_cast<double>(_descriptors.size()))));
+}
+
+void DescriptorIndex::useTrained(const DescriptorIndex &trained)
+{
+    vtapi::EdfDescriptorIndex descriptors = trained._descriptors;
+    descriptors.addFrom(_descriptors, trained._last_id);
+    _descriptors = std::move(descriptors);
+}
+
+vector<vtapi::EdfDescriptorIndex::Neighbor> DescriptorIndex::search(const vtapi::EyedeaEdfDescriptor &desc,
+                                                                    size_t k, bool exact) const
+{
+    return _descriptors.search(desc, k, exact ? 0 : SEARCH_PROBES);
+}
+
+const string & DescriptorIndex::sequence(int event_id) const
+{
+    static const string none;
+
+    // chunks are never empty
+    auto chunk = std::lower_bound(_chunks.begin(), _chunks.end(), event_id,
+        [](const shared_ptr<Chunk> &item, int id) { return item->event_ids.back() < id; });
+    if (chunk == _chunks.end())
+        return none;
+
+    const vector<int> &event_ids = (*chunk)->event_ids;
+    auto it = std::lower_bound(event_ids.begin(), event_ids.end(), event_id);
+    if (it == event_ids.end() || *it != event_id)
+        return none;
+
+    return _seqnames->names[(*chunk)->sequences[it - event_ids.begin()]];
+}
+
+bool DescriptorIndex::isCurrent(const Versions &versions) const
+{
+    if (_versions.empty() || versions.size() != _versions.size())
+        return false;
+
+    for (size_t i = 0; i < versions.size(); i++) {
+        if (versions[i].seqname != _versions[i].seqname || versions[i].modified != _versions[i].modified)
+            return false;
+    }
+
+    return true;
+}
+
+bool DescriptorIndex::isUpdatable(const Versions &versions) const
+{
+    if (_versions.empty())
+        return false;
+
+    // events of sequence were updated or deleted
+    for (const auto & item : versions) {
+        if (item.changed != changedOf(item.seqname))
+            return false;
+    }
+
+    // sequence with events was deleted
+    for (const auto & item : _versions) {
+        if (item.modified == 0)
+            continue;
+        auto it = std::find_if(versions.begin(), versions.end(),
+            [&item](const vtapi::QueryEventsVersions::Version &v) { return v.seqname == item.seqname; });
+        if (it == versions.end())
+            return false;
+    }
+
+    return true;
+}
+
+size_t DescriptorIndex::bytes() const
+{
+    size_t size = _descriptors.bytes() +
+                  _chunks.capacity() * sizeof(_chunks[0]) +
+                  _versions.capacity() * sizeof(_versions[0]);
+    for (const auto & chunk : _chunks)
+        size += sizeof(Chunk) + chunk->event_ids.capacity() * sizeof(int) + chunk->sequences.capacity() * sizeof(uint32_t);
+    for (const auto & seqname : _seqnames->names)
+        size += 2 * (sizeof(seqname) + seqname.capacity());
+
+    return size;
+}
+
+long long DescriptorIndex::changedOf(const string &seqname) const
+{
+    // versions are ordered by sequence name
+    auto it = std::lower_bound(_versions.begin(), _versions.end(), seqname,
+        [](const vtapi::QueryEventsVersions::Version &item, const string &name) { return item.seqname < name; });
+
+    return it != _versions.end() && it->seqname == seqname ? it->changed : 0;
+}
+
+
+DescriptorIndexStore::DescriptorIndexStore(ResponseCache &cache, size_t max_bytes, unsigned int ttl_ms)
+    : _cache(cache), _max_bytes(max_bytes), _ttl(ttl_ms), _bytes(0), _train_stop(false)
+{
+    if (_max_bytes > 0)
+        _trainer = std::thread(&DescriptorIndexStore::trainerLoop, this);
+}
+
+DescriptorIndexStore::~DescriptorIndexStore()
+{
+    if (_trainer.joinable()) {
+        {
+            lock_guard<mutex> lock(_mtx);
+            _train_stop = true;
+        }
+        _train_cond.notify_all();
+        _trainer.join();
+    }
+}
+
+shared_ptr<const DescriptorIndex> DescriptorIndexStore::get(const string &dsname, const string &taskname,
+                                                            bool &current)
+{
+    current = false;
+    if (_max_bytes == 0) return NULL;
+
+    uint64_t version = _cache.datasetVersion(dsname);
+    bool written = _cache.isWritten(dsname);
+
+    lock_guard<mutex> lock(_mtx);
+
+    auto it = _entries.find(makeKey(dsname, taskname));
+    if (it == _entries.end())
+        return NULL;
+
+    // without versions, updates add new events only, changes of loaded ones appear after rebuild
+    if (!it->second._index->hasVersions() &&
+        chrono::steady_clock::now() - it->second._index->created() > _ttl) {
+        erase(it);
+        return NULL;
+    }
+
+    // events may have been added
+    current = !written && it->second._version == version;
+
+    _lru.splice(_lru.begin(), _lru, it->second._lru);
+    return it->second._index;
+}
+
+void DescriptorIndexStore::put(const string &dsname, const string &taskname,
+                               shared_ptr<const DescriptorIndex> index, uint64_t version)
+{
+    if (_max_bytes == 0 || !index) return;
+
+    // index is kept even while dataset is being written to, get reports it
+    // as outdated then and it is updated by events inserted meanwhile
+
+    // single index may take only part of memory
+    if (index->bytes() > _max_bytes / 2)
+        return;
+
+    string key = makeKey(dsname, taskname);
+
+    lock_guard<mutex> lock(_mtx);
+
+    auto it = _entries.find(key);
+    if (it != _entries.end()) {
+        // concurrent request may have kept more recent index
+        if (it->second._index->lastEventId() > index->lastEventId())
+            return;
+        erase(it);
+    }
+
+    bool train = index->needsTraining();
+    keep(key, std::move(index), version);
+
+    if (train && std::find(_train_keys.begin(), _train_keys.end(), key) == _train_keys.end()) {
+        _train_keys.push_back(key);
+        _train_cond.notify_one();
+    }
+}
+
+string DescriptorIndexStore::makeKey(const string &dsname, const string &taskname)
+{
+    string key = dsname;
+    key += '\0';
+    key += taskname;
+
+    return key;
+}
+
+void DescriptorIndexStore::keep(const string &key, shared_ptr<const DescriptorIndex> index, uint64_t version)
+{
+    size_t size = index->bytes();
+
+    while (!_lru.empty() && _bytes + size > _max_bytes)
+        erase(_entries.find(_lru.back()));
+
+    Entry entry;
+    entry._index = std::move(index);
+    entry._version = version;
+    entry._bytes = size;
+    _lru.push_front(key);
+    entry._lru = _lru.begin();
+    _entries.emplace(key, std::move(entry));
+    _bytes += size;
+}
+
+void DescriptorIndexStore::erase(unordered_map<string, Entry>::iterator it)
+{
+    _bytes -= it->second._bytes;
+    _lru.erase(it->second._lru);
+    _entries.erase(it);
+}
+
+void DescriptorIndexStore::trainerLoop()
+{
+    unique_lock<mutex> lock(_mtx);
+
+    while (true) {
+        _train_cond.wait(lock, [this] { return _train_stop || !_train_keys.empty(); });
+        if (_train_stop) break;
+
+        string key = std::move(_train_keys.front());
+        _train_keys.pop_front();
+
+        auto it = _entries.find(key);
+        if (it == _entries.end())
+            continue;
+        shared_ptr<const DescriptorIndex> base = it->second._index;
+
+        // requests search kept index meanwhile
+        lock.unlock();
+        shared_ptr<DescriptorIndex> trained;
+        try {
+            trained = make_shared<DescriptorIndex>(*base);
+            trained->train();
+        }
+        catch (std::exception &e) {
+            std::cerr << "Error: descriptor index training failed: " << e.what() << std::endl;
+            trained.reset();
+        }
+        lock.lock();
+        if (!trained)
+            continue;
+
+        // kept index may have been updated by new events meanwhile (its copy
+        // is updated then and checked again), or rebuilt (training is dropped)
+        while (true) {
+            it = _entries.find(key);
+            if (it == _entries.end() || it->second._index->created() != base->created())
+                break;
+
+            shared_ptr<const DescriptorIndex> kept = it->second._index;
+            if (kept == base) {
+                uint64_t version = it->second._version;
+                erase(it);
+                keep(key, std::move(trained), version);
+                break;
+            }
+
+            lock.unlock();
+            shared_ptr<DescriptorIndex> updated = make_shared<DescriptorIndex>(*kept);
+            updated->useTrained(*trained);
+            lock.lock();
+
+            base = std::move(kept);
+            trained = std::move(updated);
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "responsecache.h"
+#include <vtapi/data/edfdescriptorindex.h>
+#include <vtapi/queries/predefined.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+namespace vtserver {
+
+
+class DescriptorIndex
+{
+public:
+    typedef std::vector<vtapi::QueryEventsVersions::Version> Versions;
+
+    DescriptorIndex();
+
+    /**
+     * @brief Copies index, copy shares data with it until they are changed
+     * (it's cheap to copy index and add new events to the copy)
+     */
+    DescriptorIndex(const DescriptorIndex &) = default;
+
+    /**
+     * @brief Adds event with descriptor, events must be added in order of IDs
+     * @param event_id event ID
+     * @param seqname sequence of event
+     * @param desc event descriptor
+     */
+    void addEvent(int event_id, const std::string &seqname, const vtapi::EyedeaEdfDescriptor &desc);
+
+    /**
+     * @brief Checks if descriptors should be grouped to lists (again,
+     * after index has grown since last grouping)
+     * @return train should be called
+     */
+    bool needsTraining() const;
+
+    /**
+     * @brief Groups descriptors to lists if there is enough of them,
+     * it takes long for large index (kept indexes are trained in background)
+     */
+    void train();
+
+    /**
+     * @brief Takes descriptor lists of trained copy of older state of this
+     * index, descriptors of events added since are added to them
+     * @param trained trained copy
+     */
+    void useTrained(const DescriptorIndex &trained);
+
+    /**
+     * @brief Finds k events with descriptor nearest to given one
+     * @param desc query descriptor
+     * @param k number of events
+     * @param exact search all descriptors, not only lists nearest to query
+     * @return events ordered by distance
+     */
+    std::vector<vtapi::EdfDescriptorIndex::Neighbor> search(const vtapi::EyedeaEdfDescriptor &desc,
+                                                            size_t k, bool exact) const;
+
+    /**
+     * @brief Gets sequence of indexed event
+     * @param event_id event ID
+     * @return sequence name
+     */
+    const std::string & sequence(int event_id) const;
+
+    /**
+     * @brief Gets ID of last added event
+     * @return event ID, 0 = no event was added
+     */
+    int lastEventId() const
+    { return _last_id; }
+
+    /**
+     * @brief Gets number of added events, including those with descriptor
+     * not comparable with indexed ones (other version or size)
+     * @return events count
+     */
+    size_t events() const
+    { return _events; }
+
+    /**
+     * @brief Gets time when first event was added (index was not updated by
+     * changes of already added events since)
+     * @return time point
+     */
+    std::chrono::steady_clock::time_point created() const
+    { return _created; }
+
+    /**
+     * @brief Sets versions of events in database read before events were loaded
+     * @param versions versions of all sequences
+     */
+    void setVersions(const Versions &versions)
+    { _versions = versions; }
+
+    /**
+     * @brief Checks if versions of events are known
+     * @return index may be checked by versions
+     */
+    bool hasVersions() const
+    { return !_versions.empty(); }
+
+    /**
+     * @brief Checks if events haven't changed since index was loaded
+     * @param versions current versions of all sequences
+     * @return no event was inserted, updated or deleted
+     */
+    bool isCurrent(const Versions &versions) const;
+
+    /**
+     * @brief Checks if events were only inserted since index was loaded,
+     * so that index may be updated by new events
+     * @param versions current versions of all sequences
+     * @return no event was updated or deleted
+     */
+    bool isUpdatable(const Versions &versions) const;
+
+    /**
+     * @brief Gets approximate memory used by index
+     * @return bytes
+     */
+    size_t bytes() const;
+
+private:
+    // indexed events in chunks, chunks are shared by copies of index
+    class Chunk
+    {
+    public:
+        std::vector<int> event_ids;         // ascending
+        std::vector<uint32_t> sequences;    // to _seqnames
+    };
+
+    class SequenceNames
+    {
+    public:
+        std::vector<std::string> names;
+        std::unordered_map<std::string,uint32_t> index;
+    };
+
+    vtapi::EdfDescriptorIndex _descriptors;
+    std::vector< std::shared_ptr<Chunk> > _chunks;
+    std::shared_ptr<SequenceNames> _seqnames;
+    int _last_id;
+    size_t _events;
+    Versions _versions;                 // ordered by sequence name, empty = unknown
+    std::chrono::steady_clock::time_point _created;
+
+    long long changedOf(const std::string &seqname) const;
+};
+
+
+class DescriptorIndexStore
+{
+public:
+    /**
+     * @param cache response cache, its dataset invalidations make indexes
+     * without versions of events outdated
+     * @param max_bytes memory limit of kept indexes, 0 = indexes are not kept
+     * @param ttl_ms index without versions of events is rebuilt after this time
+     * (changes of events made outside of this server are not seen by it)
+     */
+    DescriptorIndexStore(ResponseCache &cache, size_t max_bytes, unsigned int ttl_ms);
+
+    /**
+     * @brief Stops training thread
+     */
+    ~DescriptorIndexStore();
+
+    /**
+     * @brief Gets kept index of task output
+     * @param dsname dataset name
+     * @param taskname task name
+     * @param current set to false if dataset has changed since index was kept,
+     * index then must be updated by events added meanwhile (only for index
+     * without versions, those are checked by caller)
+     * @return index or NULL if it isn't kept or has expired
+     */
+    std::shared_ptr<const DescriptorIndex> get(const std::string &dsname, const std::string &taskname,
+                                               bool &current);
+
+    /**
+     * @brief Gets current version of dataset, must be read before loading
+     * events for index to be stored with put
+     * @param dsname dataset name
+     * @return version
+     */
+    uint64_t version(const std::string &dsname) const
+    { return _cache.datasetVersion(dsname); }
+
+    /**
+     * @brief Keeps index, least recently used indexes are dropped to free memory.
+     * Index which needs training is trained in background and replaced then.
+     * @param dsname dataset name
+     * @param taskname task name
+     * @param index built or updated index
+     * @param version dataset version read before events were loaded
+     */
+    void put(const std::string &dsname, const std::string &taskname,
+             std::shared_ptr<const DescriptorIndex> index, uint64_t version);
+
+private:
+    class Entry
+    {
+    public:
+        std::shared_ptr<const DescriptorIndex> _index;
+        uint64_t _version;
+        size_t _bytes;
+        std::list<std::string>::iterator _lru;
+    };
+
+    ResponseCache &_cache;
+    const size_t _max_bytes;
+    const std::chrono::milliseconds _ttl;
+    std::mutex _mtx;
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru;        // most recently used first
+    size_t _bytes;
+
+    std::thread _trainer;               // trains kept indexes
+    std::condition_variable _train_cond;
+    std::deque<std::string> _train_keys;
+    bool _train_stop;
+
+    static std::string makeKey(const std::string &dsname, const std::string &taskname);
+    void keep(const std::string &key, std::shared_ptr<const DescriptorIndex> index, uint64_t version);
+    void erase(std::unordered_map<std::string, Entry>::iterator it);
+    void trainerLoop();
+
+    DescriptorIndexStore() = delete;
+    DescriptorIndexStore(const DescriptorIndexStore &) = delete;
+    DescriptorIndexStore & operator=(const DescriptorIndexStore &) = delete;
+};
+
+
+}
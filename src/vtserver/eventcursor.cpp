@@ -0,0 +1,267 @@
+// VTServer application - event list cursor
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// Builds getEventList response from task output events (trajectories).
+// In chunked mode, cursor is kept between requests in a store under
+// a random continuation token. Such cursor has its own database connection,
+// so that it doesn't block pooled connections between requests.
+
+#include "eventcursor.h"
+#include <cstdio>
+
+#define CHUNK_MAX_REGIONS   100000  // max. regions in one chunk
+#define MAX_TRAJECTORIES    16384   // started trajectories remembered by cursor
+#define TOKEN_WORDS         4       // random 32-bit words in token
+
+using namespace vtapi;
+using namespace std;
+namespace vti = vtserver_interface;
+
+namespace vtserver {
+
+
+EventListCursor::EventListCursor(VTApi &vtapi, bool own_connection)
+    : _own_vtapi(own_connection ? new VTApi(vtapi) : NULL),
+      _vtapi(own_connection ? *_own_vtapi : vtapi), _has_row(false)
+{
+}
+
+bool EventListCursor::open(const string &dsname, const string &taskname,
+                           const vector<string> &seqnames,
+                           const EventFilter *filter, string &error)
+{
+    _ds.reset(_vtapi.loadDatasets(dsname));
+    if (!_ds->next()) {
+        error = "Cannot find dataset";
+        return false;
+    }
+
+    _ts.reset(_ds->loadTasks(taskname));
+    if (!_ts->next()) {
+        error = "Cannot find task";
+        return false;
+    }
+
+    // load intervals, possibly filter by sequences
+    _outdata.reset(_ts->loadOutputData());
+    if (!seqnames.empty())
+        _outdata->filterBySequences(seqnames);
+
+    // apply filters
+    if (filter)
+        _outdata->filterByEvent("event", taskname, seqnames, *filter);
+
+    // iterate over events, stream them in chunks to keep memory bounded
+    _outdata->setStreaming(true);
+
+    return true;
+}
+
+bool EventListCursor::fetch(vti::getEventListResponse &reply, unsigned int max_trajectories)
+{
+    // map added sequences to their infos
+    map<string,vti::eventInfoList*> seq_infos;
+    unsigned int trajectories = 0;
+    unsigned int regions = 0;
+
+    // trajectories from previous chunk are not in this reply
+    for (auto & item : _trajectories)
+        item.second._info = NULL;
+
+    BoundKey key_event("event");
+    while (_has_row || _outdata->next()) {
+        _has_row = true;
+
+        // get output event
+        IntervalEvent ev = _outdata->getIntervalEvent(_outdata->getKeyIndex(key_event));
+        auto it_traj = _trajectories.find(ev.group_id);
+
+        // event for trajectory not yet started (child before root) is skipped,
+        // as well as event of forgotten trajectory (reply is incomplete then)
+        if (!ev.is_root && it_traj == _trajectories.end()) {
+            if (_forgotten.count(ev.group_id) > 0)
+                reply.set_truncated(true);
+            _has_row = false;
+            continue;
+        }
+
+        // root of already started trajectory
+        if (ev.is_root && (it_traj != _trajectories.end() || _forgotten.count(ev.group_id) > 0)) {
+            _has_row = false;
+            continue;
+        }
+
+        // chunk is full, keep row for the next one
+        bool new_entry = ev.is_root || !it_traj->second._info;
+        if (max_trajectories > 0 &&
+            ((new_entry && trajectories >= max_trajectories) || regions >= CHUNK_MAX_REGIONS))
+            return true;
+
+        // get sequence info
+        vti::eventInfoList *info;
+        string seqname = _outdata->getParentSequenceName();
+        auto it = seq_infos.find(seqname);
+        if (it == seq_infos.end()) {
+            info = reply.add_events_list();
+            info->set_sequence_id(seqname);
+            seq_infos.insert(std::make_pair(seqname,info));
+        }
+        else {
+            info = (*it).second;
+        }
+
+        int t1 = _outdata->getStartTime();
+        int t2 = _outdata->getEndTime();
+        double to_sec = t2+1 > t1 ? (_outdata->getLengthSeconds() / ((t2+1) - t1)) : 0;
+
+        // add new trajectory root (or non-trajectory event)
+        if (ev.is_root) {
+            // chunked cursor forgets trajectory not extended for the longest
+            // time, it has most likely ended (its later regions are skipped)
+            if (max_trajectories > 0 && _trajectories.size() >= MAX_TRAJECTORIES) {
+                _forgotten.insert(_lru.back());
+                _trajectories.erase(_lru.back());
+                _lru.pop_back();
+            }
+
+            Trajectory & traj = _trajectories[ev.group_id];
+            traj._event_id = _outdata->getId();
+            traj._info = NULL;
+            _lru.push_front(ev.group_id);
+            traj._lru = _lru.begin();
+
+            vti::eventInfo *einfo = addTrajectory(info, traj, ev.group_id);
+            einfo->set_class_id(ev.class_id);
+            einfo->set_score(ev.score);
+            einfo->set_t1(t1);
+            einfo->set_t2(t2);
+            einfo->set_t1_sec(t1*to_sec);
+            einfo->set_t2_sec((t2+1)*to_sec);
+            std::string user_data(ev.user_data.data(), ev.user_data.size());
+            einfo->set_user_data(user_data);
+            trajectories++;
+        }
+        // add event to existing trajectory
+        else {
+            Trajectory & traj = it_traj->second;
+            touchTrajectory(traj);
+            if (!traj._info) {
+                addTrajectory(info, traj, ev.group_id);
+                trajectories++;
+            }
+
+            vti::Region *reg = traj._info->add_regions();
+            reg->set_t(t1);
+            reg->set_t_sec(t1*to_sec);
+            reg->set_x1(ev.region.high.x);
+            reg->set_x2(ev.region.low.x);
+            reg->set_y1(ev.region.high.y);
+            reg->set_y2(ev.region.low.y);
+            regions++;
+        }
+
+        _has_row = false;
+    }
+
+    return false;
+}
+
+vti::eventInfo *EventListCursor::addTrajectory(vti::eventInfoList *info, Trajectory &traj, int group_id)
+{
+    traj._info = info->add_events();
+    traj._info->set_event_id(traj._event_id);
+    traj._info->set_group_id(group_id);
+
+    return traj._info;
+}
+
+void EventListCursor::touchTrajectory(Trajectory &traj)
+{
+    _lru.splice(_lru.begin(), _lru, traj._lru);
+}
+
+
+EventCursorStore::EventCursorStore(unsigned int max_cursors, unsigned int timeout_ms)
+    : _max_cursors(max_cursors > 0 ? max_cursors : 1), _timeout(timeout_ms)
+{
+}
+
+string EventCursorStore::put(unique_ptr<EventListCursor> cursor, const string &token)
+{
+    vector< unique_ptr<EventListCursor> > expired;
+    string ret = token;
+
+    {
+        lock_guard<mutex> lock(_mtx);
+
+        expire(expired);
+
+        // token is the only session identification, it must not be guessable
+        // (random device, not seeded generator)
+        if (ret.empty()) {
+            do {
+                ret.clear();
+                for (int i = 0; i < TOKEN_WORDS; i++) {
+                    char buf[9];
+                    snprintf(buf, sizeof(buf), "%08x", static_cast<unsigned int>(_random()));
+                    ret += buf;
+                }
+            } while (_cursors.count(ret) > 0);
+        }
+
+        // too many cursors, close the least recently used
+        if (_cursors.size() >= _max_cursors) {
+            auto oldest = _cursors.begin();
+            for (auto it = _cursors.begin(); it != _cursors.end(); ++it) {
+                if (it->second._used < oldest->second._used) oldest = it;
+            }
+            expired.push_back(std::move(oldest->second._cursor));
+            _cursors.erase(oldest);
+        }
+
+        Entry & entry = _cursors[ret];
+        entry._cursor = std::move(cursor);
+        entry._used = chrono::steady_clock::now();
+    }
+
+    // expired cursors are closed outside of lock (DB calls)
+    return ret;
+}
+
+unique_ptr<EventListCursor> EventCursorStore::take(const string &token)
+{
+    vector< unique_ptr<EventListCursor> > expired;
+    unique_ptr<EventListCursor> cursor;
+
+    {
+        lock_guard<mutex> lock(_mtx);
+
+        expire(expired);
+
+        auto it = _cursors.find(token);
+        if (it != _cursors.end()) {
+            cursor = std::move(it->second._cursor);
+            _cursors.erase(it);
+        }
+    }
+
+    return cursor;
+}
+
+void EventCursorStore::expire(vector< unique_ptr<EventListCursor> > &expired)
+{
+    auto now = chrono::steady_clock::now();
+
+    for (auto it = _cursors.begin(); it != _cursors.end(); ) {
+        if (now - it->second._used > _timeout) {
+            expired.push_back(std::move(it->second._cursor));
+            it = _cursors.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+
+}
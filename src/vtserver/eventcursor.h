@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vtapi/vtapi.h>
+#include "vtserver_interface.rpcz.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <chrono>
+
+namespace vtserver {
+
+
+class EventListCursor
+{
+public:
+    /**
+     * @brief Constructs cursor over task's output events
+     * @param vtapi VTApi object to use
+     * @param own_connection cursor makes own copy of VTApi (with own connection),
+     *        so that it can outlive the request
+     */
+    EventListCursor(vtapi::VTApi &vtapi, bool own_connection);
+
+    /**
+     * @brief Opens cursor
+     * @param dsname dataset name
+     * @param taskname task name
+     * @param seqnames sequences to filter by (empty = all)
+     * @param filter event filter, NULL for none
+     * @param error output error message
+     * @return success
+     */
+    bool open(const std::string &dsname, const std::string &taskname,
+              const std::vector<std::string> &seqnames,
+              const vtapi::EventFilter *filter, std::string &error);
+
+    /**
+     * @brief Fetches next chunk of trajectories into reply
+     * Regions of trajectory sent in previous chunk are sent as an event
+     * with the same event_id and only regions filled. Chunked cursor remembers
+     * only limited number of recently extended trajectories, regions of
+     * forgotten ones are dropped and reply is marked as truncated.
+     * @param reply output reply
+     * @param max_trajectories max. events in chunk, 0 = fetch all
+     * @return true if there are more events to fetch
+     */
+    bool fetch(vtserver_interface::getEventListResponse &reply, unsigned int max_trajectories);
+
+private:
+    class Trajectory
+    {
+    public:
+        int _event_id;
+        vtserver_interface::eventInfo *_info;   // info in current chunk (NULL = not yet)
+        std::list<int>::iterator _lru;
+    };
+
+    std::unique_ptr<vtapi::VTApi> _own_vtapi;
+    vtapi::VTApi &_vtapi;
+    std::unique_ptr<vtapi::Dataset> _ds;
+    std::unique_ptr<vtapi::Task> _ts;
+    std::unique_ptr<vtapi::Interval> _outdata;
+    std::unordered_map<int, Trajectory> _trajectories;  // group ID => trajectory
+    std::list<int> _lru;                        // group IDs, most recently extended first
+    std::unordered_set<int> _forgotten;         // group IDs of forgotten trajectories
+    bool _has_row;                              // current row was not processed yet
+
+    vtserver_interface::eventInfo *addTrajectory(vtserver_interface::eventInfoList *info,
+                                                 Trajectory &traj, int group_id);
+    void touchTrajectory(Trajectory &traj);
+
+    EventListCursor() = delete;
+    EventListCursor(const EventListCursor &) = delete;
+    EventListCursor & operator=(const EventListCursor &) = delete;
+};
+
+
+class EventCursorStore
+{
+public:
+    /**
+     * @param max_cursors max. open cursors, the least recently used is closed
+     * @param timeout_ms idle cursor is closed after this time
+     */
+    EventCursorStore(unsigned int max_cursors, unsigned int timeout_ms);
+
+    /**
+     * @brief Stores cursor for later use
+     * @param cursor cursor to store
+     * @param token cursor's token, empty = generate new
+     * @return cursor's token
+     */
+    std::string put(std::unique_ptr<EventListCursor> cursor, const std::string &token);
+
+    /**
+     * @brief Takes cursor out of store (nobody else can use it meanwhile)
+     * @param token cursor's token
+     * @return cursor, NULL for invalid or expired token
+     */
+    std::unique_ptr<EventListCursor> take(const std::string &token);
+
+private:
+    class Entry
+    {
+    public:
+        std::unique_ptr<EventListCursor> _cursor;
+        std::chrono::steady_clock::time_point _used;
+    };
+
+    const unsigned int _max_cursors;
+    const std::chrono::milliseconds _timeout;
+    std::mutex _mtx;
+    std::map<std::string, Entry> _cursors;
+    std::random_device _random;
+
+    void expire(std::vector< std::unique_ptr<EventListCursor> > &expired);
+
+    EventCursorStore() = delete;
+    EventCursorStore(const EventCursorStore &) = delete;
+    EventCursorStore & operator=(const EventCursorStore &) = delete;
+};
+
+
+}
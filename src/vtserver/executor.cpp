@@ -0,0 +1,192 @@
+// VTServer application - request executor
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// Worker threads processing RPC requests. Each worker has own job deques
+// (one per priority lane), takes jobs from front of its own deques and steals
+// from back of other workers' deques when it has nothing to do.
+// Metadata lane is always served first. Number of workers running heavy jobs
+// at once is limited, so cheap requests never wait behind long event scans.
+
+#include "executor.h"
+#include <iostream>
+
+namespace vtserver {
+
+
+// index of worker owned by current thread (-1 = not a worker)
+static thread_local int worker_index = -1;
+static thread_local Executor *worker_executor = NULL;
+
+
+Executor::Executor(unsigned int workers, unsigned int heavy_workers, unsigned int queue_size)
+    : _heavy_limit(heavy_workers > 0 && heavy_workers < workers ? heavy_workers : (workers > 1 ? workers - 1 : 1)),
+      _queue_size(queue_size > 0 ? queue_size : 1),
+      _pending(0), _heavy_running(0), _next(0), _stop(false)
+{
+    if (workers == 0) workers = 1;
+
+    for (unsigned int lane = 0; lane < LANE_COUNT; lane++)
+        _queued[lane] = 0;
+
+    _workers.reserve(workers);
+    for (unsigned int i = 0; i < workers; i++)
+        _workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+    _threads.reserve(workers);
+    for (unsigned int i = 0; i < workers; i++)
+        _threads.push_back(std::thread(&Executor::run, this, i));
+}
+
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _cond.notify_all();
+
+    for (std::thread & thread : _threads)
+        thread.join();
+}
+
+bool Executor::submit(Lane lane, Job job)
+{
+    // bounded queue, reserve place first
+    if (_pending.fetch_add(1) >= _queue_size) {
+        _pending--;
+        return false;
+    }
+
+    // worker thread submits to own deque, others round-robin
+    unsigned int index = (worker_executor == this) ?
+        worker_index : _next.fetch_add(1) % _workers.size();
+
+    {
+        Worker & worker = *_workers[index];
+        std::lock_guard<std::mutex> lock(worker._mtx);
+        worker._jobs[lane].push_back(std::move(job));
+        _queued[lane]++;
+    }
+
+    notify(false);
+
+    return true;
+}
+
+void Executor::run(unsigned int index)
+{
+    worker_index = index;
+    worker_executor = this;
+
+    while (true) {
+        Job job;
+        Lane lane;
+
+        if (take(index, job, lane)) {
+            try {
+                job();
+            }
+            catch (std::exception &e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+            }
+            catch (...) {
+                std::cerr << "Error: unknown exception" << std::endl;
+            }
+
+            // heavy slot is free, wake up worker waiting for it
+            if (lane == LANE_HEAVY) {
+                _heavy_running--;
+                if (_queued[LANE_HEAVY] > 0) notify(false);
+            }
+
+            // last job done, let others finish
+            if (_pending == 0 && _stop) notify(true);
+        }
+        else {
+            std::unique_lock<std::mutex> lock(_mtx);
+            if (_stop && _pending == 0)
+                break;
+            _cond.wait(lock, [this] { return canTake() || (_stop && _pending == 0); });
+        }
+    }
+}
+
+bool Executor::take(unsigned int index, Job &job, Lane &lane)
+{
+    for (unsigned int l = 0; l < LANE_COUNT; l++) {
+        lane = static_cast<Lane>(l);
+
+        if (_queued[lane] == 0)
+            continue;
+        if (lane == LANE_HEAVY && !reserveHeavy())
+            continue;
+
+        // own deque first, then steal from others
+        if (takeFrom(*_workers[index], lane, true, job))
+            return true;
+        for (size_t i = 1; i < _workers.size(); i++) {
+            if (takeFrom(*_workers[(index + i) % _workers.size()], lane, false, job))
+                return true;
+        }
+
+        if (lane == LANE_HEAVY) {
+            _heavy_running--;
+            if (_queued[LANE_HEAVY] > 0) notify(false);
+        }
+    }
+
+    return false;
+}
+
+bool Executor::takeFrom(Worker &worker, Lane lane, bool own, Job &job)
+{
+    std::lock_guard<std::mutex> lock(worker._mtx);
+
+    std::deque<Job> & jobs = worker._jobs[lane];
+    if (jobs.empty())
+        return false;
+
+    if (own) {
+        job = std::move(jobs.front());
+        jobs.pop_front();
+    }
+    else {
+        job = std::move(jobs.back());
+        jobs.pop_back();
+    }
+
+    _queued[lane]--;
+    _pending--;
+
+    return true;
+}
+
+bool Executor::reserveHeavy()
+{
+    unsigned int running = _heavy_running;
+    while (running < _heavy_limit) {
+        if (_heavy_running.compare_exchange_weak(running, running + 1))
+            return true;
+    }
+
+    return false;
+}
+
+bool Executor::canTake() const
+{
+    return _queued[LANE_METADATA] > 0 ||
+        (_queued[LANE_HEAVY] > 0 && _heavy_running < _heavy_limit);
+}
+
+void Executor::notify(bool all)
+{
+    // lock so that worker can't miss notification between check and wait
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (all)
+        _cond.notify_all();
+    else
+        _cond.notify_one();
+}
+
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace vtserver {
+
+
+class Executor
+{
+public:
+    /**
+     * @brief Priority lanes, lower value is served first
+     */
+    enum Lane
+    {
+        LANE_METADATA = 0,  /**< cheap requests (datasets, sequences, tasks...) */
+        LANE_HEAVY,         /**< event lists and statistics */
+        LANE_COUNT
+    };
+
+    typedef std::function<void()> Job;
+
+    /**
+     * @brief Starts worker threads
+     * @param workers number of worker threads
+     * @param heavy_workers max. workers running heavy jobs at once
+     * @param queue_size max. jobs waiting for worker
+     */
+    Executor(unsigned int workers, unsigned int heavy_workers, unsigned int queue_size);
+
+    /**
+     * @brief Finishes all queued jobs and stops worker threads
+     */
+    ~Executor();
+
+    /**
+     * @brief Queues job for execution
+     * @param lane priority lane
+     * @param job job to execute
+     * @return false if queue is full
+     */
+    bool submit(Lane lane, Job job);
+
+    unsigned int workers() const
+    { return _threads.size(); }
+
+private:
+    class Worker
+    {
+    public:
+        std::mutex _mtx;
+        std::deque<Job> _jobs[LANE_COUNT];
+    };
+
+    std::vector< std::unique_ptr<Worker> > _workers;
+    std::vector<std::thread> _threads;
+    const unsigned int _heavy_limit;
+    const unsigned int _queue_size;
+
+    std::atomic_uint _queued[LANE_COUNT];   // jobs in worker deques per lane
+    std::atomic_uint _pending;              // queued jobs including those being submitted
+    std::atomic_uint _heavy_running;
+    std::atomic_uint _next;                 // round-robin for external submits
+
+    std::mutex _mtx;                        // only for sleeping workers
+    std::condition_variable _cond;
+    bool _stop;
+
+    void run(unsigned int index);
+    bool take(unsigned int index, Job &job, Lane &lane);
+    bool takeFrom(Worker &worker, Lane lane, bool own, Job &job);
+    bool reserveHeavy();
+    bool canTake() const;
+    void notify(bool all);
+
+    Executor() = delete;
+    Executor(const Executor &) = delete;
+    Executor & operator=(const Executor &) = delete;
+};
+
+
+}
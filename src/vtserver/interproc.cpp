@@ -2,6 +2,7 @@
 // by ifroml[at]fit.vutbr.cz
 //
 // Separate thread to periodically check active processing.
+// Dataset's cached responses are invalidated when its process finishes.
 
 #include "interproc.h"
 #include <chrono>
@@ -9,8 +10,8 @@
 namespace vtserver {
 
 
-Interproc::Interproc()
-    : _stop(false)
+Interproc::Interproc(ResponseCache &cache)
+    : _stop(false), _cache(cache)
 {
     _thread = std::thread(&Interproc::threadLoop, this);
 
@@ -22,8 +23,8 @@ Interproc::~Interproc()
     _thread.join();
 
     // try stopping clients gently
-    for (auto ipc : _clients)
-        ipc->stop();
+    for (auto & client : _clients)
+        client.first->stop();
 
     // give clients time to exit
     std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
@@ -37,16 +38,19 @@ Interproc::~Interproc()
     }
 
     // kill rest with fire
-    for (auto ipc : _clients) {
-        ipc->kill();
-        delete ipc;
+    for (auto & client : _clients) {
+        client.first->kill();
+        delete client.first;
+        _cache.endWrites(client.second);
     }
 }
 
-void Interproc::addClientInstance(vtapi::InterProcessClient *ipc)
+void Interproc::addClientInstance(vtapi::InterProcessClient *ipc, const std::string &dsname)
 {
+    _cache.beginWrites(dsname);
+
     std::lock_guard<std::mutex> lk(_mtx);
-    _clients.push_back(ipc);
+    _clients.push_back(std::make_pair(ipc, dsname));
 }
 
 void Interproc::threadLoop()
@@ -65,9 +69,10 @@ void Interproc::threadLoop()
 void Interproc::checkClients()
 {
     for (auto it = _clients.begin(); it != _clients.end();) {
-        if (!(*it)->isRunning()) {
-            (*it)->wait();
-            delete *it;
+        if (!it->first->isRunning()) {
+            it->first->wait();
+            delete it->first;
+            _cache.endWrites(it->second);
             auto it2 = it++;
             _clients.erase(it2);
         }
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "responsecache.h"
 #include <vtapi/vtapi.h>
 #include <list>
 #include <thread>
 #include <mutex>
+#include <string>
+#include <utility>
 
 namespace vtserver {
 
@@ -11,10 +14,18 @@ namespace vtserver {
 class Interproc
 {
 public:
-    Interproc();
+    /**
+     * @param cache responses of dataset are not cached while its process runs
+     */
+    Interproc(ResponseCache &cache);
     ~Interproc();
 
-    void addClientInstance(vtapi::InterProcessClient *ipc);
+    /**
+     * @brief Adds process instance to check
+     * @param ipc process instance
+     * @param dsname dataset which process writes outputs to
+     */
+    void addClientInstance(vtapi::InterProcessClient *ipc, const std::string &dsname);
 
 private:
     const int _check_period_ms = 250;
@@ -23,7 +34,8 @@ private:
     std::thread _thread;
     std::mutex _mtx;
     std::atomic_bool _stop;
-    std::list<vtapi::InterProcessClient*> _clients;
+    std::list< std::pair<vtapi::InterProcessClient*, std::string> > _clients;
+    ResponseCache &_cache;
 
 
     void threadLoop();
@@ -0,0 +1,115 @@
+// VTServer application - interval statistics
+// by ifroml[at]fit.vutbr.cz
+//
+// Calculate coverage, overlaps of classes, concurrency and gaps of events
+// by sweeping over sorted start/end bounds of intervals. Unlike bitmap in
+// SequenceStats, memory depends only on number of events, not video length.
+
+#include "intervalsweep.h"
+#include <algorithm>
+
+namespace vtserver {
+
+
+IntervalSweep::IntervalSweep(unsigned int video_length)
+    : _sequence_length(video_length), _count_root(0), _count_all(0)
+{
+}
+
+void IntervalSweep::processEvent(unsigned int t1_frame, unsigned int t2_frame, const vtapi::IntervalEvent &event)
+{
+    // add to counts
+    _count_all++;
+    if (event.is_root) _count_root++;
+
+    addInterval(t1_frame, t2_frame, event.class_id, event.group_id);
+}
+
+void IntervalSweep::addInterval(unsigned int t1_frame, unsigned int t2_frame, int class_id, int group_id)
+{
+    // get correct values (1..vidlength), same as in SequenceStats
+    if (t1_frame < 1) t1_frame = 1;
+    if (t2_frame > _sequence_length) t2_frame = _sequence_length;
+    if (t2_frame < t1_frame) t2_frame = t1_frame;
+
+    // event starting after the end of video
+    if (t1_frame > _sequence_length) return;
+
+    // half-open interval [t1, t2 + 1)
+    _bounds.push_back({ t1_frame, +1, class_id, group_id });
+    _bounds.push_back({ t2_frame + 1, -1, class_id, group_id });
+}
+
+IntervalSweep::Result IntervalSweep::calculate() const
+{
+    Result result;
+
+    std::vector<Bound> bounds(_bounds);
+    std::sort(bounds.begin(), bounds.end());
+
+    // active intervals per object and per class (objects, not intervals)
+    std::map<std::pair<int,int>,int> objects;
+    std::map<int,int> classes;
+    unsigned int pos = 1;
+
+    size_t i = 0;
+    while (i <= bounds.size()) {
+        unsigned int next = (i < bounds.size()) ? bounds[i].frame : _sequence_length + 1;
+
+        // account segment [pos, next) with current state
+        if (next > pos) {
+            unsigned int length = next - pos;
+            unsigned int active = objects.size();
+
+            if (result.concurrency.size() <= active)
+                result.concurrency.resize(active + 1, 0);
+            result.concurrency[active] += length;
+
+            if (active > 0) {
+                result.covered += length;
+                for (auto a = classes.begin(); a != classes.end(); ++a) {
+                    result.class_covered[a->first] += length;
+                    for (auto b = std::next(a); b != classes.end(); ++b)
+                        result.class_overlap[std::make_pair(a->first, b->first)] += length;
+                }
+            }
+            else {
+                result.gaps.push_back(std::make_pair(pos, next - 1));
+            }
+
+            pos = next;
+        }
+
+        if (i == bounds.size())
+            break;
+
+        // apply all bounds at this frame
+        for (; i < bounds.size() && bounds[i].frame == next; i++) {
+            const Bound & bound = bounds[i];
+            auto key = std::make_pair(bound.group_id, bound.class_id);
+
+            int & count = objects[key];
+            if (bound.delta > 0 && count++ == 0) {
+                classes[bound.class_id]++;
+            }
+            else if (bound.delta < 0 && --count == 0) {
+                objects.erase(key);
+                if (--classes[bound.class_id] == 0)
+                    classes.erase(bound.class_id);
+            }
+        }
+    }
+
+    return result;
+}
+
+double IntervalSweep::calculateCoverage(const Result &result) const
+{
+    if (_sequence_length == 0) return 0.0;
+
+    return static_cast<double>(result.covered)/_sequence_length;
+}
+
+
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vtapi/data/interval.h>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace vtserver {
+
+
+class IntervalSweep
+{
+public:
+    /**
+     * @brief Results of sweep over all events of sequence (in frames)
+     */
+    class Result
+    {
+    public:
+        unsigned int covered;                           // frames covered by any event
+        std::map<int,unsigned int> class_covered;       // class ID => covered frames
+        std::map<std::pair<int,int>,unsigned int> class_overlap;    // (class ID, class ID) => frames covered by both
+        std::vector<unsigned int> concurrency;          // N => frames with exactly N concurrent objects
+        std::vector< std::pair<unsigned int,unsigned int> > gaps;   // uncovered ranges (first, last frame)
+
+        Result() : covered(0) {}
+    };
+
+    /**
+     * @param video_length sequence length, events are clipped to it
+     */
+    IntervalSweep(unsigned int video_length);
+
+    void processEvent(unsigned int t1_frame, unsigned int t2_frame, const vtapi::IntervalEvent &event);
+
+    /**
+     * @brief Adds interval of one object
+     * @param t1_frame first frame (from 1)
+     * @param t2_frame last frame
+     * @param class_id object class
+     * @param group_id object ID (trajectory), intervals of one object are counted once
+     */
+    void addInterval(unsigned int t1_frame, unsigned int t2_frame, int class_id, int group_id);
+
+    /**
+     * @brief Sweeps over sorted interval bounds, O(n log n)
+     * @return coverage, per-class coverage and overlaps, concurrency histogram and gaps
+     */
+    Result calculate() const;
+
+    double calculateCoverage(const Result &result) const;
+
+    unsigned int length() const
+    { return _sequence_length; }
+    unsigned int count_root() const
+    { return _count_root; }
+    unsigned int count_all() const
+    { return _count_all; }
+
+private:
+    class Bound
+    {
+    public:
+        unsigned int frame;     // frame where object starts or stops being present
+        int delta;              // +1 start, -1 end
+        int class_id;
+        int group_id;
+
+        bool operator<(const Bound &other) const
+        { return frame < other.frame; }
+    };
+
+    unsigned int _sequence_length;
+    std::vector<Bound> _bounds;
+    unsigned int _count_root;
+    unsigned int _count_all;
+
+private:
+    IntervalSweep() = delete;
+};
+
+}
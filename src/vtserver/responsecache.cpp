@@ -0,0 +1,200 @@
+// VTServer application - response cache
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// LRU cache of serialized responses of read-only requests, keyed by request
+// type and serialized request. Responses are tagged by dataset, so that
+// requests modifying dataset (and running processing tasks) invalidate them.
+// Dataset versions let other data kept in memory (spatial indexes) follow
+// the same invalidations.
+
+#include "responsecache.h"
+
+using namespace std;
+
+namespace vtserver {
+
+
+ResponseCache::ResponseCache(size_t max_bytes, unsigned int ttl_ms)
+    : _max_bytes(max_bytes), _ttl(ttl_ms), _generation(0), _all_version(0)
+{
+    _counters.max_bytes = max_bytes;
+}
+
+bool ResponseCache::get(const google::protobuf::Message &request, google::protobuf::Message &response)
+{
+    if (_max_bytes == 0) return false;
+
+    string key = makeKey(request);
+    string data;
+
+    {
+        lock_guard<mutex> lock(_mtx);
+
+        auto it = _entries.find(key);
+        if (it == _entries.end()) {
+            _counters.misses++;
+            return false;
+        }
+
+        if (chrono::steady_clock::now() - it->second._stored > _ttl) {
+            erase(it);
+            _counters.evictions++;
+            _counters.misses++;
+            return false;
+        }
+
+        _lru.splice(_lru.begin(), _lru, it->second._lru);
+        _counters.hits++;
+        data = it->second._data;
+    }
+
+    // parse outside of lock
+    return response.ParseFromString(data);
+}
+
+uint64_t ResponseCache::generation() const
+{
+    lock_guard<mutex> lock(_mtx);
+    return _generation;
+}
+
+void ResponseCache::put(const google::protobuf::Message &request, const string &dsname,
+                        const google::protobuf::Message &response, uint64_t generation)
+{
+    if (_max_bytes == 0) return;
+
+    Entry entry;
+    string key = makeKey(request);
+    if (!response.SerializeToString(&entry._data))
+        return;
+    entry._dsname = dsname;
+    entry._stored = chrono::steady_clock::now();
+
+    // single response may take only part of cache
+    size_t size = entrySize(key, entry);
+    if (size > _max_bytes / 8)
+        return;
+
+    lock_guard<mutex> lock(_mtx);
+
+    // data changed meanwhile or dataset is being written to
+    if (generation != _generation || _writers.count(dsname) > 0)
+        return;
+
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+        erase(it);
+
+    while (!_lru.empty() && _counters.bytes + size > _max_bytes) {
+        erase(_entries.find(_lru.back()));
+        _counters.evictions++;
+    }
+
+    _lru.push_front(key);
+    entry._lru = _lru.begin();
+    _entries.emplace(std::move(key), std::move(entry));
+    _counters.entries++;
+    _counters.bytes += size;
+}
+
+void ResponseCache::invalidate(const string &dsname)
+{
+    lock_guard<mutex> lock(_mtx);
+
+    _generation++;
+    removeDataset(dsname);
+}
+
+void ResponseCache::invalidateAll()
+{
+    lock_guard<mutex> lock(_mtx);
+
+    _generation++;
+    _all_version++;
+    _counters.invalidations += _entries.size();
+    _entries.clear();
+    _lru.clear();
+    _counters.entries = 0;
+    _counters.bytes = 0;
+}
+
+void ResponseCache::beginWrites(const string &dsname)
+{
+    lock_guard<mutex> lock(_mtx);
+
+    _generation++;
+    _writers[dsname]++;
+    removeDataset(dsname);
+}
+
+void ResponseCache::endWrites(const string &dsname)
+{
+    lock_guard<mutex> lock(_mtx);
+
+    auto it = _writers.find(dsname);
+    if (it != _writers.end() && --it->second == 0)
+        _writers.erase(it);
+
+    _generation++;
+    removeDataset(dsname);
+}
+
+uint64_t ResponseCache::datasetVersion(const string &dsname) const
+{
+    lock_guard<mutex> lock(_mtx);
+
+    // both counters only grow, so their sum changes with any of them
+    auto it = _ds_versions.find(dsname);
+    return _all_version + (it != _ds_versions.end() ? it->second : 0);
+}
+
+bool ResponseCache::isWritten(const string &dsname) const
+{
+    lock_guard<mutex> lock(_mtx);
+    return _writers.count(dsname) > 0;
+}
+
+ResponseCache::Counters ResponseCache::counters() const
+{
+    lock_guard<mutex> lock(_mtx);
+    return _counters;
+}
+
+string ResponseCache::makeKey(const google::protobuf::Message &request)
+{
+    string key = request.GetTypeName();
+    key += '\0';
+    request.AppendToString(&key);
+
+    return key;
+}
+
+size_t ResponseCache::entrySize(const string &key, const Entry &entry)
+{
+    return sizeof(Entry) + 2 * key.size() + entry._dsname.size() + entry._data.size();
+}
+
+void ResponseCache::erase(unordered_map<string, Entry>::iterator it)
+{
+    _counters.entries--;
+    _counters.bytes -= entrySize(it->first, it->second);
+    _lru.erase(it->second._lru);
+    _entries.erase(it);
+}
+
+void ResponseCache::removeDataset(const string &dsname)
+{
+    _ds_versions[dsname]++;
+
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        auto next = std::next(it);
+        if (it->second._dsname == dsname) {
+            erase(it);
+            _counters.invalidations++;
+        }
+        it = next;
+    }
+}
+
+
+}
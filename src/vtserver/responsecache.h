@@ -0,0 +1,144 @@
+#pragma once
+
+#include <google/protobuf/message.h>
+#include <string>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace vtserver {
+
+
+class ResponseCache
+{
+public:
+    /**
+     * @brief Cache counters
+     */
+    class Counters
+    {
+    public:
+        uint64_t hits;              // requests answered from cache
+        uint64_t misses;            // cacheable requests processed by worker
+        uint64_t entries;           // cached responses
+        uint64_t bytes;             // memory used by cached responses (keys and data)
+        uint64_t max_bytes;         // memory limit
+        uint64_t evictions;         // entries removed to free memory (or expired)
+        uint64_t invalidations;     // entries removed by writes
+
+        Counters()
+            : hits(0), misses(0), entries(0), bytes(0), max_bytes(0),
+              evictions(0), invalidations(0) {}
+    };
+
+    /**
+     * @param max_bytes memory limit of cached responses, 0 = cache is disabled
+     * @param ttl_ms cached response expires after this time
+     * (writes made outside of this server are not seen by it)
+     */
+    ResponseCache(size_t max_bytes, unsigned int ttl_ms);
+
+    /**
+     * @brief Gets cached response
+     * @param request request, serialized request is the key
+     * @param response output response
+     * @return true on hit
+     */
+    bool get(const google::protobuf::Message &request, google::protobuf::Message &response);
+
+    /**
+     * @brief Gets current generation, must be read before loading response
+     * to be stored with put (response loaded before invalidation is discarded)
+     * @return generation
+     */
+    uint64_t generation() const;
+
+    /**
+     * @brief Stores response
+     * @param request request, serialized request is the key
+     * @param dsname dataset which response depends on (empty = none)
+     * @param response response to store
+     * @param generation generation read before response was loaded
+     */
+    void put(const google::protobuf::Message &request, const std::string &dsname,
+             const google::protobuf::Message &response, uint64_t generation);
+
+    /**
+     * @brief Removes responses of dataset (after dataset modification)
+     * @param dsname dataset name
+     */
+    void invalidate(const std::string &dsname);
+
+    /**
+     * @brief Removes all responses (after datasets were added or deleted)
+     */
+    void invalidateAll();
+
+    /**
+     * @brief Marks dataset as being written to by processing task,
+     * its responses are not cached until writes end
+     * @param dsname dataset name
+     */
+    void beginWrites(const std::string &dsname);
+
+    /**
+     * @brief Ends writes to dataset started by beginWrites and invalidates it
+     * @param dsname dataset name
+     */
+    void endWrites(const std::string &dsname);
+
+    /**
+     * @brief Gets version of dataset, which changes with every invalidation
+     * of dataset (or all datasets), for data derived from dataset and kept
+     * outside of cache, must be read before loading such data
+     * @param dsname dataset name
+     * @return version
+     */
+    uint64_t datasetVersion(const std::string &dsname) const;
+
+    /**
+     * @brief Checks if dataset is being written to by processing task
+     * (data derived from it should not be kept)
+     * @param dsname dataset name
+     * @return true while writes run
+     */
+    bool isWritten(const std::string &dsname) const;
+
+    Counters counters() const;
+
+private:
+    class Entry
+    {
+    public:
+        std::string _dsname;
+        std::string _data;
+        std::chrono::steady_clock::time_point _stored;
+        std::list<std::string>::iterator _lru;
+    };
+
+    const size_t _max_bytes;
+    const std::chrono::milliseconds _ttl;
+    mutable std::mutex _mtx;
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru;                // most recently used first
+    std::map<std::string, unsigned int> _writers;   // dataset => running writers
+    uint64_t _generation;
+    uint64_t _all_version;                      // invalidations of all datasets
+    std::map<std::string, uint64_t> _ds_versions;   // dataset => its invalidations
+    Counters _counters;
+
+    static std::string makeKey(const google::protobuf::Message &request);
+    static size_t entrySize(const std::string &key, const Entry &entry);
+    void erase(std::unordered_map<std::string, Entry>::iterator it);
+    void removeDataset(const std::string &dsname);
+
+    ResponseCache() = delete;
+    ResponseCache(const ResponseCache &) = delete;
+    ResponseCache & operator=(const ResponseCache &) = delete;
+};
+
+
+}
@@ -0,0 +1,86 @@
+// VTServer application - parallel processing of sequences
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// Heavy requests over many sequences are split to contiguous parts of sequences.
+// Parts are processed in parallel, each by one thread with own connection,
+// and their results are merged in order of parts. Every sequence is processed
+// as a whole by one job, so results don't depend on number of threads.
+
+#include "seqpartition.h"
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#define PARTS_PER_THREAD    4   // parts for one thread (load balancing)
+
+using namespace std;
+
+namespace vtserver {
+
+
+SequencePartitioner::SequencePartitioner(ConnectionPool &pool, unsigned int max_threads)
+    : _pool(pool), _max_threads(max_threads > 0 ? max_threads : 1)
+{
+}
+
+vector< vector<string> > SequencePartitioner::split(const vector<string> &seqnames) const
+{
+    size_t count = 1;
+    if (_max_threads > 1)
+        count = std::min(seqnames.size(), static_cast<size_t>(_max_threads) * PARTS_PER_THREAD);
+    if (count == 0)
+        count = 1;
+
+    vector< vector<string> > parts(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t first = seqnames.size() * i / count;
+        size_t last = seqnames.size() * (i + 1) / count;
+        parts[i].assign(seqnames.begin() + first, seqnames.begin() + last);
+    }
+
+    return parts;
+}
+
+bool SequencePartitioner::run(vtapi::VTApi &vtapi, size_t parts, Job job)
+{
+    if (parts == 0)
+        return true;
+
+    atomic_size_t next(0);
+    atomic_bool failed(false);
+
+    auto work = [&](vtapi::VTApi &api) {
+        try {
+            for (size_t part = next++; part < parts && !failed; part = next++) {
+                if (!job(api, part))
+                    failed = true;
+            }
+        }
+        catch (...) {
+            failed = true;
+        }
+    };
+
+    // helpers with free connections only, waiting for them would block other requests
+    vector<thread> helpers;
+    size_t max_helpers = std::min(static_cast<size_t>(_max_threads), parts) - 1;
+    for (size_t i = 0; i < max_helpers; i++) {
+        ConnectionPool::Handle conn = _pool.tryCheckout();
+        if (!conn)
+            break;
+
+        helpers.push_back(thread([&work](ConnectionPool::Handle conn) {
+            work(*conn);
+        }, std::move(conn)));
+    }
+
+    work(vtapi);
+
+    for (auto & helper : helpers)
+        helper.join();
+
+    return !failed;
+}
+
+
+}
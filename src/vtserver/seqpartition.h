@@ -0,0 +1,71 @@
+#pragma once
+
+#include "connpool.h"
+#include <vtapi/vtapi.h>
+#include <google/protobuf/repeated_field.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace vtserver {
+
+
+class SequencePartitioner
+{
+public:
+    /**
+     * @brief Job processing one part of sequences
+     * @param vtapi VTApi object (connection) to use
+     * @param part part index
+     * @return success
+     */
+    typedef std::function<bool(vtapi::VTApi &vtapi, size_t part)> Job;
+
+    /**
+     * @param pool pool to take extra connections from (without waiting for them)
+     * @param max_threads max. threads processing parts, including caller's
+     */
+    SequencePartitioner(ConnectionPool &pool, unsigned int max_threads);
+
+    /**
+     * @brief Splits sequences to contiguous parts (more parts than threads,
+     * so that threads are balanced for sequences of different lengths)
+     * @param seqnames ordered sequence names
+     * @return parts in the same order
+     */
+    std::vector< std::vector<std::string> > split(const std::vector<std::string> &seqnames) const;
+
+    /**
+     * @brief Processes all parts, each exactly once, in caller's thread and
+     * helper threads with own pooled connections (as many as are free)
+     * @param vtapi caller's VTApi object
+     * @param parts number of parts
+     * @param job job to process part
+     * @return false if any job failed
+     */
+    bool run(vtapi::VTApi &vtapi, size_t parts, Job job);
+
+    /**
+     * @brief Moves elements of repeated field to the end of another (without copying)
+     * @param dst destination field
+     * @param src source field, is empty afterwards
+     */
+    template<class T>
+    static void append(google::protobuf::RepeatedPtrField<T> *dst,
+                       google::protobuf::RepeatedPtrField<T> *src)
+    {
+        std::vector<T*> elements(src->size());
+        src->ExtractSubrange(0, src->size(), elements.data());
+        for (T *element : elements)
+            dst->AddAllocated(element);
+    }
+
+private:
+    ConnectionPool &_pool;
+    const unsigned int _max_threads;
+
+    SequencePartitioner() = delete;
+};
+
+
+}
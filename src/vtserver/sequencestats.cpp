@@ -2,9 +2,13 @@
 // by ifroml[at]fit.vutbr.cz
 //
 // Calculate how much video is covered by evenets (trajectories etc.)
+//
+// Bitmap is stored in 64-bit words, so ranges of frames are set by masks
+// and coverage is counted by popcount (compiler emits popcnt / vpopcnt
+// instructions when target supports them).
 
 #include "sequencestats.h"
-#include <cstring>
+#include <algorithm>
 
 namespace vtserver {
 
@@ -12,8 +16,8 @@ namespace vtserver {
 SequenceStats::SequenceStats(unsigned int video_length)
     : _sequence_length(video_length), _count_root(0), _count_all(0)
 {
-    size_t bitmap_size = (video_length + 7) >> 3;
-    _bitmap.resize(bitmap_size, '\0');
+    size_t bitmap_size = (video_length + 63) >> 6;
+    _bitmap.resize(bitmap_size, 0);
 }
 
 void SequenceStats::processEvent(unsigned int t1_frame, unsigned int t2_frame, const vtapi::IntervalEvent &event)
@@ -22,53 +26,86 @@ void SequenceStats::processEvent(unsigned int t1_frame, unsigned int t2_frame, c
     _count_all++;
     if (event.is_root) _count_root++;
 
+    if (_sequence_length == 0) return;
+
     // get correct values (0..vidlength-1)
     int t1 = t1_frame - 1;  // start time
     int t2 = t2_frame - 1;    // end time
     if (t1 < 0) t1 = 0;
-    if (t2 > _sequence_length - 1) t2 = _sequence_length - 1;
+    if (t2 > static_cast<int>(_sequence_length) - 1) t2 = _sequence_length - 1;
     if (t2 < t1) t2 = t1;
 
+    // event starting after the end of video
+    if (t1 > static_cast<int>(_sequence_length) - 1) return;
+
+    setRange(t1, t2);
+}
+
+void SequenceStats::setRange(unsigned int first, unsigned int last)
+{
     // helpful index values to bitmap
-    int x1 = t1 >> 3;                   // first byte in map
-    int x2 = t2 >> 3;                   // last byte in map
-    int y1 = 7 & t1;                    // start bit in first byte
-    int y2 = 7 & t2;                    // end bit in last byte
-    int bits = t2 - t1 + 1;             // total bits to set
-
-    // fill first byte
-    if (y1 > 0 && bits) {
-        for (int y = 7-y1; (y >= 0) && bits; y--, bits--)
-            _bitmap[x1] |= (1 << y);
-        x1++;
-    }
+    unsigned int x1 = first >> 6;                   // first word in map
+    unsigned int x2 = last >> 6;                    // last word in map
+    uint64_t mask1 = ~0ULL >> (first & 63);         // bits from start bit to the end of word
+    uint64_t mask2 = ~0ULL << (63 - (last & 63));   // bits from start of word to end bit
 
-    // fill last byte
-    if (bits) {
-        for (int y = 7; (y >= 7-y2) && bits; y--, bits--)
-            _bitmap[x2] |= (1 << y);
-        x2--;
+    if (x1 == x2) {
+        _bitmap[x1] |= mask1 & mask2;
     }
+    else {
+        _bitmap[x1] |= mask1;
+        std::fill(_bitmap.begin() + x1 + 1, _bitmap.begin() + x2, ~0ULL);
+        _bitmap[x2] |= mask2;
+    }
+}
+
+unsigned int SequenceStats::count_covered() const
+{
+    unsigned int total = 0;
+
+    // bits after the end of video are never set
+    for (uint64_t word : _bitmap)
+        total += __builtin_popcountll(word);
 
-    // fill stuff in between
-    if (bits > 0) memset(&_bitmap[x1], 0xFF, x2-x1+1);
+    return total;
 }
 
-double SequenceStats::calculateCoverage()
+double SequenceStats::calculateCoverage() const
 {
     if (_sequence_length == 0) return 0.0;
 
-    // analyze bitmap for coverage
-    int x = 0, y = 7, total = 0;;
-    for (int i = 0; i < _sequence_length; i++) {
-        if ((_bitmap[x]) & (1 << y)) total++;
-        if (--y < 0) {
-            x++;
-            y = 7;
-        }
-    }
+    return static_cast<double>(count_covered())/_sequence_length;
+}
+
+void SequenceStats::unite(const SequenceStats &other)
+{
+    size_t size = std::min(_bitmap.size(), other._bitmap.size());
+    for (size_t i = 0; i < size; i++)
+        _bitmap[i] |= other._bitmap[i];
+
+    // other sequence may be longer, bits after the end of video stay clear
+    if (!_bitmap.empty() && (_sequence_length & 63))
+        _bitmap.back() &= ~0ULL << (64 - (_sequence_length & 63));
+}
+
+void SequenceStats::intersect(const SequenceStats &other)
+{
+    size_t size = std::min(_bitmap.size(), other._bitmap.size());
+    for (size_t i = 0; i < size; i++)
+        _bitmap[i] &= other._bitmap[i];
+
+    std::fill(_bitmap.begin() + size, _bitmap.end(), 0);
+}
+
+std::string SequenceStats::bitmap() const
+{
+    std::string bytes((_sequence_length + 7) >> 3, '\0');
+
+    // words are big-endian, so that the first frame is MSB of the first byte
+    for (size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = static_cast<char>(_bitmap[i >> 3] >> (56 - ((i & 7) << 3)));
 
-    return static_cast<double>(total)/_sequence_length;
+    return bytes;
 }
 
 
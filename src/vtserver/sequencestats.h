@@ -2,6 +2,8 @@
 
 #include <vtapi/data/interval.h>
 #include <vector>
+#include <string>
+#include <cstdint>
 
 namespace vtserver {
 
@@ -12,22 +14,43 @@ public:
     SequenceStats(unsigned int video_length);
 
     void processEvent(unsigned int t1_frame, unsigned int t2_frame, const vtapi::IntervalEvent &event);
-    
-    double calculateCoverage();
 
-    const std::vector<char> & bitmap()
-    { return _bitmap; }
-    unsigned int count_root()
+    double calculateCoverage() const;
+
+    /**
+     * @brief Covers frames covered by other stats too (union of coverage),
+     * used by getEventsStats to combine coverage of several tasks
+     * @param other stats of the same sequence (e.g. of other task)
+     */
+    void unite(const SequenceStats &other);
+
+    /**
+     * @brief Keeps only frames covered by other stats too (intersection of coverage),
+     * used by getEventsStats to combine coverage of several tasks
+     * @param other stats of the same sequence (e.g. of other task)
+     */
+    void intersect(const SequenceStats &other);
+
+    /**
+     * @brief Gets coverage bitmap, one bit per frame, the first frame is MSB of the first byte
+     * @return bitmap bytes
+     */
+    std::string bitmap() const;
+
+    unsigned int count_covered() const;
+    unsigned int count_root() const
     { return _count_root; }
-    unsigned int count_all()
+    unsigned int count_all() const
     { return _count_all; }
 
 private:
     unsigned int _sequence_length;
-    std::vector<char> _bitmap;
+    std::vector<uint64_t> _bitmap;      // frame i is bit (63 - i % 64) of word i / 64
     unsigned int _count_root;
     unsigned int _count_all;
 
+    void setRange(unsigned int first, unsigned int last);
+
 private:
     SequenceStats() = delete;
 };
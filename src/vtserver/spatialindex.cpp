@@ -0,0 +1,329 @@
+// VTServer application - spatio-temporal index of trajectories
+// by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
+//
+// In-memory 3D R-tree (x, y, frame) of event regions of task output in one
+// sequence. Tree is packed at once by Sort-Tile-Recursive from all loaded
+// events, so its nodes are full and don't overlap much. Events are also kept
+// as struct of arrays, so that event filter can be evaluated without database.
+// Indexes are kept
+// in LRU store and are checked against versions of events in database
+// (statistics rows of task output), or follow dataset invalidations of
+// response cache if there are no versions.
+
+#include "spatialindex.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cmath>
+
+#define NODE_CAPACITY   16      // children of R-tree node
+
+using namespace std;
+
+namespace vtserver {
+
+
+// orders items (regions or nodes) so that each NODE_CAPACITY consecutive items
+// are close: sorted by x to slabs, slabs by y to runs, runs by frame
+template<class T>
+static void sortTiles(vector<T> &items, size_t first, size_t last, int dim)
+{
+    std::sort(items.begin() + first, items.begin() + last, [dim](const T &a, const T &b) {
+        return a.low[dim] + a.high[dim] < b.low[dim] + b.high[dim];
+    });
+    if (dim == 2)
+        return;
+
+    size_t nodes = (last - first + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    size_t slabs = static_cast<size_t>(std::ceil(std::pow(static_cast<double>(nodes), 1.0 / (3 - dim))));
+    size_t slab_size = NODE_CAPACITY * ((nodes + slabs - 1) / std::max<size_t>(slabs, 1));
+    for (size_t slab = first; slab < last; slab += slab_size)
+        sortTiles(items, slab, std::min(slab + slab_size, last), dim + 1);
+}
+
+template<class T>
+static bool intersects(const T &item, const double low[3], const double high[3])
+{
+    return item.low[0] <= high[0] && item.high[0] >= low[0] &&
+           item.low[1] <= high[1] && item.high[1] >= low[1] &&
+           item.low[2] <= high[2] && item.high[2] >= low[2];
+}
+
+
+void TrajectoryIndex::Builder::addEvent(int event_id, unsigned int t1, unsigned int t2, double length,
+                                        const chrono::system_clock::time_point &rt_start,
+                                        const vtapi::IntervalEvent &event)
+{
+    _events.add(t1, t2, length, rt_start, event);
+
+    Region region;
+    region.low[0] = std::min(event.region.low.x, event.region.high.x);
+    region.low[1] = std::min(event.region.low.y, event.region.high.y);
+    region.low[2] = t1;
+    region.high[0] = std::max(event.region.low.x, event.region.high.x);
+    region.high[1] = std::max(event.region.low.y, event.region.high.y);
+    region.high[2] = t2;
+    region.group_id = event.group_id;
+
+    if (event.is_root) {
+        Trajectory traj = { event.group_id, event_id, event.class_id, event.score, t1, t2, length };
+        _trajectories.push_back(traj);
+        _root_regions.push_back(region);
+    }
+    else {
+        _regions.push_back(region);
+    }
+}
+
+shared_ptr<const TrajectoryIndex> TrajectoryIndex::Builder::build()
+{
+    auto by_group = [](const Trajectory &a, const Trajectory &b) { return a.group_id < b.group_id; };
+    std::stable_sort(_trajectories.begin(), _trajectories.end(), by_group);
+    _trajectories.erase(std::unique(_trajectories.begin(), _trajectories.end(),
+        [](const Trajectory &a, const Trajectory &b) { return a.group_id == b.group_id; }),
+        _trajectories.end());
+
+    // trajectory without other events is represented by its root
+    vector<int> with_regions(_regions.size());
+    for (size_t i = 0; i < _regions.size(); i++)
+        with_regions[i] = _regions[i].group_id;
+    std::sort(with_regions.begin(), with_regions.end());
+    with_regions.erase(std::unique(with_regions.begin(), with_regions.end()), with_regions.end());
+
+    for (const auto & region : _root_regions) {
+        if (!std::binary_search(with_regions.begin(), with_regions.end(), region.group_id))
+            _regions.push_back(region);
+    }
+    _root_regions.clear();
+
+    return make_shared<const TrajectoryIndex>(std::move(_regions), std::move(_trajectories),
+                                              std::move(_events));
+}
+
+
+TrajectoryIndex::TrajectoryIndex(vector<Region> &&regions, vector<Trajectory> &&trajectories,
+                                 vtapi::EventBatch &&events)
+    : _regions(std::move(regions)), _trajectories(std::move(trajectories)), _events(std::move(events))
+{
+    if (_regions.empty())
+        return;
+
+    // levels are packed from leaves, each level is reordered before its parents are made
+    vector<Node> nodes = packLevel(_regions);
+    while (nodes.size() > 1) {
+        vector<Node> parents = packLevel(nodes);
+        _levels.push_back(std::move(nodes));
+        nodes = std::move(parents);
+    }
+    _levels.push_back(std::move(nodes));
+}
+
+vector<const TrajectoryIndex::Trajectory*> TrajectoryIndex::query(const double low[3], const double high[3],
+                                                                  const vtapi::EventBatchFilter *filter) const
+{
+    vector<const Trajectory*> result;
+    if (_levels.empty())
+        return result;
+
+    vector<int> groups;
+    vector< pair<size_t,uint32_t> > stack;     // (level, node)
+    stack.push_back(make_pair(_levels.size() - 1, 0));
+
+    while (!stack.empty()) {
+        size_t level = stack.back().first;
+        const Node &node = _levels[level][stack.back().second];
+        stack.pop_back();
+
+        if (!intersects(node, low, high))
+            continue;
+
+        if (level == 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (intersects(_regions[i], low, high))
+                    groups.push_back(_regions[i].group_id);
+            }
+        }
+        else {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+                stack.push_back(make_pair(level - 1, i));
+        }
+    }
+
+    std::sort(groups.begin(), groups.end());
+    groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+
+    // groups satisfying filter (as by VT_filtered_events)
+    if (filter && !filter->empty() && !groups.empty()) {
+        vector<int> matching = filter->matchingGroups(_events);
+        vector<int> both;
+        std::set_intersection(groups.begin(), groups.end(),
+                              matching.begin(), matching.end(),
+                              std::back_inserter(both));
+        groups.swap(both);
+    }
+
+    // regions without root event are not reported (as in getEventList)
+    auto it = _trajectories.begin();
+    for (int group_id : groups) {
+        it = std::lower_bound(it, _trajectories.end(), group_id,
+                              [](const Trajectory &traj, int id) { return traj.group_id < id; });
+        if (it == _trajectories.end())
+            break;
+        if (it->group_id == group_id)
+            result.push_back(&*it);
+    }
+
+    return result;
+}
+
+size_t TrajectoryIndex::bytes() const
+{
+    size_t size = sizeof(*this) +
+                  _regions.capacity() * sizeof(Region) +
+                  _trajectories.capacity() * sizeof(Trajectory) +
+                  _events.bytes();
+    for (const auto & level : _levels)
+        size += level.capacity() * sizeof(Node);
+
+    return size;
+}
+
+template<class T>
+vector<TrajectoryIndex::Node> TrajectoryIndex::packLevel(vector<T> &items)
+{
+    sortTiles(items, 0, items.size(), 0);
+
+    vector<Node> nodes;
+    nodes.reserve((items.size() + NODE_CAPACITY - 1) / NODE_CAPACITY);
+
+    for (size_t first = 0; first < items.size(); first += NODE_CAPACITY) {
+        Node node;
+        node.first = static_cast<uint32_t>(first);
+        node.count = static_cast<uint32_t>(std::min<size_t>(NODE_CAPACITY, items.size() - first));
+        for (int dim = 0; dim < 3; dim++) {
+            node.low[dim] = numeric_limits<double>::max();
+            node.high[dim] = numeric_limits<double>::lowest();
+        }
+
+        for (size_t i = first; i < first + node.count; i++) {
+            for (int dim = 0; dim < 3; dim++) {
+                node.low[dim] = std::min(node.low[dim], items[i].low[dim]);
+                node.high[dim] = std::max(node.high[dim], items[i].high[dim]);
+            }
+        }
+        nodes.push_back(node);
+    }
+
+    return nodes;
+}
+
+
+SpatialIndexStore::SpatialIndexStore(ResponseCache &cache, size_t max_bytes, unsigned int ttl_ms)
+    : _cache(cache), _max_bytes(max_bytes), _ttl(ttl_ms), _bytes(0)
+{
+}
+
+shared_ptr<const TrajectoryIndex> SpatialIndexStore::get(const string &dsname, const string &taskname,
+                                                         const vtapi::QueryEventsVersions::Version &events,
+                                                         bool &too_large)
+{
+    too_large = false;
+    if (_max_bytes == 0) return NULL;
+
+    // single index may take only part of memory
+    if (events.count_all >= 0 &&
+        TrajectoryIndex::minBytes(static_cast<size_t>(events.count_all)) > _max_bytes / 2) {
+        too_large = true;
+        return NULL;
+    }
+
+    uint64_t version = _cache.datasetVersion(dsname);
+    bool written = _cache.isWritten(dsname);
+
+    lock_guard<mutex> lock(_mtx);
+
+    auto it = _entries.find(makeKey(dsname, taskname, events.seqname));
+    if (it == _entries.end())
+        return NULL;
+
+    // task output may have changed, also outside of this server
+    bool outdated = events.modified >= 0 ?
+        it->second._modified != events.modified :
+        written || it->second._version != version ||
+        chrono::steady_clock::now() - it->second._stored > _ttl;
+    if (outdated) {
+        erase(it);
+        return NULL;
+    }
+
+    _lru.splice(_lru.begin(), _lru, it->second._lru);
+    too_large = !it->second._index;
+    return it->second._index;
+}
+
+bool SpatialIndexStore::put(const string &dsname, const string &taskname,
+                            const vtapi::QueryEventsVersions::Version &events,
+                            shared_ptr<const TrajectoryIndex> index, uint64_t version)
+{
+    if (_max_bytes == 0 || !index) return true;
+
+    // events changed meanwhile or dataset is being written to
+    // (invalidation after this check is caught by version check in get)
+    if (events.modified < 0 &&
+        (_cache.isWritten(dsname) || _cache.datasetVersion(dsname) != version))
+        return true;
+
+    // single index may take only part of memory, too large one is
+    // remembered so that it isn't built again until events change
+    size_t size = index->bytes();
+    bool fits = size <= _max_bytes / 2;
+    if (!fits) {
+        index.reset();
+        size = 0;
+    }
+
+    string key = makeKey(dsname, taskname, events.seqname);
+
+    lock_guard<mutex> lock(_mtx);
+
+    auto it = _entries.find(key);
+    if (it != _entries.end())
+        erase(it);
+
+    while (!_lru.empty() && _bytes + size > _max_bytes)
+        erase(_entries.find(_lru.back()));
+
+    Entry entry;
+    entry._index = std::move(index);
+    entry._version = version;
+    entry._modified = events.modified;
+    entry._bytes = size;
+    entry._stored = chrono::steady_clock::now();
+    _lru.push_front(key);
+    entry._lru = _lru.begin();
+    _entries.emplace(std::move(key), std::move(entry));
+    _bytes += size;
+
+    return fits;
+}
+
+string SpatialIndexStore::makeKey(const string &dsname, const string &taskname, const string &seqname)
+{
+    string key = dsname;
+    key += '\0';
+    key += taskname;
+    key += '\0';
+    key += seqname;
+
+    return key;
+}
+
+void SpatialIndexStore::erase(unordered_map<string, Entry>::iterator it)
+{
+    _bytes -= it->second._bytes;
+    _lru.erase(it->second._lru);
+    _entries.erase(it);
+}
+
+
+}
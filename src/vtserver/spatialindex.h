@@ -0,0 +1,220 @@
+#pragma once
+
+#include "responsecache.h"
+#include <vtapi/data/intervalevent.h>
+#include <vtapi/data/eventbatch.h>
+#include <vtapi/queries/predefined.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace vtserver {
+
+
+class TrajectoryIndex
+{
+public:
+    /**
+     * @brief Trajectory (root event)
+     */
+    class Trajectory
+    {
+    public:
+        int group_id;
+        int event_id;
+        int class_id;
+        double score;
+        unsigned int t1;        // first frame
+        unsigned int t2;        // last frame
+        double length;          // seconds
+    };
+
+    /**
+     * @brief Event region in space and time (x, y, frame)
+     */
+    class Region
+    {
+    public:
+        double low[3];
+        double high[3];
+        int group_id;
+    };
+
+    /**
+     * @brief Collects events of sequence and builds index of them
+     */
+    class Builder
+    {
+    public:
+        /**
+         * @brief Adds event, regions of trajectory are its non-root events
+         * (or root event itself, if trajectory has no other events)
+         * @param event_id event ID
+         * @param t1 first frame
+         * @param t2 last frame
+         * @param length length in seconds
+         * @param rt_start real start time (zero = unknown)
+         * @param event event
+         */
+        void addEvent(int event_id, unsigned int t1, unsigned int t2, double length,
+                      const std::chrono::system_clock::time_point &rt_start,
+                      const vtapi::IntervalEvent &event);
+
+        std::shared_ptr<const TrajectoryIndex> build();
+
+    private:
+        std::vector<Region> _regions;
+        std::vector<Region> _root_regions;
+        std::vector<Trajectory> _trajectories;
+        vtapi::EventBatch _events;
+    };
+
+    /**
+     * @brief Builds 3D R-tree packed by Sort-Tile-Recursive, O(n log n)
+     * @param regions regions of events
+     * @param trajectories trajectories of regions
+     * @param events all events, for filtering without database
+     */
+    TrajectoryIndex(std::vector<Region> &&regions, std::vector<Trajectory> &&trajectories,
+                    vtapi::EventBatch &&events);
+
+    /**
+     * @brief Finds trajectories with any region intersecting window,
+     * O(log n) nodes are visited for small windows
+     * @param low window low corner (x, y, first frame)
+     * @param high window high corner (x, y, last frame)
+     * @param filter event filter evaluated over all indexed events
+     * (same as in database), NULL for none
+     * @return trajectories ordered by group ID
+     */
+    std::vector<const Trajectory*> query(const double low[3], const double high[3],
+                                         const vtapi::EventBatchFilter *filter = NULL) const;
+
+    /**
+     * @brief Gets approximate memory used by index
+     * @return bytes
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief Gets least memory used by index of events (each event is region
+     * or trajectory, and is kept in event batch), so that too large index
+     * can be refused before it's built
+     * @param events number of events
+     * @return bytes
+     */
+    static size_t minBytes(size_t events)
+    {
+        return events * (std::min(sizeof(Region), sizeof(Trajectory)) +
+                         sizeof(int) + sizeof(unsigned char) + 2 * sizeof(unsigned int) + 6 * sizeof(double));
+    }
+
+private:
+    class Node
+    {
+    public:
+        double low[3];
+        double high[3];
+        uint32_t first;     // first child in lower level (or region)
+        uint32_t count;
+    };
+
+    std::vector<Region> _regions;               // leaf entries in packed order
+    std::vector< std::vector<Node> > _levels;   // [0] = nodes over regions, last = root
+    std::vector<Trajectory> _trajectories;      // ordered by group ID
+    vtapi::EventBatch _events;                  // all events in loaded order
+
+    template<class T>
+    static std::vector<Node> packLevel(std::vector<T> &items);
+
+    TrajectoryIndex() = delete;
+    TrajectoryIndex(const TrajectoryIndex &) = delete;
+    TrajectoryIndex & operator=(const TrajectoryIndex &) = delete;
+};
+
+
+class SpatialIndexStore
+{
+public:
+    /**
+     * @param cache response cache, its dataset invalidations invalidate indexes
+     * of task outputs without version in database
+     * @param max_bytes memory limit of kept indexes, 0 = indexes are not kept
+     * @param ttl_ms index of task output without version in database expires
+     * after this time (writes made outside of this server are not seen by it)
+     */
+    SpatialIndexStore(ResponseCache &cache, size_t max_bytes, unsigned int ttl_ms);
+
+    /**
+     * @brief Gets kept index of sequence task output
+     * @param dsname dataset name
+     * @param taskname task name
+     * @param events version of sequence events in database
+     * @param too_large set to true if index would be too large to be kept,
+     * it shouldn't be built then
+     * @return index or NULL if it isn't kept or is outdated
+     */
+    std::shared_ptr<const TrajectoryIndex> get(const std::string &dsname, const std::string &taskname,
+                                               const vtapi::QueryEventsVersions::Version &events,
+                                               bool &too_large);
+
+    /**
+     * @brief Gets current version of dataset, must be read before loading
+     * events for index to be stored with put
+     * @param dsname dataset name
+     * @return version
+     */
+    uint64_t version(const std::string &dsname) const
+    { return _cache.datasetVersion(dsname); }
+
+    /**
+     * @brief Keeps index, least recently used indexes are dropped to free memory
+     * @param dsname dataset name
+     * @param taskname task name
+     * @param events version of sequence events read before they were loaded
+     * @param index built index
+     * @param version dataset version read before events were loaded
+     * @return false if index is too large to be kept (get reports it then,
+     * until events change)
+     */
+    bool put(const std::string &dsname, const std::string &taskname,
+             const vtapi::QueryEventsVersions::Version &events,
+             std::shared_ptr<const TrajectoryIndex> index, uint64_t version);
+
+private:
+    class Entry
+    {
+    public:
+        std::shared_ptr<const TrajectoryIndex> _index;    // NULL = too large
+        uint64_t _version;
+        long long _modified;            // version of events, -1 = unknown
+        size_t _bytes;
+        std::chrono::steady_clock::time_point _stored;
+        std::list<std::string>::iterator _lru;
+    };
+
+    ResponseCache &_cache;
+    const size_t _max_bytes;
+    const std::chrono::milliseconds _ttl;
+    std::mutex _mtx;
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru;        // most recently used first
+    size_t _bytes;
+
+    static std::string makeKey(const std::string &dsname, const std::string &taskname,
+                               const std::string &seqname);
+    void erase(std::unordered_map<std::string, Entry>::iterator it);
+
+    SpatialIndexStore() = delete;
+    SpatialIndexStore(const SpatialIndexStore &) = delete;
+    SpatialIndexStore & operator=(const SpatialIndexStore &) = delete;
+};
+
+
+}
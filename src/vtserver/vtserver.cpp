@@ -2,12 +2,20 @@
 // by ifroml[at]fit.vutbr.cz, ivolf[at]fit.vutbr.cz
 //
 // Service acts as main interface for computer vision applications based on VTApi,
-// listening on port 8719.
+// listening on port 8719 (server_* options in VTApi config change defaults below).
 // Interface is defined in vtserver_interface.proto (Protocol Buffers format).
 //
 // worker.cpp       main interface implementation
+// executor.cpp     worker threads with priority lanes (metadata / heavy requests)
+// connpool.cpp     pool of database connections shared by worker threads
+// eventcursor.cpp  event list cursors kept between chunked getEventList requests
+// responsecache.cpp   LRU cache of responses to read-only requests
+// seqpartition.cpp    parallel processing of sequences of heavy requests
+// spatialindex.cpp    in-memory spatio-temporal R-trees of trajectories
+// descriptorindex.cpp  in-memory vector indexes of event descriptors (similarity search)
 // interproc.cpp    interprocess communication to manage active processing tasks
 // sequencestats.cpp   calculation of statistics for sequence from processing results
+// intervalsweep.cpp   coverage, overlaps, concurrency and gaps of events by interval sweep
 // vtserver_interface*  generated interface files
 //
 // Dataset interface
@@ -24,15 +32,34 @@
 //
 // Events interface
 // - query results of finished tasks
-// - methods: get list, get stats
+// - methods: get list, get stats, get trajectories in window (region and frames),
+//   get similar events (nearest descriptors)
+//
+// Server interface
+// - methods: get stats (response cache counters)
 
 
 #include "vtserver.h"
 #include <iostream>
+#include <thread>
 #include <rpcz/rpcz.hpp>
 
+#define SERVER_PORT             8719    // TCP port
 #define WORKER_THREAD_COUNT     10      // concurrent worker threads
 #define ZEROMQ_IO_THREAD_COUNT  1       // IO threads
+#define RPC_THREAD_COUNT        2       // rpcz threads (only queue requests for workers)
+#define CONNECTION_TIMEOUT_MS   30000   // max. wait for free connection
+#define REQUEST_QUEUE_SIZE      1000    // max. requests waiting for worker
+#define EVENT_CURSOR_COUNT      32      // max. open getEventList cursors
+#define EVENT_CURSOR_TIMEOUT_MS 300000  // idle cursor is closed after this time
+#define RESPONSE_CACHE_MB       64      // memory for cached responses
+#define RESPONSE_CACHE_TTL_MS   600000  // cached response expires after this time
+#define SPATIAL_INDEX_MB        256     // memory for spatial indexes of trajectories
+#define DESCRIPTOR_INDEX_MB     256     // memory for vector indexes of event descriptors
+
+#define ERROR_NO_CONNECTION     1       // RPC application error codes
+#define ERROR_QUEUE_FULL        2
+#define ERROR_INTERNAL          3
 
 
 namespace vti = vtserver_interface;
@@ -43,19 +70,36 @@ int main(int argc, char *argv[])
     try {
         // main vtapi object with connection
         vtapi::VTApi vtapi(argc, argv);
-        // initialize interface, copy vtapi object to all worker threads
-        vtserver::VTServer vtserver(vtapi);
+
+        const vtapi::ServerConfig & config = vtapi.getServerConfig();
+        int port = config.port > 0 ? config.port : SERVER_PORT;
+        int workers = config.workers > 0 ? config.workers : WORKER_THREAD_COUNT;
+        int io_threads = config.io_threads > 0 ? config.io_threads : ZEROMQ_IO_THREAD_COUNT;
+        int connections = config.connections > 0 ? config.connections : workers;
+        int queue_size = config.queue_size > 0 ? config.queue_size : REQUEST_QUEUE_SIZE;
+        int cache_mb = config.cache_size != 0 ? config.cache_size : RESPONSE_CACHE_MB;
+        size_t cache_bytes = cache_mb > 0 ? static_cast<size_t>(cache_mb) << 20 : 0;
+        int index_mb = config.index_size != 0 ? config.index_size : SPATIAL_INDEX_MB;
+        size_t index_bytes = index_mb > 0 ? static_cast<size_t>(index_mb) << 20 : 0;
+        int descindex_mb = config.descindex_size != 0 ? config.descindex_size : DESCRIPTOR_INDEX_MB;
+        size_t descindex_bytes = descindex_mb > 0 ? static_cast<size_t>(descindex_mb) << 20 : 0;
+        int sequence_threads = config.sequence_threads > 0 ? config.sequence_threads : std::thread::hardware_concurrency();
+
+        // initialize interface, copy vtapi object to all pooled connections
+        vtserver::VTServer vtserver(vtapi, connections, CONNECTION_TIMEOUT_MS,
+                                    workers, config.heavy_workers, queue_size,
+                                    cache_bytes, index_bytes, descindex_bytes, sequence_threads);
 
         rpcz::application::options opts;
-        opts.connection_manager_threads = WORKER_THREAD_COUNT;
-        opts.zeromq_io_threads = ZEROMQ_IO_THREAD_COUNT;
+        opts.connection_manager_threads = RPC_THREAD_COUNT;
+        opts.zeromq_io_threads = io_threads;
 
         rpcz::application app(opts);
         rpcz::server server(app);
         server.register_service(&vtserver);
-        server.bind("tcp://*:8719");
+        server.bind("tcp://*:" + std::to_string(port));
 
-        std::cout << "starting server on TCP port 8719..." << std::endl;
+        std::cout << "starting server on TCP port " << port << "..." << std::endl;
         app.run();
     }
     catch(std::exception& e) {
@@ -75,151 +119,237 @@ int main(int argc, char *argv[])
 namespace vtserver {
 
 
-VTServer::VTServer(const vtapi::VTApi &vtapi)
-    : _connections(WORKER_THREAD_COUNT)
+VTServer::VTServer(const vtapi::VTApi &vtapi, unsigned int pool_size, unsigned int pool_timeout_ms,
+                   unsigned int workers, unsigned int heavy_workers, unsigned int queue_size,
+                   size_t cache_bytes, size_t index_bytes, size_t descindex_bytes,
+                   unsigned int sequence_threads)
+    : _pool(vtapi, pool_size, pool_timeout_ms),
+      _cache(cache_bytes, RESPONSE_CACHE_TTL_MS),
+      _indexes(_cache, index_bytes, RESPONSE_CACHE_TTL_MS),
+      _descriptors(_cache, descindex_bytes, RESPONSE_CACHE_TTL_MS),
+      _interproc(_cache),
+      _cursors(EVENT_CURSOR_COUNT, EVENT_CURSOR_TIMEOUT_MS),
+      _sequence_threads(sequence_threads > 0 ? sequence_threads : 1),
+      _executor(workers, heavy_workers, queue_size)
 {
-    for (auto & conn : _connections)
-        conn = std::make_shared<vtapi::VTApi>(vtapi);
 }
 
 
 template<class REQUEST_T, class RESPONSE_T>
-bool VTServer::processRequest(REQUEST_T & request, RESPONSE_T & response)
+void VTServer::submitRequest(Executor::Lane lane, const REQUEST_T & request, RESPONSE_T & response)
 {
-    // find current thread index
+    // request is valid only during this call, job gets own copy
+    std::shared_ptr<const REQUEST_T> req = std::make_shared<const REQUEST_T>(request);
+    RESPONSE_T reply = response;
+
+    bool queued = _executor.submit(lane, [this, req, reply]() mutable {
+        processRequest(*req, reply);
+    });
+    if (!queued)
+        response.Error(ERROR_QUEUE_FULL, "Server is busy, request queue is full");
+}
 
-    int thread_index = -1;
-    std::thread::id thread_id = std::this_thread::get_id();
 
-    _mtx_threads.lock();
-    auto ti = _thread_indexes.find(thread_id);
-    if (ti != _thread_indexes.end()) {
-        thread_index = ti->second;
-    }
-    else {
-        thread_index = _thread_indexes.size();
-        _thread_indexes.emplace(std::make_pair(thread_id, thread_index));
-    }
-    _mtx_threads.unlock();
+template<class REQUEST_T, class RESPONSE_T>
+bool VTServer::processRequest(REQUEST_T & request, RESPONSE_T & response)
+{
+    // get connection from pool and process request
 
-    // get connection for our thread and process request
+    ConnectionPool::Handle conn = _pool.checkout();
+    if (!conn) {
+        response.Error(ERROR_NO_CONNECTION, "No database connection available");
+        return false;
+    }
 
-    if (thread_index >= 0 && thread_index < WORKER_THREAD_COUNT) {
+    // jobs handle vtapi errors, anything else fails the whole request
+    try {
         WorkerJob<REQUEST_T,RESPONSE_T> job(request, response);
-        WorkerJobBase::Args args(*_connections[thread_index], _interproc);
+        WorkerJobBase::Args args(*conn, _interproc, _cursors, _cache, _indexes, _descriptors,
+                                _pool, _sequence_threads);
         job.process(args);
     }
+    catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        response.Error(ERROR_INTERNAL, std::string("Request failed: ") + e.what());
+        return false;
+    }
+    catch (...) {
+        std::cerr << "Error: unknown exception" << std::endl;
+        response.Error(ERROR_INTERNAL, "Request failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+template<class REQUEST_T, class MESSAGE_T>
+bool VTServer::replyFromCache(const REQUEST_T & request, ::rpcz::reply<MESSAGE_T> & response)
+{
+    // cache hit is sent directly, without queueing and database connection
+    MESSAGE_T reply;
+    if (!_cache.get(request, reply))
+        return false;
+
+    response.send(reply);
+    return true;
 }
 
 
 void VTServer::addDataset(const vti::addDatasetRequest &request, ::rpcz::reply<vti::addDatasetResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getDatasetList(const vti::getDatasetListRequest &request, ::rpcz::reply<vti::getDatasetListResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getDatasetMetrics(const vti::getDatasetMetricsRequest &request, ::rpcz::reply<vti::getDatasetMetricsResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::deleteDataset(const vti::deleteDatasetRequest &request, ::rpcz::reply<vti::deleteDatasetResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::addSequence(const vti::addSequenceRequest &request, ::rpcz::reply<vti::addSequenceResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getSequenceIDList(const vti::getSequenceIDListRequest &request, ::rpcz::reply<vti::getSequenceIDListResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getSequenceInfo(const vti::getSequenceInfoRequest &request, ::rpcz::reply<vti::getSequenceInfoResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::setSequenceInfo(const vti::setSequenceInfoRequest &request, ::rpcz::reply<vti::setSequenceInfoResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::deleteSequence(const vti::deleteSequenceRequest &request, ::rpcz::reply<vti::deleteSequenceResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::addTask(const vtserver_interface::addTaskRequest &request, ::rpcz::reply<vtserver_interface::addTaskResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getTaskIDList(const vti::getTaskIDListRequest &request, ::rpcz::reply<vti::getTaskIDListResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getTaskInfo(const vti::getTaskInfoRequest &request, ::rpcz::reply<vti::getTaskInfoResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getTaskProgress(const vti::getTaskProgressRequest &request, ::rpcz::reply<vti::getTaskProgressResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::deleteTask(const vti::deleteTaskRequest &request, ::rpcz::reply<vti::deleteTaskResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getProcessIDList(const vti::getProcessIDListRequest &request, ::rpcz::reply<vti::getProcessIDListResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getProcessInfo(const vti::getProcessInfoRequest &request, ::rpcz::reply<vti::getProcessInfoResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::runProcess(const vti::runProcessRequest &request, ::rpcz::reply<vti::runProcessResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::stopProcess(const vti::stopProcessRequest &request, ::rpcz::reply<vti::stopProcessResponse> response)
 {
-    processRequest(request, response);
+    submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getEventDescriptor(const vti::getEventDescriptorRequest &request, ::rpcz::reply<vti::getEventDescriptorResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_METADATA, request, response);
 }
 
 void VTServer::getEventList(const vti::getEventListRequest &request, ::rpcz::reply<vti::getEventListResponse> response)
 {
-    processRequest(request, response);
+    // chunked responses (with continuation token) are not cached
+    bool chunked = request.chunk_size() > 0 || request.has_continuation_token();
+    if (chunked || !replyFromCache(request, response))
+        submitRequest(Executor::LANE_HEAVY, request, response);
 }
 
 void VTServer::getEventsStats(const vti::getEventsStatsRequest &request, ::rpcz::reply<vti::getEventsStatsResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_HEAVY, request, response);
+}
+
+void VTServer::getTrajectoriesInWindow(const vti::getTrajectoriesInWindowRequest &request, ::rpcz::reply<vti::getTrajectoriesInWindowResponse> response)
+{
+    // indexes are built in worker, if they are not kept yet
+    submitRequest(Executor::LANE_HEAVY, request, response);
+}
+
+void VTServer::getSimilarEvents(const vti::getSimilarEventsRequest &request, ::rpcz::reply<vti::getSimilarEventsResponse> response)
+{
+    // index is built (or updated by new events) in worker
+    submitRequest(Executor::LANE_HEAVY, request, response);
 }
 
 void VTServer::getProcessingMetadata(const vti::getProcessingMetadataRequest &request, ::rpcz::reply<vti::getProcessingMetadataResponse> response)
 {
-    processRequest(request, response);
+    if (!replyFromCache(request, response))
+        submitRequest(Executor::LANE_HEAVY, request, response);
+}
+
+void VTServer::getServerStats(const vti::getServerStatsRequest &, ::rpcz::reply<vti::getServerStatsResponse> response)
+{
+    // no database access, answered directly
+    vti::getServerStatsResponse reply;
+    vti::requestResult *res = new vti::requestResult();
+    res->set_success(true);
+    reply.set_allocated_res(res);
+
+    ResponseCache::Counters counters = _cache.counters();
+    vti::cacheStats *cache = new vti::cacheStats();
+    cache->set_hits(counters.hits);
+    cache->set_misses(counters.misses);
+    cache->set_entries(counters.entries);
+    cache->set_bytes(counters.bytes);
+    cache->set_max_bytes(counters.max_bytes);
+    cache->set_evictions(counters.evictions);
+    cache->set_invalidations(counters.invalidations);
+    reply.set_allocated_cache(cache);
+
+    response.send(reply);
 }
 
 
@@ -8,13 +8,13 @@
 
 #include "worker.h"
 #include "interproc.h"
+#include "connpool.h"
+#include "executor.h"
+#include "responsecache.h"
+#include "spatialindex.h"
+#include "descriptorindex.h"
 #include <vtapi/vtapi.h>
 #include "vtserver_interface.rpcz.h"
-#include <vector>
-#include <map>
-#include <memory>
-#include <mutex>
-#include <thread>
 
 namespace vtserver {
 
@@ -22,7 +22,10 @@ namespace vtserver {
  class VTServer : public vtserver_interface::VTServerInterface
  {
  public:
-    VTServer(const vtapi::VTApi &vtapi);
+    VTServer(const vtapi::VTApi &vtapi, unsigned int pool_size, unsigned int pool_timeout_ms,
+             unsigned int workers, unsigned int heavy_workers, unsigned int queue_size,
+             size_t cache_bytes, size_t index_bytes, size_t descindex_bytes,
+             unsigned int sequence_threads);
 
     // VTServerInterface interface
 
@@ -47,16 +50,29 @@ namespace vtserver {
     void getEventDescriptor(const vtserver_interface::getEventDescriptorRequest &request, ::rpcz::reply<vtserver_interface::getEventDescriptorResponse> response);
     void getEventList(const vtserver_interface::getEventListRequest &request, ::rpcz::reply<vtserver_interface::getEventListResponse> response);
     void getEventsStats(const vtserver_interface::getEventsStatsRequest &request, ::rpcz::reply<vtserver_interface::getEventsStatsResponse> response);
+    void getTrajectoriesInWindow(const vtserver_interface::getTrajectoriesInWindowRequest &request, ::rpcz::reply<vtserver_interface::getTrajectoriesInWindowResponse> response);
+    void getSimilarEvents(const vtserver_interface::getSimilarEventsRequest &request, ::rpcz::reply<vtserver_interface::getSimilarEventsResponse> response);
     void getProcessingMetadata(const vtserver_interface::getProcessingMetadataRequest &request, ::rpcz::reply<vtserver_interface::getProcessingMetadataResponse> response);
+    void getServerStats(const vtserver_interface::getServerStatsRequest &request, ::rpcz::reply<vtserver_interface::getServerStatsResponse> response);
 
 private:
-    std::mutex _mtx_threads;
-    std::map<std::thread::id,int> _thread_indexes;
-    std::vector< std::shared_ptr<vtapi::VTApi> > _connections;
+    ConnectionPool _pool;
+    ResponseCache _cache;   // before interproc, which invalidates it
+    SpatialIndexStore _indexes;
+    DescriptorIndexStore _descriptors;
     Interproc _interproc;
+    EventCursorStore _cursors;
+    const unsigned int _sequence_threads;
+    Executor _executor;     // must be last, finishes queued jobs on destruction
+
+    template<class REQUEST_T, class RESPONSE_T>
+    void submitRequest(Executor::Lane lane, const REQUEST_T & request, RESPONSE_T & reply);
 
     template<class REQUEST_T, class RESPONSE_T>
     bool processRequest(REQUEST_T & request, RESPONSE_T & reply);
+
+    template<class REQUEST_T, class MESSAGE_T>
+    bool replyFromCache(const REQUEST_T & request, ::rpcz::reply<MESSAGE_T> & response);
  };
 
 
@@ -11,8 +11,13 @@
 //#include "vtapi/common/logger.h"
 #include "worker.h"
 #include "sequencestats.h"
+#include "intervalsweep.h"
+#include "seqpartition.h"
+#include <vtapi/common/defs.h>
 #include <list>
 #include <map>
+#include <algorithm>
+#include <cmath>
 #include <Poco/Path.h>
 #include <Poco/File.h>
 #include <Poco/Exception.h>
@@ -182,10 +187,279 @@ void WorkerJobBase::parseFilter(const vtserver_interface::eventFilter &filter, v
 }
 
 
+// ordered names and lengths of requested sequences (all if none requested)
+static void loadSequenceLengths(Dataset &ds, const vector<string> &seqnames,
+                                vector<string> &names, map<string,unsigned int> &lengths)
+{
+    Sequence *seqs = seqnames.empty() ? ds.loadSequences() : ds.loadSequences(seqnames);
+    while (seqs->next()) {
+        names.push_back(seqs->getName());
+        lengths[names.back()] = seqs->getLength();
+    }
+    delete seqs;
+}
+
+// statistics of sequences (bitmap and/or details) calculated from all their events
+// coverage of sequences by events of task
+static bool loadCoverage(Task &ts, const vector<string> &seqnames, const EventFilter *filter,
+                         map<string,SequenceStats> &stats)
+{
+    unique_ptr<Interval> outdata(ts.loadOutputData());
+    outdata->filterBySequences(seqnames);
+    if (filter)
+        outdata->filterByEvent("event", ts.getName(), seqnames, *filter);
+
+    outdata->setStreaming(true);
+    while (outdata->nextPage()) {
+        vector<string> page_seqnames = outdata->getStringColumn(def_col_int_seqname);
+        vector<int> page_t1 = outdata->getIntColumn(def_col_int_t1);
+        vector<int> page_t2 = outdata->getIntColumn(def_col_int_t2);
+        vector<IntervalEvent> page_events = outdata->getIntervalEventColumn("event");
+
+        auto item = stats.end();
+        for (size_t i = 0; i < page_events.size(); i++) {
+            if (item == stats.end() || item->first != page_seqnames[i])
+                item = stats.find(page_seqnames[i]);
+            if (item != stats.end())
+                item->second.processEvent(page_t1[i], page_t2[i], page_events[i]);
+        }
+    }
+
+    return true;
+}
+
+static bool loadEventsStats(VTApi &vtapi, const vti::getEventsStatsRequest &request,
+                            const vector<string> &seqnames, const map<string,unsigned int> &lengths,
+                            const EventFilter *filter, vti::getEventsStatsResponse &reply)
+{
+    bool get_bitmap = request.get_bitmap();
+    bool get_details = request.get_details();
+
+    unique_ptr<Dataset> ds(vtapi.loadDatasets(request.dataset_id()));
+    if (!ds->next())
+        return false;
+    unique_ptr<Task> ts(ds->loadTasks(request.task_id()));
+    if (!ts->next())
+        return false;
+
+    // map sequences to their stats
+    struct seq_item
+    {
+        vti::eventStats* stats_out;
+        SequenceStats stats_int;
+        IntervalSweep stats_sweep;
+    };
+    map<string,seq_item> seqs_map;
+
+    // initialize stats structures for all sequences (in order)
+    for (const auto & seqname : seqnames) {
+        unsigned int length = lengths.at(seqname);
+        seq_item item = { reply.add_stats(),
+                          SequenceStats(get_bitmap ? length : 0),
+                          IntervalSweep(length) };
+        seqs_map.insert(make_pair(seqname, std::move(item)));
+    }
+
+    // load intervals of sequences, apply filters
+    unique_ptr<Interval> outdata(ts->loadOutputData());
+    outdata->filterBySequences(seqnames);
+    if (filter)
+        outdata->filterByEvent("event", request.task_id(), seqnames, *filter);
+
+    // iterate over pages of events, stream them in chunks to keep
+    // memory bounded and decode needed columns at once
+    outdata->setStreaming(true);
+    while (outdata->nextPage()) {
+        vector<string> page_seqnames = outdata->getStringColumn(def_col_int_seqname);
+        vector<int> page_t1 = outdata->getIntColumn(def_col_int_t1);
+        vector<int> page_t2 = outdata->getIntColumn(def_col_int_t2);
+        vector<IntervalEvent> page_events = outdata->getIntervalEventColumn("event");
+
+        auto item = seqs_map.end();
+        for (size_t i = 0; i < page_events.size(); i++) {
+            // events of one sequence usually follow each other
+            if (item == seqs_map.end() || item->first != page_seqnames[i])
+                item = seqs_map.find(page_seqnames[i]);
+            // all sequences should have stats prepared
+            if (item == seqs_map.end())
+                continue;
+            if (get_bitmap)
+                item->second.stats_int.processEvent(page_t1[i], page_t2[i], page_events[i]);
+            if (get_details)
+                item->second.stats_sweep.processEvent(page_t1[i], page_t2[i], page_events[i]);
+        }
+    }
+
+    // coverage of other tasks is united or intersected with coverage of the task
+    bool combine = get_bitmap && request.combine_task_ids_size() > 0;
+    for (int t = 0; combine && t < request.combine_task_ids_size(); t++) {
+        unique_ptr<Task> other(ds->loadTasks(request.combine_task_ids(t)));
+        if (!other->next())
+            return false;
+
+        map<string,SequenceStats> other_stats;
+        for (const auto & seqname : seqnames)
+            other_stats.insert(make_pair(seqname, SequenceStats(lengths.at(seqname))));
+        if (!loadCoverage(*other, seqnames, filter, other_stats))
+            return false;
+
+        for (auto & item : seqs_map) {
+            if (request.combine_intersect())
+                item.second.stats_int.intersect(other_stats.at(item.first));
+            else
+                item.second.stats_int.unite(other_stats.at(item.first));
+        }
+    }
+
+    // fill stats
+    for (auto & item : seqs_map) {
+        vti::eventStats *stats_out = item.second.stats_out;
+        stats_out->set_sequence_id(item.first);
+
+        if (get_details) {
+            const IntervalSweep & sweep = item.second.stats_sweep;
+            IntervalSweep::Result result = sweep.calculate();
+            double to_part = sweep.length() > 0 ? 1.0 / sweep.length() : 0.0;
+
+            stats_out->set_count(sweep.count_root());
+            stats_out->set_coverage(sweep.calculateCoverage(result));
+            for (const auto & cls : result.class_covered) {
+                vti::classCoverage *cov = stats_out->add_class_coverage();
+                cov->set_class_id(cls.first);
+                cov->set_coverage(cls.second * to_part);
+            }
+            for (const auto & ovl : result.class_overlap) {
+                vti::classOverlap *overlap = stats_out->add_class_overlap();
+                overlap->set_class_id1(ovl.first.first);
+                overlap->set_class_id2(ovl.first.second);
+                overlap->set_overlap(ovl.second * to_part);
+            }
+            for (unsigned int frames : result.concurrency)
+                stats_out->add_concurrency_histogram(frames);
+            for (const auto & gap : result.gaps) {
+                vti::frameRange *range = stats_out->add_gaps();
+                range->set_t1(gap.first);
+                range->set_t2(gap.second);
+            }
+        }
+        else {
+            stats_out->set_count(item.second.stats_int.count_root());
+            stats_out->set_coverage(item.second.stats_int.calculateCoverage());
+        }
+
+        if (combine)
+            stats_out->set_coverage(item.second.stats_int.calculateCoverage());
+        if (get_bitmap)
+            stats_out->set_coverage_bitmap(item.second.stats_int.bitmap());
+    }
+
+    return true;
+}
+
+// spatio-temporal indexes of sequences built from all their events
+static bool loadTrajectoryIndexes(VTApi &vtapi, const string &dsname, const string &taskname,
+                                  const vector<string> &seqnames,
+                                  map<string, shared_ptr<const TrajectoryIndex> > &indexes)
+{
+    unique_ptr<Dataset> ds(vtapi.loadDatasets(dsname));
+    if (!ds->next())
+        return false;
+    unique_ptr<Task> ts(ds->loadTasks(taskname));
+    if (!ts->next())
+        return false;
+
+    // builders for all sequences, so that sequences without events get empty index
+    map<string,TrajectoryIndex::Builder> builders;
+    for (const auto & seqname : seqnames)
+        builders[seqname];
+
+    unique_ptr<Interval> outdata(ts->loadOutputData());
+    outdata->filterBySequences(seqnames);
+
+    outdata->setStreaming(true);
+    while (outdata->nextPage()) {
+        vector<string> page_seqnames = outdata->getStringColumn(def_col_int_seqname);
+        vector<int> page_ids = outdata->getIntColumn(def_col_int_id);
+        vector<int> page_t1 = outdata->getIntColumn(def_col_int_t1);
+        vector<int> page_t2 = outdata->getIntColumn(def_col_int_t2);
+        vector<double> page_lengths = outdata->getFloat8Column(def_col_int_seclength);
+        vector<chrono::system_clock::time_point> page_starts = outdata->getTimestampColumn(def_col_int_rtstart);
+        vector<IntervalEvent> page_events = outdata->getIntervalEventColumn("event");
+
+        auto item = builders.end();
+        for (size_t i = 0; i < page_events.size(); i++) {
+            // events of one sequence usually follow each other
+            if (item == builders.end() || item->first != page_seqnames[i])
+                item = builders.find(page_seqnames[i]);
+            if (item == builders.end())
+                continue;
+            item->second.addEvent(page_ids[i], page_t1[i], page_t2[i], page_lengths[i],
+                                  page_starts[i], page_events[i]);
+        }
+    }
+
+    for (auto & item : builders)
+        indexes[item.first] = item.second.build();
+
+    return true;
+}
+
+// descriptor index of task output, kept index is copied and updated by events
+// inserted since it was loaded, unless events were updated or deleted meanwhile
+// (by versions of events in database; without them, only until index expires).
+// Index is not trained here, store trains kept indexes in background.
+static shared_ptr<const DescriptorIndex> loadDescriptorIndex(Task &ts, shared_ptr<const DescriptorIndex> kept,
+                                                             bool current)
+{
+    DescriptorIndex::Versions versions;
+    bool known = ts.getOutputVersions(vector<string>(), versions);
+    for (const auto & item : versions) {
+        if (item.modified < 0) known = false;
+    }
+    if (!known) versions.clear();
+
+    shared_ptr<DescriptorIndex> index;
+    if (kept && known && kept->hasVersions()) {
+        if (kept->isCurrent(versions))
+            return kept;
+        if (kept->isUpdatable(versions))
+            index = make_shared<DescriptorIndex>(*kept);
+    }
+    else if (kept && !known && !kept->hasVersions()) {
+        if (current)
+            return kept;
+        index = make_shared<DescriptorIndex>(*kept);
+    }
+    if (!index)
+        index = make_shared<DescriptorIndex>();
+    index->setVersions(versions);
+
+    unique_ptr<Interval> outdata(ts.loadOutputData());
+    outdata->filterNotNullEdfDescriptor(def_col_int_edfdesc);
+    if (index->events() > 0)
+        outdata->filterByInt(def_col_int_id, index->lastEventId(), ">");
+
+    // intervals are ordered by ID
+    outdata->setStreaming(true);
+    while (outdata->nextPage()) {
+        vector<int> page_ids = outdata->getIntColumn(def_col_int_id);
+        vector<string> page_seqnames = outdata->getStringColumn(def_col_int_seqname);
+        vector<EyedeaEdfDescriptor> page_descs = outdata->getEdfDescriptorColumn(def_col_int_edfdesc);
+
+        for (size_t i = 0; i < page_descs.size(); i++)
+            index->addEvent(page_ids[i], page_seqnames[i], page_descs[i]);
+    }
+
+    return index;
+}
+
+
 ///////////////////////////////////////////////////////////////////////
 //                   RPC methods implementation                      //
 ///////////////////////////////////////////////////////////////////////
 
+#define EVENT_CHUNK_SIZE    1000    // trajectories in chunk, if client doesn't say
+
 #define VTSERVER_PREPARE_REPLY(type, reply, res) \
     type reply;\
     vti::requestResult *res = new vti::requestResult();\
@@ -228,6 +502,7 @@ void WorkerJob<const vti::addDatasetRequest, ::rpcz::reply<vti::addDatasetRespon
         res->set_msg(e.message());
     }
 
+    args._cache.invalidateAll();
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -238,6 +513,7 @@ void WorkerJob<const vti::getDatasetListRequest, ::rpcz::reply<vti::getDatasetLi
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getDatasetListResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -262,6 +538,8 @@ void WorkerJob<const vti::getDatasetListRequest, ::rpcz::reply<vti::getDatasetLi
     }
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, string(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -272,6 +550,7 @@ void WorkerJob<const vti::getDatasetMetricsRequest, ::rpcz::reply<vti::getDatase
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getDatasetMetricsResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -284,16 +563,24 @@ void WorkerJob<const vti::getDatasetMetricsRequest, ::rpcz::reply<vti::getDatase
         metrics->set_dataset_id(ds->getName());
         reply.set_allocated_metrics(metrics);
 
+        // exact counts scan whole tables, estimates are from table statistics
+        KeyValues::CountMode mode = _request.estimate_counts() ?
+            KeyValues::COUNT_ESTIMATE : KeyValues::COUNT_EXACT;
+        bool estimated = false;
+
         Sequence *seq = ds->loadSequences();
-        metrics->set_sequence_count(seq->count());
+        metrics->set_sequence_count(seq->count(mode, &estimated));
+        metrics->set_estimated(estimated);
         delete seq;
 
         Task *ts = ds->loadTasks();
-        metrics->set_task_count(ts->count());
+        metrics->set_task_count(ts->count(mode, &estimated));
+        metrics->set_estimated(metrics->estimated() || estimated);
         delete ts;
 
         Process *prs = ds->loadProcesses();
-        metrics->set_process_count(prs->count());
+        metrics->set_process_count(prs->count(mode, &estimated));
+        metrics->set_estimated(metrics->estimated() || estimated);
         delete prs;
     }
     else {
@@ -303,6 +590,8 @@ void WorkerJob<const vti::getDatasetMetricsRequest, ::rpcz::reply<vti::getDatase
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -338,6 +627,7 @@ void WorkerJob<const vti::deleteDatasetRequest, ::rpcz::reply<vti::deleteDataset
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidateAll();
     _response.send(reply);
 }
 
@@ -456,6 +746,7 @@ void WorkerJob<const vti::addSequenceRequest, ::rpcz::reply<vti::addSequenceResp
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidate(_request.dataset_id());
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -466,6 +757,7 @@ void WorkerJob<const vti::getSequenceIDListRequest, ::rpcz::reply<vti::getSequen
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getSequenceIDListResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -488,6 +780,8 @@ void WorkerJob<const vti::getSequenceIDListRequest, ::rpcz::reply<vti::getSequen
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -498,6 +792,7 @@ void WorkerJob<const vti::getSequenceInfoRequest, ::rpcz::reply<vti::getSequence
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getSequenceInfoResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -558,6 +853,8 @@ void WorkerJob<const vti::getSequenceInfoRequest, ::rpcz::reply<vti::getSequence
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -605,6 +902,7 @@ void WorkerJob<const vti::setSequenceInfoRequest, ::rpcz::reply<vti::setSequence
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidate(_request.dataset_id());
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -650,6 +948,7 @@ void WorkerJob<const vti::deleteSequenceRequest, ::rpcz::reply<vti::deleteSequen
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidate(_request.dataset_id());
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -697,6 +996,7 @@ void WorkerJob<const vti::addTaskRequest, ::rpcz::reply<vti::addTaskResponse> >
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidate(_request.dataset_id());
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -707,6 +1007,7 @@ void WorkerJob<const vti::getTaskIDListRequest, ::rpcz::reply<vti::getTaskIDList
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getTaskIDListResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -729,6 +1030,8 @@ void WorkerJob<const vti::getTaskIDListRequest, ::rpcz::reply<vti::getTaskIDList
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -741,6 +1044,7 @@ void WorkerJob<const vti::getTaskInfoRequest, ::rpcz::reply<vti::getTaskInfoResp
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getTaskInfoResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -802,6 +1106,8 @@ void WorkerJob<const vti::getTaskInfoRequest, ::rpcz::reply<vti::getTaskInfoResp
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -972,6 +1278,7 @@ void WorkerJob<const vti::deleteTaskRequest, ::rpcz::reply<vti::deleteTaskRespon
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidate(_request.dataset_id());
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -1102,9 +1409,12 @@ void WorkerJob<const vti::runProcessRequest, ::rpcz::reply<vti::runProcessRespon
 
             Process *prs = ts->createProcess(seqnames);
             if (prs) {
+                // process rows exist even if instance fails to launch
+                args._cache.invalidate(_request.dataset_id());
+
                 vtapi::InterProcessClient *ipc = prs->launchInstance();
                 if (ipc) {
-                    args._ipc.addClientInstance(ipc);
+                    args._ipc.addClientInstance(ipc, _request.dataset_id());
                     res->set_success(true);
                     reply.set_process_id(toString<int>(prs->getId()));
                 }
@@ -1174,6 +1484,7 @@ void WorkerJob<const vti::stopProcessRequest, ::rpcz::reply<vti::stopProcessResp
     delete ds;
 
     reply.set_allocated_res(res);
+    args._cache.invalidate(_request.dataset_id());
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -1185,6 +1496,7 @@ void WorkerJob<const vti::getEventDescriptorRequest, ::rpcz::reply<vti::getEvent
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getEventDescriptorResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -1225,6 +1537,8 @@ void WorkerJob<const vti::getEventDescriptorRequest, ::rpcz::reply<vti::getEvent
     delete ds;
     
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
@@ -1236,91 +1550,194 @@ void WorkerJob<const vti::getEventListRequest, ::rpcz::reply<vti::getEventListRe
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getEventListResponse reply;
     vti::requestResult *res = new vti::requestResult();
 
+    // chunked request keeps cursor with own connection between requests,
+    // whole list is fetched at once
+    bool chunked = _request.chunk_size() > 0 || _request.has_continuation_token();
+    unique_ptr<EventListCursor> cursor;
+    string error;
+
+    vector<string> seqnames;
+    if (_request.sequence_ids_size() > 0) {
+        seqnames.resize(_request.sequence_ids_size());
+        for (int i = 0; i < _request.sequence_ids_size(); i++)
+            seqnames[i] = _request.sequence_ids(i);
+    }
+
+    EventFilter flt;
+    if (_request.has_filter())
+        parseFilter(_request.filter(), flt);
+
+    if (_request.has_continuation_token()) {
+        cursor = args._cursors.take(_request.continuation_token());
+        if (!cursor)
+            error = "Invalid or expired continuation token";
+    }
+    else if (chunked) {
+        cursor.reset(new EventListCursor(args._vtapi, true));
+        if (!cursor->open(_request.dataset_id(), _request.task_id(), seqnames,
+                          _request.has_filter() ? &flt : NULL, error))
+            cursor.reset();
+    }
+    else {
+        // whole list, parts of sequences are fetched in parallel and merged in order
+        unique_ptr<Dataset> ds(args._vtapi.loadDatasets(_request.dataset_id()));
+        if (ds->next()) {
+            vector<string> names;
+            map<string,unsigned int> lengths;
+            loadSequenceLengths(*ds, seqnames, names, lengths);
+
+            map<string,size_t> order;
+            for (size_t i = 0; i < names.size(); i++)
+                order[names[i]] = i;
+
+            SequencePartitioner partitioner(args._pool, args._sequence_threads);
+            vector< vector<string> > parts = partitioner.split(names);
+            vector<vti::getEventListResponse> fragments(parts.size());
+            vector<string> errors(parts.size());
+
+            // empty part or list would load events of all sequences
+            bool ok = names.empty() || partitioner.run(args._vtapi, parts.size(), [&](VTApi &vtapi, size_t part) {
+                if (parts[part].empty())
+                    return true;
+
+                EventListCursor part_cursor(vtapi, false);
+                if (!part_cursor.open(_request.dataset_id(), _request.task_id(), parts[part],
+                                      _request.has_filter() ? &flt : NULL, errors[part]))
+                    return false;
+                part_cursor.fetch(fragments[part], 0);
+
+                // sequences are added as their events come, order them as requested
+                auto *list = fragments[part].mutable_events_list();
+                std::stable_sort(list->pointer_begin(), list->pointer_end(),
+                    [&order](const vti::eventInfoList *a, const vti::eventInfoList *b) {
+                        return order.at(a->sequence_id()) < order.at(b->sequence_id());
+                    });
+                return true;
+            });
+
+            if (ok) {
+                res->set_success(true);
+                for (auto & fragment : fragments)
+                    SequencePartitioner::append(reply.mutable_events_list(), fragment.mutable_events_list());
+            }
+            else {
+                error = "Failed to load events";
+                for (const auto & part_error : errors) {
+                    if (!part_error.empty()) {
+                        error = part_error;
+                        break;
+                    }
+                }
+                res->set_success(false);
+                res->set_msg(error);
+            }
+        }
+        else {
+            res->set_success(false);
+            res->set_msg("Cannot find dataset");
+        }
+    }
+
+    if (chunked) {
+        if (cursor) {
+            res->set_success(true);
+
+            unsigned int chunk_size = _request.chunk_size() > 0 ? _request.chunk_size() : EVENT_CHUNK_SIZE;
+            bool more = cursor->fetch(reply, chunk_size);
+            if (more) {
+                string token = args._cursors.put(std::move(cursor), _request.continuation_token());
+                reply.set_continuation_token(token);
+            }
+        }
+        else {
+            res->set_success(false);
+            res->set_msg(error);
+        }
+    }
+
+    reply.set_allocated_res(res);
+    if (res->success() && !chunked)
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
+    _response.send(reply);
+
+    VTSERVER_DEBUG_REPLY;
+}
+
+template<>
+void WorkerJob<const vti::getEventsStatsRequest, ::rpcz::reply<vti::getEventsStatsResponse> >
+::process(Args & args)
+{
+    VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
+
+    vti::getEventsStatsResponse reply;
+    vti::requestResult *res = new vti::requestResult();
+
     Dataset *ds = args._vtapi.loadDatasets(_request.dataset_id());
     if (ds->next()) {
         Task *ts =  ds->loadTasks(_request.task_id());
         if (ts->next()) {
             res->set_success(true);
 
-            // map added sequences to their infos
-            map<string,vti::eventInfoList*> seq_infos;
-            // map trajectories to their events
-            map<int,vti::eventInfo*> trajectories;
-
-            // load intervals, possibly filter by sequences
-            Interval *outdata = ts->loadOutputData();
             vector<string> seqnames;
             if (_request.sequence_ids_size() > 0) {
                 seqnames.resize(_request.sequence_ids_size());
                 for (int i = 0; i < _request.sequence_ids_size(); i++)
                     seqnames[i] = _request.sequence_ids(i);
-                outdata->filterBySequences(seqnames);
             }
 
-            // apply filters
-            if (_request.has_filter()) {
-                EventFilter flt;
+            EventFilter flt;
+            if (_request.has_filter())
                 parseFilter(_request.filter(), flt);
-                outdata->filterByEvent("event", _request.task_id(), seqnames, flt);
-            }
 
-            // iterate over events
-            while (outdata->next()) {
-                // get sequence info
-                vti::eventInfoList *info;
-                string seqname = outdata->getParentSequenceName();
-                auto it = seq_infos.find(seqname);
-                if (it == seq_infos.end()) {
-                    info = reply.add_events_list();
-                    info->set_sequence_id(seqname);
-                    seq_infos.insert(std::make_pair(seqname,info));
+            // coverage bitmap and details are built here from all events,
+            // otherwise only aggregated stats per sequence are computed in database
+            if (_request.get_bitmap() || _request.get_details()) {
+                vector<string> names;
+                map<string,unsigned int> lengths;
+                loadSequenceLengths(*ds, seqnames, names, lengths);
+
+                // parts of sequences are processed in parallel and merged in order
+                SequencePartitioner partitioner(args._pool, args._sequence_threads);
+                vector< vector<string> > parts = partitioner.split(names);
+                vector<vti::getEventsStatsResponse> fragments(parts.size());
+
+                bool ok = partitioner.run(args._vtapi, parts.size(), [&](VTApi &vtapi, size_t part) {
+                    return parts[part].empty() ||
+                        loadEventsStats(vtapi, _request, parts[part], lengths,
+                                        _request.has_filter() ? &flt : NULL, fragments[part]);
+                });
+
+                if (ok) {
+                    for (auto & fragment : fragments)
+                        SequencePartitioner::append(reply.mutable_stats(), fragment.mutable_stats());
                 }
                 else {
-                    info = (*it).second;
+                    res->set_success(false);
+                    res->set_msg("Failed to calculate statistics");
                 }
-
-                // get output event
-                IntervalEvent ev = outdata->getIntervalEvent("event");
-                int t1 = outdata->getStartTime();
-                int t2 = outdata->getEndTime();
-                double to_sec = t2+1 > t1 ? (outdata->getLengthSeconds() / ((t2+1) - t1)) : 0;
-
-                // add new trajectory root (or non-trajectory event)
-                if (ev.is_root) {
-                    if (trajectories.find(ev.group_id) == trajectories.end()) {
-                        vti::eventInfo *traj = info->add_events();
-                        trajectories.insert(std::make_pair(ev.group_id, traj));
-                        traj->set_event_id(outdata->getId());
-                        traj->set_group_id(ev.group_id);
-                        traj->set_class_id(ev.class_id);
-                        traj->set_score(ev.score);
-                        traj->set_t1(t1);
-                        traj->set_t2(t2);
-                        traj->set_t1_sec(t1*to_sec);
-                        traj->set_t2_sec((t2+1)*to_sec);
-                        std::string user_data(ev.user_data.data(), ev.user_data.size());
-                        traj->set_user_data(user_data);
+            }
+            else {
+                vector<QueryEventsStats::Stats> stats;
+                if (ts->getOutputStats("event", seqnames, _request.has_filter() ? &flt : NULL, stats)) {
+                    for (const auto & item : stats) {
+                        vti::eventStats *stats_out = reply.add_stats();
+                        stats_out->set_sequence_id(item.seqname);
+                        stats_out->set_count(item.count_root);
+                        stats_out->set_coverage(item.length > 0 ?
+                            static_cast<double>(item.covered) / item.length : 0.0);
                     }
                 }
-                // add event to existing trajectory
                 else {
-                    auto it = trajectories.find(ev.group_id);
-                    if (it != trajectories.end()) {
-                        vti::Region *reg = it->second->add_regions();
-                        reg->set_t(t1);
-                        reg->set_t_sec(t1*to_sec);
-                        reg->set_x1(ev.region.high.x);
-                        reg->set_x2(ev.region.low.x);
-                        reg->set_y1(ev.region.high.y);
-                        reg->set_y2(ev.region.low.y);
-                    }
+                    res->set_success(false);
+                    res->set_msg("Failed to calculate statistics");
                 }
             }
-            delete outdata;
         }
         else {
             res->set_success(false);
@@ -1335,18 +1752,21 @@ void WorkerJob<const vti::getEventListRequest, ::rpcz::reply<vti::getEventListRe
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
 }
 
 template<>
-void WorkerJob<const vti::getEventsStatsRequest, ::rpcz::reply<vti::getEventsStatsResponse> >
+void WorkerJob<const vti::getTrajectoriesInWindowRequest, ::rpcz::reply<vti::getTrajectoriesInWindowResponse> >
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t version = args._indexes.version(_request.dataset_id());
 
-    vti::getEventsStatsResponse reply;
+    vti::getTrajectoriesInWindowResponse reply;
     vti::requestResult *res = new vti::requestResult();
 
     Dataset *ds = args._vtapi.loadDatasets(_request.dataset_id());
@@ -1355,61 +1775,201 @@ void WorkerJob<const vti::getEventsStatsRequest, ::rpcz::reply<vti::getEventsSta
         if (ts->next()) {
             res->set_success(true);
 
-            // load intervals, possibly filter by sequences
-            Interval *outdata = ts->loadOutputData();
-            Sequence *seqs = NULL;
             vector<string> seqnames;
             if (_request.sequence_ids_size() > 0) {
                 seqnames.resize(_request.sequence_ids_size());
                 for (int i = 0; i < _request.sequence_ids_size(); i++)
                     seqnames[i] = _request.sequence_ids(i);
-                outdata->filterBySequences(seqnames);
-                seqs = ds->loadSequences(seqnames);
             }
-            else {
-                seqs = ds->loadSequences();
+
+            vector<string> names;
+            map<string,unsigned int> lengths;
+            loadSequenceLengths(*ds, seqnames, names, lengths);
+
+            // versions of events in database tell if kept indexes are outdated
+            // (read before events are loaded, unknown without statistics)
+            map<string,QueryEventsVersions::Version> versions;
+            for (const auto & name : names) {
+                QueryEventsVersions::Version & item = versions[name];
+                item.seqname = name;
+                item.modified = item.changed = item.count_all = -1;
+            }
+            vector<QueryEventsVersions::Version> loaded;
+            if (!names.empty() && ts->getOutputVersions(names, loaded)) {
+                for (const auto & item : loaded) {
+                    auto it = versions.find(item.seqname);
+                    if (it != versions.end())
+                        it->second = item;
+                }
             }
 
-            // map added sequences to their stats
-            struct seq_item
-            {
-                vti::eventStats* stats_out;
-                SequenceStats stats_int;
-            };
-            map<string,seq_item> seqs_map;
+            // kept indexes are used, missing ones are built from events
+            // (parts of sequences in parallel) and kept for next requests
+            map<string, shared_ptr<const TrajectoryIndex> > indexes;
+            vector<string> missing;
+            for (const auto & name : names) {
+                bool too_large = false;
+                shared_ptr<const TrajectoryIndex> index =
+                    args._indexes.get(_request.dataset_id(), _request.task_id(), versions[name], too_large);
+                if (too_large) {
+                    res->set_success(false);
+                    res->set_msg("Too many events in sequence " + name + " for spatial index");
+                    break;
+                }
+                else if (index) {
+                    indexes[name] = index;
+                }
+                else {
+                    missing.push_back(name);
+                }
+            }
 
-            // initialize stats structures for all sequences
-            while (seqs->next()) {
-                seq_item item = { reply.add_stats(), SequenceStats(seqs->getLength()) };
-                seqs_map.insert(make_pair(seqs->getName(), std::move(item)));
+            if (res->success() && !missing.empty()) {
+                SequencePartitioner partitioner(args._pool, args._sequence_threads);
+                vector< vector<string> > parts = partitioner.split(missing);
+                vector< map<string, shared_ptr<const TrajectoryIndex> > > fragments(parts.size());
+
+                bool ok = partitioner.run(args._vtapi, parts.size(), [&](VTApi &vtapi, size_t part) {
+                    return parts[part].empty() ||
+                        loadTrajectoryIndexes(vtapi, _request.dataset_id(), _request.task_id(),
+                                              parts[part], fragments[part]);
+                });
+
+                if (ok) {
+                    for (auto & fragment : fragments) {
+                        for (auto & item : fragment) {
+                            if (!args._indexes.put(_request.dataset_id(), _request.task_id(),
+                                                   versions[item.first], item.second, version)) {
+                                res->set_success(false);
+                                res->set_msg("Too many events in sequence " + item.first + " for spatial index");
+                            }
+                            indexes.insert(item);
+                        }
+                    }
+                }
+                else {
+                    res->set_success(false);
+                    res->set_msg("Failed to build spatial index");
+                }
             }
-            delete seqs;
 
-            // apply filters
-            if (_request.has_filter()) {
+            // filter is evaluated over events kept in indexes
+            unique_ptr<EventBatchFilter> filter;
+            if (res->success() && _request.has_filter()) {
                 EventFilter flt;
                 parseFilter(_request.filter(), flt);
-                outdata->filterByEvent("event", _request.task_id(), seqnames, flt);
+                try {
+                    filter.reset(new EventBatchFilter(flt));
+                }
+                catch (vtapi::Exception & e) {
+                    res->set_success(false);
+                    res->set_msg(e.message());
+                }
             }
 
-            // iterate over events
-            while (outdata->next()) {
-                auto item = seqs_map.find(outdata->getParentSequenceName());
-                // all sequences should have stats prepared
-                if (item != seqs_map.end()) {
-                    item->second.stats_int.processEvent(outdata->getStartTime(),
-                                                        outdata->getEndTime(),
-                                                        outdata->getIntervalEvent("event"));
-
+            if (res->success()) {
+                const vti::Region & region = _request.region();
+                double low[3] = { std::min(region.x1(), region.x2()),
+                                  std::min(region.y1(), region.y2()),
+                                  static_cast<double>(_request.frames().t1()) };
+                double high[3] = { std::max(region.x1(), region.x2()),
+                                   std::max(region.y1(), region.y2()),
+                                   static_cast<double>(_request.frames().t2()) };
+
+                // trajectories of sequences (in order)
+                for (const auto & name : names) {
+                    auto it = indexes.find(name);
+                    if (it == indexes.end())
+                        continue;
+
+                    vector<const TrajectoryIndex::Trajectory*> trajs = it->second->query(low, high, filter.get());
+                    if (trajs.empty())
+                        continue;
+
+                    vti::eventInfoList *info = reply.add_events_list();
+                    info->set_sequence_id(name);
+                    for (const auto *traj : trajs) {
+                        double to_sec = traj->t2+1 > traj->t1 ? (traj->length / ((traj->t2+1) - traj->t1)) : 0;
+
+                        vti::eventInfo *einfo = info->add_events();
+                        einfo->set_event_id(traj->event_id);
+                        einfo->set_group_id(traj->group_id);
+                        einfo->set_class_id(traj->class_id);
+                        einfo->set_score(traj->score);
+                        einfo->set_t1(traj->t1);
+                        einfo->set_t2(traj->t2);
+                        einfo->set_t1_sec(traj->t1*to_sec);
+                        einfo->set_t2_sec((traj->t2+1)*to_sec);
+                        einfo->set_length(traj->length);
+                    }
                 }
             }
-            delete outdata;
+        }
+        else {
+            res->set_success(false);
+            res->set_msg("Cannot find task");
+        }
+        delete ts;
+    }
+    else {
+        res->set_success(false);
+        res->set_msg("Cannot find dataset");
+    }
+    delete ds;
+
+    reply.set_allocated_res(res);
+    _response.send(reply);
+
+    VTSERVER_DEBUG_REPLY;
+}
+
+
+template<>
+void WorkerJob<const vti::getSimilarEventsRequest, ::rpcz::reply<vti::getSimilarEventsResponse> >
+::process(Args & args)
+{
+    VTSERVER_DEBUG_REQUEST;
+    uint64_t version = args._descriptors.version(_request.dataset_id());
+
+    vti::getSimilarEventsResponse reply;
+    vti::requestResult *res = new vti::requestResult();
 
-            // fill stats
-            for (auto item : seqs_map) {
-                item.second.stats_out->set_sequence_id(item.first);
-                item.second.stats_out->set_count(item.second.stats_int.count_root());
-                item.second.stats_out->set_coverage(item.second.stats_int.calculateCoverage());
+    Dataset *ds = args._vtapi.loadDatasets(_request.dataset_id());
+    if (ds->next()) {
+        Task *ts =  ds->loadTasks(_request.task_id());
+        if (ts->next()) {
+            EyedeaEdfDescriptor desc;
+            desc.version = _request.desc_version();
+            desc.data.resize(_request.desc_data_size());
+            bool valid = true;
+            for (int i = 0; i < _request.desc_data_size(); i++) {
+                if (_request.desc_data(i) < 0 || _request.desc_data(i) > 255)
+                    valid = false;
+                desc.data[i] = static_cast<unsigned char>(_request.desc_data(i));
+            }
+
+            if (valid) {
+                res->set_success(true);
+
+                // kept index is used, outdated one is updated by new events
+                bool current = false;
+                shared_ptr<const DescriptorIndex> kept =
+                    args._descriptors.get(_request.dataset_id(), _request.task_id(), current);
+                shared_ptr<const DescriptorIndex> index = loadDescriptorIndex(*ts, kept, current);
+                if (index != kept)
+                    args._descriptors.put(_request.dataset_id(), _request.task_id(), index, version);
+
+                vector<EdfDescriptorIndex::Neighbor> neighbors = index->search(desc, _request.k(), _request.exact());
+                for (const auto & neighbor : neighbors) {
+                    vti::similarEvent *event = reply.add_events();
+                    event->set_sequence_id(index->sequence(neighbor.event_id));
+                    event->set_event_id(neighbor.event_id);
+                    event->set_distance(std::sqrt(static_cast<double>(neighbor.distance)));
+                }
+            }
+            else {
+                res->set_success(false);
+                res->set_msg("Descriptor values must be in range 0-255");
             }
         }
         else {
@@ -1430,11 +1990,13 @@ void WorkerJob<const vti::getEventsStatsRequest, ::rpcz::reply<vti::getEventsSta
     VTSERVER_DEBUG_REPLY;
 }
 
+
 template<>
 void WorkerJob<const vti::getProcessingMetadataRequest, ::rpcz::reply<vti::getProcessingMetadataResponse> >
 ::process(Args & args)
 {
     VTSERVER_DEBUG_REQUEST;
+    uint64_t generation = args._cache.generation();
 
     vti::getProcessingMetadataResponse reply;
     vti::requestResult *res = new vti::requestResult();
@@ -1450,35 +2012,28 @@ void WorkerJob<const vti::getProcessingMetadataRequest, ::rpcz::reply<vti::getPr
             // class ID occurrences sums
             map<int,double> sum_occurences;
 
-            // load class ID occurrences for all sequences
-            Interval *outdata = ts->loadOutputData();
+            // class ID occurrences are summed in database
+            // (read from statistics maintained by trigger, if available)
             vector<string> seqnames;
             if (_request.sequence_ids_size() > 0) {
                 seqnames.resize(_request.sequence_ids_size());
                 for (int i = 0; i < _request.sequence_ids_size(); i++)
                     seqnames[i] = _request.sequence_ids(i);
-                outdata->filterBySequences(seqnames);
             }
 
-            // iterate over class ID records
-            while (outdata->next()) {
-                int class_id = outdata->getInt("out_class_id");
-                double occur = outdata->getFloat8("out_occurrence");
+            if (ts->getOutputClassOccurrences(seqnames, sum_occurences)) {
                 // class_id -1 is special value - keyframe count
-                if (class_id == -1) {
-                    total_keyframe_count += static_cast<unsigned int>(occur);
-                }
-                else {
-                    auto it = sum_occurences.find(class_id);
-                    if (it != sum_occurences.end()) {
-                        it->second += occur;
-                    }
-                    else {
-                        sum_occurences[class_id] = occur;
-                    }
+                auto itkey = sum_occurences.find(-1);
+                if (itkey != sum_occurences.end()) {
+                    total_keyframe_count = static_cast<unsigned int>(itkey->second);
+                    sum_occurences.erase(itkey);
                 }
             }
-            delete outdata;
+            else {
+                res->set_success(false);
+                res->set_msg("Cannot load class occurrences");
+                sum_occurences.clear();
+            }
 
             // total occurrence rate of classes
             class class_occurrence
@@ -1525,6 +2080,8 @@ void WorkerJob<const vti::getProcessingMetadataRequest, ::rpcz::reply<vti::getPr
     delete ds;
 
     reply.set_allocated_res(res);
+    if (res->success())
+        args._cache.put(_request, _request.dataset_id(), reply, generation);
     _response.send(reply);
 
     VTSERVER_DEBUG_REPLY;
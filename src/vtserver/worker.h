@@ -1,6 +1,11 @@
 #pragma once
 
 #include "interproc.h"
+#include "eventcursor.h"
+#include "responsecache.h"
+#include "spatialindex.h"
+#include "descriptorindex.h"
+#include "connpool.h"
 #include <vtapi/vtapi.h>
 #include "vtserver_interface.rpcz.h"
 #include <thread>
@@ -21,9 +26,18 @@ public:
     public:
         vtapi::VTApi & _vtapi;
         Interproc & _ipc;
+        EventCursorStore & _cursors;
+        ResponseCache & _cache;
+        SpatialIndexStore & _indexes;       // spatio-temporal indexes of task outputs
+        DescriptorIndexStore & _descriptors;    // vector indexes of descriptors of task outputs
+        ConnectionPool & _pool;             // extra connections for parallel processing
+        unsigned int _sequence_threads;     // max. threads processing sequences of one request
 
-        Args(vtapi::VTApi & vtapi, Interproc & ipc)
-            : _vtapi(vtapi), _ipc(ipc) {}
+        Args(vtapi::VTApi & vtapi, Interproc & ipc, EventCursorStore & cursors, ResponseCache & cache,
+             SpatialIndexStore & indexes, DescriptorIndexStore & descriptors,
+             ConnectionPool & pool, unsigned int sequence_threads)
+            : _vtapi(vtapi), _ipc(ipc), _cursors(cursors), _cache(cache), _indexes(indexes),
+              _descriptors(descriptors), _pool(pool), _sequence_threads(sequence_threads) {}
     };
 
 public: